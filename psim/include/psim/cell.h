@@ -7,66 +7,125 @@
 
 class Phonon;
 
-// TODO - Inherit from Geometry::Triangle? Composition seems best for Sensor but requires a lot of forwarding
+// TODO - Inherit from Geometry::Polygon? Composition seems best for Sensor but requires a lot of forwarding
+// A convex polygonal cell with one composite boundary surface per edge. Triangles are the most common case.
 class Cell {
 public:
     using Point = Geometry::Point;
     using Line = Geometry::Line;
-    using Triangle = Geometry::Triangle;
-
-    Cell(const Triangle& cell, Sensor& sensor, double spec = 1.);
+    using Polygon = Geometry::Polygon;
+
+    /**
+     * @param cell - The shape of the cell
+     * @param sensor - The sensor the cell contributes to
+     * @param spec - Specularity of the cell's boundary surfaces
+     * @param resource - Source of the memory holding the cell's vertices and surfaces. The model passes its arena
+     * so that all cell data is allocated in a few large blocks that are released together.
+     */
+    Cell(const Polygon& cell,
+        Sensor& sensor,
+        double spec = 1.,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
     [[nodiscard]] const Material& getMaterial() const noexcept {
-        return sensor_.getMaterial();
+        return sensor_->getMaterial();
     }
     [[nodiscard]] std::size_t getMaterialID() const noexcept {
-        return sensor_.getMaterial().id();
+        return sensor_->getMaterial().id();
     }
     [[nodiscard]] std::size_t getSensorID() const noexcept {
-        return sensor_.getID();
+        return sensor_->getID();
+    }
+    [[nodiscard]] bool isDiffusive() const noexcept {
+        return sensor_->isDiffusive();
+    }
+    [[nodiscard]] double getImportance() const noexcept {
+        return sensor_->getImportance();
+    }
+    [[nodiscard]] double getHeatCapacity() const noexcept {
+        return sensor_->getHeatCapacity();
     }
     [[nodiscard]] double getHeatCapacityAtFreq(std::size_t freq_index) const noexcept {
-        return sensor_.getHeatCapacityAtFreq(freq_index);
+        return sensor_->getHeatCapacityAtFreq(freq_index);
     }
     [[nodiscard]] double getArea() const noexcept {
         return cell_.area();
     }
     [[nodiscard]] double getInitTemp() const noexcept {
-        return sensor_.getInitTemp();
+        return sensor_->getInitTemp();
     }
     [[nodiscard]] double getSteadyTemp(std::size_t step = 0) const noexcept {
-        return sensor_.getSteadyTemp(step);
+        return sensor_->getSteadyTemp(step);
     }
     [[nodiscard]] const auto& getBoundaries() const noexcept {
         return boundaries_;
     }
-    [[nodiscard]] std::array<Line, 3> getBoundaryLines() const noexcept;
+    [[nodiscard]] const Polygon& getPolygon() const noexcept {
+        return cell_;
+    }
+    [[nodiscard]] double getSpecularity() const noexcept {
+        return boundaries_[0].getSpecularity();
+    }
+    // The edge is the position of the boundary in getBoundaries(). Used for mirror edges, which are fully specular.
+    void setSpecularity(std::size_t edge, double spec) noexcept {
+        boundaries_[edge].setSpecularity(spec);
+    }
+    [[nodiscard]] std::vector<Line> getBoundaryLines() const;
 
     [[nodiscard]] Point getRandPoint(double r1, double r2) const noexcept {// NOLINT
         return cell_.getRandPoint(r1, r2);
     }
+    [[nodiscard]] Point getCentroid() const noexcept {
+        return cell_.centroid();
+    }
+    [[nodiscard]] Geometry::PointPair getBoundingBox() const noexcept {
+        return cell_.boundingBox();
+    }
 
     // Throws if the incoming cell overlaps, contains or is contained within this cell - both cells cannot coexist
     // in the same model
     void validate(const Cell& other) const;
     [[nodiscard]] bool setEmitSurface(const Line& line, double temp, double duration, double start_time);
+    // Phonons reaching line continue from line translated by offset, which must lie on an edge of target
+    [[nodiscard]] bool setPeriodicSurface(const Line& line, Cell& target, Geometry::Vector2D offset);
+    // True if line fits on an edge of this cell without overlapping its sub-surfaces - throws if it overlaps them
+    [[nodiscard]] bool canAddSurface(const Line& line) const;
 
     [[nodiscard]] double getInitEnergy(double t_eq) const noexcept;
     [[nodiscard]] double getEmitEnergy(double t_eq) const noexcept;
 
-    void initialUpdate(Phonon& p, const Material::Table& table) const noexcept {// NOLINT
-        return sensor_.initialUpdate(p, table);
+    void initialUpdate(Phonon& p, const Material::Table& table, double temp) const noexcept {// NOLINT
+        return sensor_->initialUpdate(p, table, temp);
     }
     void initialUpdate(Phonon& p) const noexcept {
-        return sensor_.initialUpdate(p);// NOLINT
+        return sensor_->initialUpdate(p);// NOLINT
     }
     void scatterUpdate(Phonon& p) const noexcept {
-        return sensor_.scatterUpdate(p);// NOLINT
+        return sensor_->scatterUpdate(p);// NOLINT
     }
     void updateEmitTables() noexcept;
-    void updateHeatParams(const Phonon& p, std::size_t step) const noexcept;// NOLINT
+    void updateHeatParams(const Phonon& p, std::size_t step, double occupancy = 1.) const noexcept;// NOLINT
+    void updateHeatSteps(const Phonon& p, std::size_t first_step, std::size_t last_step) const noexcept {
+        sensor_->updateHeatSteps(p, first_step, last_step);
+    }
+    void addHeatParams(std::size_t step, double energy, const std::array<double, 2>& flux) const noexcept {
+        sensor_->addHeatParams(step, energy, flux);
+    }
     void findTransitionSurface(Cell& other);
-    void handleSurfaceCollision(Phonon& p, const Point& poi, double step_time) const noexcept;// NOLINT
+    // Places transition surfaces on both cells along a line that is known to be a shared edge of both cells
+    void linkTransitionSurface(const Line& line, Cell& other);
+    // The boundary is the position of the impacted surface in getBoundaries()
+    void handleSurfaceCollision(Phonon& p, std::size_t boundary, const Point& poi, double step_time) const noexcept;// NOLINT
+    /**
+     * Updates the cell and sensor links held by this cell and its surfaces after the model has moved its cells
+     * or sensors in memory.
+     * @param cell_map - Callable mapping an old cell address to the new cell address
+     * @param sensor_map - Callable mapping an old sensor address to the new sensor address
+     */
+    template<typename CellMap, typename SensorMap> void relink(CellMap&& cell_map, SensorMap&& sensor_map) noexcept {
+        sensor_ = sensor_map(sensor_);
+        for (auto& boundary : boundaries_) { boundary.relink(cell_map); }
+    }
 
     bool operator==(const Cell& rhs) const;
     bool operator!=(const Cell& rhs) const;
@@ -74,16 +133,17 @@ public:
     friend std::ostream& operator<<(std::ostream& os, const Cell& cell);// NOLINT
 
 private:
-    Triangle cell_;
-    Sensor& sensor_;// hmmm...
+    Polygon cell_;
+    Sensor* sensor_;
 
     // Unused space on each line defaults to a boundary surface and portions of this boundary surface
     // are allocated to different surface types as necessary
-    std::array<CompositeSurface, 3> boundaries_;
+    std::pmr::vector<CompositeSurface> boundaries_;
 
     // std::vector<BoundarySurface> inner_surfaces_; // implement later if req'd
 
-    [[nodiscard]] std::array<CompositeSurface, 3> buildCompositeSurfaces(double spec) noexcept;
+    [[nodiscard]] std::pmr::vector<CompositeSurface> buildCompositeSurfaces(double spec,
+        std::pmr::memory_resource* resource);
     [[nodiscard]] bool setTransitionSurface(const Line& line, Cell& cell);
 };
 
@@ -105,20 +165,20 @@ private:
 
 class IntersectError : public CellError {
 public:
-    IntersectError(const Geometry::Triangle& existing, const Geometry::Triangle& incoming);
+    IntersectError(const Geometry::Polygon& existing, const Geometry::Polygon& incoming);
 
 private:
-    Geometry::Triangle existing_;
-    Geometry::Triangle incoming_;
+    Geometry::Polygon existing_;
+    Geometry::Polygon incoming_;
 };
 
 class OverlapError : public CellError {
 public:
-    OverlapError(const Geometry::Triangle& bigger, const Geometry::Triangle& smaller);
+    OverlapError(const Geometry::Polygon& bigger, const Geometry::Polygon& smaller);
 
 private:
-    Geometry::Triangle bigger_;
-    Geometry::Triangle smaller_;
+    Geometry::Polygon bigger_;
+    Geometry::Polygon smaller_;
 };
 
 
@@ -2,6 +2,7 @@
 #define PSIM_COMPOSITESURFACE_H
 
 #include "surface.h"
+#include <memory_resource>
 
 class Cell;
 class Material;
@@ -12,7 +13,11 @@ public:
     using Point = Geometry::Point;
     using Line = Geometry::Line;
 
-    explicit CompositeSurface(Surface&& main_surface);
+    /**
+     * @param main_surface - The surface spanning the whole edge
+     * @param resource - Source of the memory used for the sub-surfaces
+     */
+    CompositeSurface(Surface&& main_surface, std::pmr::memory_resource* resource);
 
     [[nodiscard]] const Line& getSurfaceLine() const noexcept {
         return main_surface_.getSurfaceLine();
@@ -23,6 +28,19 @@ public:
     [[nodiscard]] const auto& getEmitSurfaces() const noexcept {
         return emit_sub_surfaces_;
     }
+    [[nodiscard]] const auto& getTransitionSurfaces() const noexcept {
+        return transition_sub_surfaces_;
+    }
+    [[nodiscard]] const auto& getPeriodicSurfaces() const noexcept {
+        return periodic_sub_surfaces_;
+    }
+    [[nodiscard]] double getSpecularity() const noexcept {
+        return main_surface_.getSpecularity();
+    }
+    // Only changes the main surface - phonons reaching a part of the edge without a sub-surface
+    void setSpecularity(double spec) noexcept {
+        main_surface_.setSpecularity(spec);
+    }
     void updateEmitSurfaceTables() noexcept;
 
     [[nodiscard]] bool addEmitSurface(const Line&,
@@ -33,18 +51,59 @@ public:
         double duration,
         double start_time);
     [[nodiscard]] bool addTransitionSurface(const Line& surface_line, Cell& cell, int norm_sign);
+    /**
+     * @param surface_line - The location of the periodic surface, must lie on this surface
+     * @param cell - The cell holding the paired surface
+     * @param offset - The translation from surface_line to the paired surface
+     */
+    [[nodiscard]] bool
+        addPeriodicSurface(const Line& surface_line, Cell& cell, int norm_sign, Geometry::Vector2D offset);
+    // Checks a sub-surface could be added at surface_line without adding it - throws on overlapping sub-surfaces
+    [[nodiscard]] bool canAddSurface(const Line& surface_line) const {
+        return verifySurfaceLine(surface_line);
+    }
 
+    /**
+     * Passes the phonon to the sub-surface containing poi or to the main surface if no sub-surface contains it.
+     * The sub-surface is found from the position of poi along the main surface with a binary search.
+     * @param poi - The point of impact, assumed to be on the main surface line
+     */
     void handlePhonon(Phonon& p, const Point& poi, double step_time) const noexcept;// NOLINT
+    /**
+     * Re-targets every surface at the cell returned by cell_map. Used when the model moves its cells in memory.
+     * @param cell_map - Callable mapping the old cell address to the new cell address
+     */
+    template<typename CellMap> void relink(CellMap&& cell_map) noexcept {// NOLINT
+        main_surface_.relink(cell_map(main_surface_.getCell()));
+        for (auto& ts : transition_sub_surfaces_) { ts.relink(cell_map(ts.getCell())); }// NOLINT
+        for (auto& es : emit_sub_surfaces_) { es.relink(cell_map(es.getCell())); }// NOLINT
+        for (auto& ps : periodic_sub_surfaces_) { ps.relink(cell_map(ps.getCell())); }// NOLINT
+    }
 
     friend std::ostream& operator<<(std::ostream& os, const CompositeSurface& surface);// NOLINT
 
 private:
+    // Location of a sub-surface along the main surface - 0 at p1 of the main surface line to 1 at p2
+    enum class SubSurfaceType : unsigned char { Transition, Emit, Periodic };
+    struct SubSurfaceInterval {
+        double start;
+        double end;
+        SubSurfaceType type;
+        std::size_t index;// Position in the sub-surface vector of the given type
+    };
+
     Surface main_surface_;
     // TODO: std::variant<EmitSurface, TransitionSurface> seems like it would be good here
     // Don't see a compelling reason to use a heterogeneous container here.
     // Number of sub-surfaces should not increase in the foreseeable future.
-    std::vector<TransitionSurface> transition_sub_surfaces_;
-    std::vector<EmitSurface> emit_sub_surfaces_;
+    std::pmr::vector<TransitionSurface> transition_sub_surfaces_;
+    std::pmr::vector<EmitSurface> emit_sub_surfaces_;
+    std::pmr::vector<PeriodicSurface> periodic_sub_surfaces_;
+    std::pmr::vector<SubSurfaceInterval> intervals_;// Sorted by start - sub-surfaces never overlap
+    double param_eps_;// GEOEPS along the main surface in parameter units
+
+    [[nodiscard]] double param(const Point& point) const noexcept;
+    void addInterval(const Line& surface_line, SubSurfaceType type, std::size_t index);
     /**
      * Verifies the incoming surface can be placed at the input location.
      * Throws if there is already a transition or emitting surface overlapping the incoming surface location.
@@ -0,0 +1,82 @@
+#ifndef PSIM_DIFFUSIONSOLVER_H
+#define PSIM_DIFFUSIONSOLVER_H
+
+#include "geometry.h"
+#include <span>
+#include <vector>
+
+class Cell;
+
+/**
+ * Finite volume solver of the steady heat equation on the cells of diffusive sensors, used by hybrid simulations
+ * that only run Monte Carlo in the ballistic cells. Each cell holds one temperature and neighbouring cells exchange
+ * heat through their shared edge with a two-point flux (the conductances of the two half cells in series). Emitting
+ * surfaces and interfaces with ballistic cells are black bodies, the interfaces exchanging the heat measured by the
+ * Monte Carlo run, and every other boundary is adiabatic. Temperatures are solved as deviations from t_eq.
+ */
+class DiffusionSolver {
+public:
+    using Point = Geometry::Point;
+    using Line = Geometry::Line;
+
+    // An edge shared by a ballistic cell and a diffusive cell
+    struct Interface {
+        Cell* ballistic;
+        const Cell* diffusive;
+        Line line;
+    };
+
+    /**
+     * Assembles the conduction network of the cells whose sensors are diffusive. The material tables must be
+     * initialized. Throws if a periodic surface leads into or out of a diffusive cell or if a diffusive cell borders a
+     * ballistic cell of another material.
+     */
+    DiffusionSolver(std::vector<Cell>& cells, double t_eq);
+
+    [[nodiscard]] const std::vector<Interface>& getInterfaces() const noexcept {
+        return interfaces_;
+    }
+    /**
+     * Solves for the cell temperatures given the ballistic side of the interfaces. The ballistic region sees each
+     * interface as a black body - it absorbs every phonon reaching it and emits like an emitting surface at the
+     * interface temperature. Some of the emitted phonons return to the interfaces, so the power absorbed depends on
+     * the interface temperatures. It is linearized about the temperatures of the Monte Carlo run with the returned
+     * fraction, which leaves the coupled solution unchanged but speeds up the coupling iterations.
+     * @param absorbed - The power absorbed by each interface in the Monte Carlo run
+     * @param emit_temps - The temperature each interface emitted at in the Monte Carlo run
+     * @param returned - The fraction of the phonons emitted by the interfaces that were absorbed by an interface
+     * @return - The new interface temperatures
+     */
+    [[nodiscard]] std::vector<double> solve(std::span<const double> absorbed,
+        std::span<const double> emit_temps,
+        double returned);
+    /**
+     * Adds the temperatures and heat fluxes of the last solution to the sensors of the cells at the given step
+     * @param eff_energy - The energy of a phonon of weight 1 in the Monte Carlo run the results are combined with
+     */
+    void record(std::size_t step, double eff_energy) const;
+
+private:
+    // A heat path from a diffusive cell to a neighbouring diffusive cell, an emitting surface or an interface
+    struct Link {
+        std::size_t cell;// Position in cells_
+        std::size_t target;// Neighbouring cell (position in cells_) - unused for emitting surfaces and interfaces
+        double conductance;// Heat flow per unit temperature difference
+        double temp;// Emitting surfaces only - deviation of the surface temperature from t_eq
+        Point midpoint;
+    };
+
+    double t_eq_;
+    std::vector<Cell*> cells_;
+    std::vector<Interface> interfaces_;
+    std::vector<Link> neighbours_;// Each shared edge appears once for each of its cells
+    std::vector<Link> emitters_;
+    std::vector<Link> interface_links_;// interface_links_[i] belongs to interfaces_[i]
+    std::vector<double> temps_;// Deviation of each cell of the last solution
+    std::vector<double> interface_power_;// Heat flowing into the cell through each interface in the last solution
+
+    // Jacobi preconditioned conjugate gradients, starting from the last solution
+    void conjugateGradient(const std::vector<double>& diagonal, const std::vector<double>& rhs);
+};
+
+#endif// PSIM_DIFFUSIONSOLVER_H
@@ -4,10 +4,13 @@
 #include <array>
 #include <exception>
 #include <limits>
+#include <memory_resource>
 #include <optional>
 #include <ostream>
+#include <span>
 #include <string>
 #include <utility>
+#include <vector>
 
 
 namespace Geometry {
@@ -30,6 +33,21 @@ bool operator!=(const Point& lhs, const Point& rhs);
 std::ostream& operator<<(std::ostream& os, const Point& point);// NOLINT
 Point operator-(const Point& lhs, const Point& rhs);
 
+/**
+ * Robust orientation test. A floating point filter decides the sign in almost every case, the determinant is only
+ * evaluated in exact arithmetic when the filter cannot guarantee the sign (nearly collinear points).
+ * @return Positive if c lies to the left of the directed line from a to b, negative if it lies to the right and
+ * exactly 0 if the three points are collinear
+ */
+[[nodiscard]] double orient2d(const Point& a, const Point& b, const Point& c) noexcept;// NOLINT
+
+// Where a segment leaves a convex polygon
+struct EdgeCrossing {
+    std::size_t edge;// Edge i runs from points[i] to points[i + 1]
+    double fraction;// Fraction of the segment covered before the crossing, within [0, 1]
+    Point point;// The crossing point, clamped to the edge
+};
+
 struct Line {
     Line(Point pt1, Point pt2);
     Point p1;
@@ -77,6 +95,9 @@ struct Triangle {
     [[nodiscard]] std::array<Line, 3> lines() const noexcept;
 
     [[nodiscard]] double area() const noexcept;
+    [[nodiscard]] Point centroid() const noexcept;
+    // Bottom left and top right corners of the smallest axis aligned box containing the triangle
+    [[nodiscard]] PointPair boundingBox() const noexcept;
     [[nodiscard]] bool intersects(const Triangle& other) const noexcept;
     // Returns true if any point of the incoming triangle is contained in this triangle
     [[nodiscard]] bool contains(const Triangle& other) const noexcept;
@@ -89,6 +110,83 @@ struct Triangle {
 };
 std::ostream& operator<<(std::ostream& os, const Triangle& triangle);// NOLINT
 
+// A convex polygon with 3 or more vertices given in order around its perimeter (either direction)
+struct Polygon {
+    explicit Polygon(const std::vector<Point>& pts);
+    Polygon(const Triangle& triangle);// NOLINT - triangles are polygons
+    // Copies the polygon into memory obtained from resource
+    Polygon(const Polygon& other, std::pmr::memory_resource* resource);
+    std::pmr::vector<Point> points;
+
+    // Edge i runs from points[i] to points[i + 1], the last edge closes the polygon
+    [[nodiscard]] std::vector<Line> lines() const;
+
+    [[nodiscard]] double area() const noexcept {
+        return area_;
+    }
+    [[nodiscard]] Point centroid() const noexcept;
+    // Bottom left and top right corners of the smallest axis aligned box containing the polygon
+    [[nodiscard]] PointPair boundingBox() const noexcept;
+    // True if the edges of the polygons cross - touching at end points or along parallel edges does not count
+    [[nodiscard]] bool intersects(const Polygon& other) const;
+    // Returns true if any point of the incoming polygon is contained in this polygon
+    [[nodiscard]] bool contains(const Polygon& other) const noexcept;
+    // Return false if the point is on an edge of the polygon
+    [[nodiscard]] bool contains(const Point& p) const noexcept;// NOLINT
+    [[nodiscard]] bool isClockwise() const noexcept {
+        return clockwise_;
+    }
+    /**
+     * Finds the edge through which a segment starting inside (or on the boundary of) the polygon leaves it. The edge
+     * is picked from the orientation of the vertices relative to the segment alone, so the choice is consistent
+     * even when the start point has drifted onto or slightly beyond an edge. A start point beyond the exit edge
+     * gives a crossing at the start of the segment.
+     * @return The exit crossing or nullopt if the segment ends before leaving the polygon or has no length
+     */
+    [[nodiscard]] std::optional<EdgeCrossing> exitCrossing(const Point& start, const Point& end) const noexcept;
+    /**
+     * Cuts the polygon along the infinite line through line. Vertices within GEOEPS of the line count as on it.
+     * @return The part of the polygon on the left of (or on) the directed line or nullopt if no area remains
+     */
+    [[nodiscard]] std::optional<Polygon> clip(const Line& line) const;
+    // The region covered by both polygons or nullopt if they do not overlap (touching does not count)
+    [[nodiscard]] std::optional<Polygon> intersection(const Polygon& other) const;
+    // Picks a triangle of the polygon's fan triangulation by area with r1 and a point within it with r1 & r2
+    [[nodiscard]] Point getRandPoint(double r1, double r2) const noexcept;// NOLINT
+
+    bool operator==(const Polygon& rhs) const;
+
+private:
+    double area_{ 0. };
+    bool clockwise_{ false };
+    // Cumulative share of the area covered by the fan triangles (points[0], points[i], points[i + 1])
+    std::pmr::vector<double> fan_areas_;
+};
+std::ostream& operator<<(std::ostream& os, const Polygon& polygon);// NOLINT
+
+// A counterclockwise rotation about the origin, optionally preceded by a reflection about the x axis, followed by a
+// translation. Rigid, so shared edges stay shared.
+class Transform {
+public:
+    Transform() = default;
+    // Rotations by multiples of 90 degrees are exact
+    Transform(double degrees, Vector2D offset);
+    // Reflection about the infinite line through axis. Exact for axis aligned and diagonal (45 degree) axes.
+    [[nodiscard]] static Transform reflection(const Line& axis) noexcept;
+
+    [[nodiscard]] Point apply(const Point& p) const noexcept;// NOLINT
+    // Vectors are only rotated (and reflected), not translated
+    [[nodiscard]] Vector2D apply(const Vector2D& v) const noexcept;// NOLINT
+    [[nodiscard]] Line apply(const Line& line) const;
+    [[nodiscard]] Polygon apply(const Polygon& polygon) const;
+
+private:
+    double cos_{ 1. };
+    double sin_{ 0. };
+    bool reflect_{ false };
+    Vector2D offset_{ 0., 0. };
+};
+
 class ShapeError : public std::exception {
 public:
     [[nodiscard]] const char* what() const noexcept override {
@@ -120,6 +218,11 @@ private:
     Triangle triangle_;
 };
 
+class PolygonError : public ShapeError {
+public:
+    explicit PolygonError(std::span<const Point> points);
+};
+
 }// namespace Geometry
 
 #endif// PSIM_GEOMETRY_H
@@ -0,0 +1,52 @@
+#ifndef PSIM_GEOMETRYTEMPLATE_H
+#define PSIM_GEOMETRYTEMPLATE_H
+
+#include "geometry.h"
+#include <vector>
+
+/**
+ * A group of cells defined once in local coordinates and placed any number of times with Model::addInstance.
+ * The template cells are validated against each other and the edges they share are found as they are added, so
+ * placing an instance only links the cached edges and checks the instance against the cells around it. Cells
+ * refer to sensors by a local index that each instance maps to sensors of the model.
+ */
+class GeometryTemplate {
+public:
+    struct TemplateCell {
+        Geometry::Polygon polygon;
+        std::size_t sensor;// Local sensor index
+        double specularity;
+    };
+    // An edge shared by two template cells - becomes a pair of transition surfaces in every instance
+    struct Link {
+        std::size_t cell;
+        std::size_t other;
+        Geometry::Line line;
+    };
+
+    /**
+     * Throws if the incoming cell intersects, contains or is contained within a cell of the template.
+     * @param polygon - The cell in the template's local coordinates
+     * @param sensor - Local sensor index, mapped to a sensor of the model by each instance
+     * @param specularity - The specularity of the cell's boundary surfaces
+     */
+    void addCell(const Geometry::Polygon& polygon, std::size_t sensor, double specularity);
+
+    [[nodiscard]] const std::vector<TemplateCell>& getCells() const noexcept {
+        return cells_;
+    }
+    [[nodiscard]] const std::vector<Link>& getLinks() const noexcept {
+        return links_;
+    }
+    // Number of sensors an instance must provide (highest local sensor index + 1)
+    [[nodiscard]] std::size_t numSensors() const noexcept {
+        return num_sensors_;
+    }
+
+private:
+    std::vector<TemplateCell> cells_;
+    std::vector<Link> links_;
+    std::size_t num_sensors_{ 0 };
+};
+
+#endif// PSIM_GEOMETRYTEMPLATE_H
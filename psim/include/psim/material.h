@@ -5,10 +5,35 @@
 #include <array>
 #include <vector>
 
-struct DispersionData;
-struct RelaxationData;
 struct TableData;
 
+// Should extend this to a class
+struct RelaxationData {
+    double b_l{ 0. };
+    double b_tn{ 0. };
+    double b_tu{ 0. };
+    double b_i{ 0. };
+    double w{ 0. };
+};
+
+// Only handles quadratic data - consider extending to a class as well
+struct DispersionData {
+    std::array<double, 3> LA_data{
+        0.,
+        0.,
+        0.,
+    };
+    std::array<double, 3> TA_data{
+        0.,
+        0.,
+        0.,
+    };
+    // std::Array<double, 3> LO_data {0., 0., 0.,};
+    // std::Array<double, 3> TO_data {0., 0., 0.,};
+    double w_max_la{ 0. };
+    double w_max_ta{ 0. };
+};
+
 class Material {
 public:
     static constexpr std::size_t NUM_FREQ_BINS = 1000;// Used on one occasion outside this class
@@ -22,6 +47,23 @@ public:
     void setFullSimulation() noexcept {
         full_simulation_ = true;
     }
+    [[nodiscard]] bool isFullSimulation() const noexcept {
+        return full_simulation_;
+    }
+    // Gray mode - every phonon gets the group velocity and scattering rate of the temperature instead of sampling a
+    // frequency. Must be set before the tables are initialized.
+    void setGray() noexcept {
+        gray_ = true;
+    }
+    [[nodiscard]] bool isGray() const noexcept {
+        return gray_;
+    }
+    [[nodiscard]] const DispersionData& dispersionData() const noexcept {
+        return disp_data_;
+    }
+    [[nodiscard]] const RelaxationData& relaxationData() const noexcept {
+        return relax_data_;
+    }
 
     [[nodiscard]] std::size_t id() const noexcept {
         return id_;
@@ -40,6 +82,16 @@ public:
         return frequencies_;
     }
     [[nodiscard]] double getFreq(std::size_t index) const noexcept;
+    /**
+     * Gray velocity and scattering rates at temp. The velocity keeps the emission of a black body (emitEnergy /
+     * baseEnergy) and every scatter is resistive, at the rate that keeps the conductivity of the spectral model.
+     */
+    [[nodiscard]] double grayVelocity(double temp) const noexcept {
+        return gray_data_[getTempIndex(temp)].velocity;
+    }
+    [[nodiscard]] Phonon::RelaxRates grayRelaxRates(double temp) const noexcept {
+        return { 0., gray_data_[getTempIndex(temp)].rate, 0. };
+    }
     [[nodiscard]] double getVel(std::size_t index, Polar polar) const noexcept;
     [[nodiscard]] const Table* baseTable(double temp) const {
         return baseData(temp).first;
@@ -63,10 +115,23 @@ public:
     }
     // If pseudo=true -> scales results by the relaxation rates (returns scatterEnergy(temp))
     [[nodiscard]] double theoreticalEnergy(double temp, bool pseudo = false) const noexcept;
+    /**
+     * Thermal conductivity of the deviational phonons at temp (the tables must be initialized), in the energy units
+     * of the heat capacity per unit length, time (ns) and temperature. The conductivity of the scattering model the
+     * phonons follow rather than the relaxation time approximation - Normal scatters resample the frequency but keep
+     * the direction, so a phonon carries on through a chain of modes until an Umklapp or impurity scatter.
+     */
+    [[nodiscard]] double conductivity(double temp) const;
+    // Mean free path weighted by the heat flux each mode carries (3 * conductivity / emitEnergy)
+    [[nodiscard]] double meanFreePath(double temp) const {
+        return 3. * conductivity(temp) / emitEnergy(temp);// NOLINT
+    }
     void initializeTables(double low_temp, double high_temp, float temp_interval);
 
 private:
     std::size_t id_;
+    DispersionData disp_data_;// Kept so the material can be serialized
+    RelaxationData relax_data_;
     double b_l_;
     double b_tn_;
     double b_tu_;
@@ -78,6 +143,7 @@ private:
 
     double freq_width_;// Width of frequency bin.
     bool full_simulation_{ false };
+    bool gray_{ false };
 
     Array frequencies_{ 0. };
     Array densities_la_{ 0. };
@@ -89,6 +155,11 @@ private:
     std::vector<TableData> base_tables_;
     std::vector<TableData> emit_tables_;
     std::vector<TableData> scatter_tables_;
+    struct GrayData {
+        double velocity;
+        double rate;// Umklapp rate - the only scattering in gray mode
+    };
+    std::vector<GrayData> gray_data_;// One entry per temperature of temps_ in gray mode
 
     [[nodiscard]] static double getK(double freq, std::array<double, 3> coeffs);
     [[nodiscard]] static double getGv(double freq, std::array<double, 3> coeffs);
@@ -109,33 +180,6 @@ private:
     [[nodiscard]] std::size_t getTempIndex(double temp) const noexcept;
 };
 
-// Should extend this to a class
-struct RelaxationData {
-    double b_l{ 0. };
-    double b_tn{ 0. };
-    double b_tu{ 0. };
-    double b_i{ 0. };
-    double w{ 0. };
-};
-
-// Only handles quadratic data - consider extending to a class as well
-struct DispersionData {
-    std::array<double, 3> LA_data{
-        0.,
-        0.,
-        0.,
-    };
-    std::array<double, 3> TA_data{
-        0.,
-        0.,
-        0.,
-    };
-    // std::Array<double, 3> LO_data {0., 0., 0.,};
-    // std::Array<double, 3> TO_data {0., 0., 0.,};
-    double w_max_la{ 0. };
-    double w_max_ta{ 0. };
-};
-
 struct TableData {
     TableData(Material::Table mat_table, double cumulative_sum)
         : table{ std::move(mat_table) }
@@ -0,0 +1,65 @@
+#ifndef PSIM_MESHIMPORTER_H
+#define PSIM_MESHIMPORTER_H
+
+#include "geometry.h"
+#include <array>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * A 2D triangle mesh produced by an external mesher. Node indices refer to positions in nodes. Elements and
+ * boundary edges carry the physical group (Gmsh) or attribute/marker (Triangle) they were tagged with, 0 if none.
+ */
+struct Mesh {
+    struct Element {
+        std::array<std::size_t, 3> nodes;
+        int group;
+    };
+    struct Edge {
+        std::array<std::size_t, 2> nodes;
+        int group;
+    };
+
+    std::vector<Geometry::Point> nodes;
+    std::vector<Element> elements;
+    std::vector<Edge> edges;
+    std::unordered_map<std::string, int> group_names;// Gmsh physical names -> physical tag
+
+    [[nodiscard]] Geometry::Triangle triangle(const Element& element) const {
+        return { nodes[element.nodes[0]], nodes[element.nodes[1]], nodes[element.nodes[2]] };
+    }
+};
+
+/**
+ * Reads triangle meshes without going through the python builder. Supported formats are
+ * Gmsh ASCII .msh (versions 2.2 and 4.1) and Triangle .node/.ele files (with an optional .edge file for boundary
+ * markers). Files are read section by section, so only the nodes and elements are held in memory.
+ */
+class MeshImporter {
+public:
+    MeshImporter() = delete;
+    /**
+     * @param filepath - A .msh file or a Triangle .node/.ele file (or the shared base name of these files)
+     * @return The mesh contained in the file. Throws a MeshError if the file cannot be read.
+     */
+    [[nodiscard]] static Mesh read(const std::filesystem::path& filepath);
+
+private:
+    [[nodiscard]] static Mesh readGmsh(const std::filesystem::path& filepath);
+    [[nodiscard]] static Mesh readTriangle(const std::filesystem::path& base_path);
+};
+
+class MeshError : public std::exception {
+public:
+    MeshError(const std::filesystem::path& filepath, std::string_view message);
+    [[nodiscard]] const char* what() const noexcept override {
+        return message_.c_str();
+    }
+
+private:
+    std::string message_;
+};
+
+#endif// PSIM_MESHIMPORTER_H
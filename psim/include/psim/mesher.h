@@ -0,0 +1,36 @@
+#ifndef PSIM_MESHER_H
+#define PSIM_MESHER_H
+
+#include "geometry.h"
+#include "meshImporter.h"
+#include <vector>
+
+/**
+ * A region to be meshed - a simple polygon with optional polygonal holes. Vertices may be listed in either
+ * direction. size is the target edge length of the elements covering the region.
+ */
+struct MeshDomain {
+    std::vector<Geometry::Point> boundary;
+    std::vector<std::vector<Geometry::Point>> holes;
+    double size;
+};
+
+/**
+ * Triangulates polygonal domains without an external mesher. Boundaries are split into segments no longer than
+ * the element size and the interior is seeded with a triangular lattice. The Delaunay triangulation of these
+ * points is made to conform to the boundaries by splitting encroached segments and is then refined by inserting
+ * the circumcenters of poorly shaped or oversized elements (Ruppert's algorithm).
+ */
+class Mesher {
+public:
+    Mesher() = delete;
+    /**
+     * @param domains - The regions to mesh. Regions may share boundaries (their elements then meet at common
+     * nodes) but must not overlap.
+     * @return A conforming mesh whose elements are tagged with the index of their domain + 1. The edges are the
+     * boundary edges of the meshed region, tagged with 0.
+     */
+    [[nodiscard]] static Mesh triangulate(const std::vector<MeshDomain>& domains);
+};
+
+#endif// PSIM_MESHER_H
@@ -3,45 +3,94 @@
 
 #include "cell.h"
 #include "geometry.h"
+#include "geometryTemplate.h"
+#include "meshImporter.h"
 #include "modelSimulator.h"
 #include "outputManager.h"
 #include "sensor.h"
 #include "sensorInterpreter.h"
+#include "spatialIndex.h"
+#include <memory_resource>
+#include <span>
 #include <unordered_map>
 
 struct ModelParams {
     std::size_t num_runs{ 1 };
-    std::size_t num_cells;
-    std::size_t num_sensors;
+    std::size_t num_cells{ 0 };// Expected number of cells - used to reserve storage
+    std::size_t num_sensors{ 0 };// Expected number of sensors - used to reserve storage
     std::size_t measurement_steps;
     std::size_t num_phonons;
     double simulation_time;
     double t_eq;
     bool phasor_sim{ false };
+    bool importance_sampling{ false };
+    bool emission_bias{ false };
+    std::vector<std::size_t> target_sensors{};// Sensors emission biasing favours - empty -> every sensor
+    bool annihilation{ false };
+    bool kinetic{ false };
+    std::vector<std::size_t> adjoint_sensors{};// Sensors estimated by an adjoint run - empty -> forward simulation
+    std::vector<std::size_t> diffusive_sensors{};// Sensors solved with the heat equation in a hybrid simulation
+    double diffusive_knudsen{ 0. };// Sensors whose cells all have a lower Knudsen number are diffusive - 0 -> off
+    bool ensemble{ false };// True -> the runs are simulated together, each in its own sensor tally set
+    // Adaptive stopping - num_phonons is run in batches until these targets are met (0 -> no target)
+    double target_temp_error{ 0. };// Largest standard error relative to the largest temperature deviation
+    double target_flux_error{ 0. };// Largest standard error relative to the largest heat flux
+    double time_budget{ 0. };// Seconds of simulation each run may take
+    // Time-stepped steady states split the phonons into this many independent batches for the standard errors
+    std::size_t error_batches{ 0 };
 };
 
 /**
  * The Model class primarily controls the geometrical aspects of the simulation.
  * Materials must be added first with the addMaterials function. Then the sensors must be added as each
- * sensor is linked to a material. Then the cells can be added as they are linked to sensors.
+ * sensor is linked to a material. Then the cells can be added as they are linked to sensors. The storage grows
+ * if more cells or sensors are added than the model was created for, relinking the cells to their new locations.
  * If a cell contains emitting surfaces, they must be added immediately after the cell is added.
  * The class will throw if components are not added in this sequence.
  */
 class Model {
+    friend class ModelSnapshot;
+
 public:
     using Point = Geometry::Point;
+    using Line = Geometry::Line;
 
     /**
-     * @param num_cells - The number of cells that the model will contain.
-     * @param num_sensors - The number of sensors should be <= num_cells
+     * @param num_cells - The expected number of cells that the model will contain.
+     * @param num_sensors - The expected number of sensors, should be <= num_cells
      * @param measurement_steps - The total number of measurement steps (temp/flux recordings)
      * @param num_phonons - The total number of phonons to simulate. More phonons gives more precision but
      * increases simulation time.
      * @param simulation_time - The duration of the simulation
      * @param t_eq - The linearization (equilibrium) temperature of the system - 0 indicates a full simulation
      * @param phasor_sim - True -> phonons have uniform direction & velocity & no scattering
+     * @param importance_sampling - True -> a pilot run sets the importance of each sensor and phonons are split or
+     * rouletted as they move between sensors so that every sensor receives a similar number of samples
+     * @param emission_bias - True -> a pilot run biases the number of phonons built by each cell and emitting
+     * surface towards the sources that matter most to the target sensors. Implied by a non-empty target_sensors.
+     * Throws if combined with importance_sampling, whose weight window would undo the bias.
+     * @param annihilation - True -> phonons are advanced together and opposite sign phonons in the same cell,
+     * frequency bin and polarization cancel at the end of each measurement step
+     * @param kinetic - True -> steady states are solved without time steps by following each emitted phonon until it
+     * is absorbed. Throws for phasor and non deviational simulations and if combined with annihilation.
+     * @param adjoint_sensors - Non-empty -> only these sensors are estimated, by following particles started in them
+     * back in time to the emitting surfaces (and the initial condition in transient simulations). num_phonons is
+     * shared equally among them. Throws for phasor, non deviational and periodic simulations and if combined with
+     * any other variance reduction or the kinetic solver.
+     * @param diffusive_sensors - Non-empty -> hybrid simulation. These sensors are solved with a finite volume heat
+     * equation and phonons are only simulated in the other (ballistic) sensors, with the kinetic solver. The two are
+     * coupled at the edges between them. Implies kinetic. Throws if combined with importance sampling or emission
+     * biasing.
+     * @param diffusive_knudsen - > 0 -> hybrid simulation. Sensors whose cells all have a Knudsen number (phonon mean
+     * free path over the square root of the cell area) below this value are also diffusive.
      */
     Model(const ModelParams& params);
+    ~Model() = default;
+    Model(const Model&) = delete;
+    Model(Model&&) = default;
+    // The cells of the assigned-to model would outlive the arena holding their surfaces
+    Model& operator=(const Model&) = delete;
+    Model& operator=(Model&&) = delete;
     /**
      * @param type - The type of simulation. Default is steady state.
      * @param step_interval - For periodic and transient simulations only. The distance between steps for which
@@ -68,25 +117,44 @@ public:
     void addSensor(std::size_t ID, const std::string& material_name, double t_init,
         SimulationType type);// NOLINT
     /**
-     * Adds a triangular cell to the system.
+     * Adds a convex polygonal (usually triangular) cell to the system.
      * Ensures new cells are not contained in existing cells and existing cells do not contain the new cell.
      * Also verifies that the new cell does not intersect any existing cells. Will throw if any of these occur.
-     * @param triangle - The underlying shape of the cell
+     * Only the cells found near the new cell by the model's spatial index are checked.
+     * @param polygon - The underlying shape of the cell
      * @param sensor_ID - The sensor this cell is linked to -> will throw if the sensor does not exist
      * @param spec - The specularity of the cell's boundary surfaces [0-1]
      */
-    void addCell(Geometry::Triangle triangle, std::size_t sensor_ID, double spec = 1.);
+    void addCell(const Geometry::Polygon& polygon, std::size_t sensor_ID, double spec = 1.);
     /**
-     * This not not used as the python interface takes care of this
-     *
-     * Adds a rectangular cell to the system. This will count as 2 cells as the surface is broken
-     * down into two right angled triangles.
+     * Adds an axis aligned rectangular cell to the system.
      * @param p1 - The lower left point of the rectangle
      * @param p2 - The upper right point of the rectangle
      * @param sensor_ID - The sensor this cell is linked to -> will throw if the sensor does not exist
      * @param spec - The specularity of the cell's boundary surfaces [0-1]
      */
     void addCell(Point&& p1, Point&& p2, std::size_t sensor_ID, double spec = 1.);// NOLINT
+    /**
+     * Adds every triangle of an imported mesh as a cell. The mesh is assumed to be conforming (elements only meet
+     * along full edges or at nodes), so cells are not validated against each other. Transition surfaces are placed
+     * on every edge shared by two elements, found through a hash of the edge node indices rather than geometric
+     * tests. Throws if an edge is shared by more than two elements.
+     * @param mesh - The imported mesh
+     * @param sensor_IDs - The sensor each element is linked to (one entry per element)
+     * @param specs - The specularity of each element's boundary surfaces (one entry per element)
+     */
+    void addMesh(const Mesh& mesh, const std::vector<std::size_t>& sensor_IDs, const std::vector<double>& specs);
+    /**
+     * Places a copy of every cell of the template, moved by transform. Edges shared within the template become
+     * transition surfaces from the template's cached links, so the instance cells are only validated against (and
+     * linked to) the cells already around them. Throws if the instance conflicts with an existing cell.
+     * @param geometry - The template to place
+     * @param transform - Rotation and translation from the template's local coordinates to the model
+     * @param sensor_IDs - sensor_IDs[i] is the model sensor used for the template's local sensor i
+     */
+    void addInstance(const GeometryTemplate& geometry,
+        const Geometry::Transform& transform,
+        const std::vector<std::size_t>& sensor_IDs);
     /**
      * Tries to set the line given by p1 and p2 to an emitting surface. A transient surface is set if a start time
      * and duration are specified. Otherwise, the surface emits from phonons from time 0 until the end of the
@@ -105,6 +173,37 @@ public:
      */
     [[nodiscard]] bool
         setEmitSurface(const Point& p1, const Point& p2, double temp, double duration, double start_time);// NOLINT
+    /**
+     * Pairs the boundary segment p1-p2 with the segment q1-q2 so that phonons leaving the model through one
+     * segment re-enter through the other at the matching point with the same direction (p1 maps to q1). Used to
+     * simulate a single period of a periodic structure.
+     *
+     * Throws if q1-q2 is not a translated copy of p1-p2, if the segments overlap existing sub-surfaces or if the
+     * cells on either side hold different materials.
+     * @return - True if the surfaces are paired and false if either segment is not part of a cell boundary
+     */
+    [[nodiscard]] bool setPeriodicSurface(const Point& p1, const Point& p2, const Point& q1, const Point& q2);
+
+    /**
+     * Post-build pass that reorders the model's cells along a Hilbert curve through their centroids so that
+     * neighbouring cells are also neighbours in memory. Phonons crossing transition surfaces then tend to stay
+     * within nearby memory. Sensors are optionally reordered to follow the first appearance of their cells.
+     * Sensor IDs are preserved, so the exported results are unaffected.
+     * @param reorder_sensors - Also reorder the sensors to follow the new cell order
+     */
+    void reorderCells(bool reorder_sensors = true);
+    /**
+     * Post-build pass that removes mirror symmetries of the model. The vertical and horizontal axes through the centre
+     * of the model's bounding box (and its diagonals if the box is square) are tested in turn, each at most once. A
+     * model is symmetric about an axis if every cell, its sensor grouping, material, initial temperature, boundary
+     * specularities and emitting surfaces have a mirror image. The half beyond the axis is then removed: cells
+     * crossing the axis are cut, edges on the axis become fully specular mirrors and the number of phonons is halved
+     * so that each phonon carries the same energy. Sensors that only held cells in the removed half export the mirror
+     * images of the results of their counterparts, and sensors that are their own mirror image export the average of
+     * their results and its mirror image. Models with periodic surfaces are not reduced.
+     * @return - The number of symmetries removed
+     */
+    std::size_t reduceSymmetry();
 
     void runSimulation();
     void exportResults(const fs::path& filepath, double time) const;
@@ -112,13 +211,28 @@ public:
 private:
     SimulationType sim_type_{ SimulationType::SteadyState };
     std::size_t num_runs_;
-    std::size_t num_cells_;
     std::size_t measurement_steps_;
     double simulation_time_;
     std::size_t num_phonons_;
     double t_eq_{ 0. };// Changes as the system evolves between runs
     bool phasor_sim_;
+    bool importance_sampling_;
+    bool emission_bias_;
+    std::vector<std::size_t> target_sensors_;// Sensor IDs, which may have been removed by reduceSymmetry
+    bool annihilation_;
+    bool kinetic_;
+    std::vector<std::size_t> adjoint_sensors_;
+    std::vector<std::size_t> diffusive_sensors_;// Sensor IDs, which may have been removed by reduceSymmetry
+    double diffusive_knudsen_;
+    bool ensemble_;
+    std::size_t ensemble_rescues_{ 0 };// Stuck phonons rescued by the ensemble members other than simulator_
+    std::size_t reported_rescues_{ 0 };// simulator_'s rescue count (cumulative over runs) when last printed
+    double target_temp_error_;
+    double target_flux_error_;
+    double time_budget_;
+    std::size_t error_batches_;
     std::size_t start_step_{ 0 };// 0 for SS simulations -> measurements vectors are scaled down in the sensors
+    std::size_t step_interval_{ 0 };
 
     // TODO: Not  a big fan of this, prefer dependency injection
     ModelSimulator simulator_;
@@ -126,16 +240,115 @@ private:
     SensorInterpreter interpreter_;
     std::unique_ptr<std::mutex> addMeasurementMutex_;
 
+    // Holds the vertices, boundaries and sub-surfaces of every cell. The cells only refer to memory in the arena,
+    // so they are moved around freely, and the whole arena is released at once when the model is destroyed.
+    // Must be declared before (destroyed after) cells_.
+    std::unique_ptr<std::pmr::monotonic_buffer_resource> arena_;
     std::vector<Cell> cells_;
     std::vector<Sensor> sensors_;
     std::unordered_map<std::string, Material> materials_;
+    SpatialIndex cell_index_;// Positions of cells_ by bounding box
+    std::unordered_map<std::size_t, std::size_t> sensor_index_;// Sensor ID -> position in sensors_
+
+    // A mirror symmetry removed by reduceSymmetry - the kept half of the model is on the left of the axis
+    struct Reflection {
+        Line axis;
+        std::vector<std::pair<std::size_t, std::size_t>> sensors;// Removed sensor ID, ID of its mirror image
+        std::vector<std::size_t> symmetric;// Kept sensors that are their own mirror image (cut by the axis)
+    };
+    std::vector<Reflection> reflections_;// In the order they were removed
 
+    [[nodiscard]] bool isHybrid() const noexcept {
+        return !diffusive_sensors_.empty() || diffusive_knudsen_ > 0.;
+    }
+    // The ID of the sensor that holds the results of the given sensor - its mirror image if reduceSymmetry removed it
+    [[nodiscard]] std::size_t keptSensorID(std::size_t ID) const noexcept;
     /**
      * Return a reference to the sensor with the input ID. If the sensor does not exist, an exception is thrown
      * @param ID - The sensor ID
      * @return A reference to a sensor object
      */
     [[nodiscard]] Sensor& getSensor(std::size_t ID);// NOLINT
+    // The cell with a boundary containing line or nullptr if there is none
+    [[nodiscard]] Cell* findBoundaryCell(const Line& line);
+    // True if an emitting surface can be reached from the given cells through transition and periodic surfaces
+    [[nodiscard]] bool reachesEmitSurface(const std::vector<Cell*>& start) const;
+    /**
+     * Grows the cell (sensor) storage to hold at least capacity elements and updates every link to them.
+     */
+    void reserveCells(std::size_t capacity);
+    void reserveSensors(std::size_t capacity);
+    /**
+     * Moves the cells (sensors) into the order given by new_order and updates every link to them.
+     * @param new_order - new_order[i] is the current index of the element that will be stored at index i
+     */
+    void permuteCells(const std::vector<std::size_t>& new_order);
+    void permuteSensors(const std::vector<std::size_t>& new_order);
+    /**
+     * @return - Sensor ID -> ID of the sensor holding its mirror image if the model is symmetric about axis and
+     * std::nullopt otherwise
+     */
+    [[nodiscard]] std::optional<std::unordered_map<std::size_t, std::size_t>> findMirrorSensors(
+        const Line& axis) const;
+    // Rebuilds the model from the half on the left of axis and records the reflection
+    void removeMirrorHalf(const Line& axis, const std::unordered_map<std::size_t, std::size_t>& mirror_sensors);
+    // Adds the results of the sensors removed by reduceSymmetry to the results of the run
+    void addMirroredResults(std::size_t runId);
+    /**
+     * Runs a pilot simulation with a fraction of the phonons and sets the importance of each sensor to the inverse
+     * of the samples it received, normalized so that the expected total number of samples is unchanged. Sensors
+     * that received few samples then split the phonons entering them and oversampled sensors roulette them.
+     */
+    void buildImportanceMap();
+    /**
+     * Runs a pilot simulation with a fraction of the phonons to bias the number of phonons built by each phonon
+     * source (see ModelSimulator::runEmissionPilot). Target sensors removed by reduceSymmetry are replaced by their
+     * mirror images. Throws if a target sensor does not exist.
+     */
+    void buildEmissionBias();
+    /**
+     * Runs the adjoint simulation of the adjoint sensors (see ModelSimulator::runAdjoint). Throws if a sensor does
+     * not exist or has no cells, if the model holds more than one material (the reverse of a material interface is
+     * not modelled) or if an emitting surface only emits during part of the simulation.
+     */
+    void runAdjoint();
+    /**
+     * Runs the hybrid diffusion simulation. The ballistic region is simulated with a tenth of the phonons and the
+     * diffusive region solved again, with the interface temperatures of each diffusion solution emitting into the
+     * ballistic region, until the interface temperatures settle. The final run uses every phonon, and the diffusive
+     * region is solved for each of its batches so both regions report batch statistics.
+     */
+    void runHybrid();
+    /**
+     * Marks the diffusive sensors - the listed ones (or their mirror images if they were removed by reduceSymmetry)
+     * and those below the Knudsen threshold. The material tables must be initialized. Throws if a listed sensor does
+     * not exist.
+     * @return - The number of diffusive sensors
+     */
+    std::size_t markDiffusiveSensors();
+    /**
+     * Runs every run at once - simulator_ and one copy of it per further run share the geometry, material tables
+     * and sensor temperatures, and each records its phonons in its own tally set of the sensors. Whether the system
+     * needs a reset is decided on the first run, and the results of each run are stored once they are all done. Like
+     * the last of a series of runs, the last tally set is left selected.
+     */
+    void runEnsemble();
+    // Sets the energy of a phonon from the total initial energy and passes it to the interpreter
+    double updatePhononEnergy();
+    [[nodiscard]] bool isAdaptive() const noexcept {
+        return target_temp_error_ > 0. || target_flux_error_ > 0. || time_budget_ > 0.;
+    }
+    /**
+     * Simulates the phonons of a run with simulator_ and the ensemble members. Adaptive runs split the phonons into
+     * batches that add to the same tallies, and stop after the batch that meets the error targets or uses up the time
+     * budget. The interpreter is left with the energy per phonon of the phonons that were run.
+     */
+    void runPhonons(double energy_per_phonon, std::span<ModelSimulator> members = {});
+    /**
+     * @return - The largest standard errors of the sensor temperatures and heat fluxes over every tally set, relative
+     * to the largest deviation of a sensor temperature from t_eq and the largest sensor heat flux
+     */
+    [[nodiscard]] std::pair<double, double> relativeErrors(std::size_t tally_sets);
     [[nodiscard]] double getTotalInitialEnergy() const noexcept;
     /**
      * Find the maximum and minimum possible temperatures of the system. These are used as bounds for the numerical
@@ -145,6 +358,8 @@ private:
     void initializeMaterialTables(double low_temp, double high_temp);
     [[nodiscard]] double avgTemp() const;
     void storeResults(std::size_t runId) noexcept;
+    // Prints the stuck phonons rescued since the last report
+    void reportRescues();
     /**
      * @return - The new t_eq if the system needs to be reset and re-run - less than 90% of the model's sensor
      * temperatures are stable (90%) and std::nullopt otherwise
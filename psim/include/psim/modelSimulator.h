@@ -2,16 +2,26 @@
 #define PSIM_MODELSIMULATOR_H
 
 #include "phononBuilder.h"
+#include <atomic>
+#include <algorithm>
+#include <memory>
 #include <optional>
+#include <span>
 #include <variant>
 #include <vector>
 
 class Cell;
+class EmitSurface;
 class Phonon;
 
 class ModelSimulator {
 public:
     using BuilderObj = std::variant<CellOriginBuilder, SurfaceOriginBuilder, PhasorBuilder>;
+    // A sensor estimated by an adjoint run - its cells and the energy of a 1 K deviation of the whole sensor
+    struct AdjointProbe {
+        std::vector<Cell*> cells;
+        double energy_per_kelvin;
+    };
     ModelSimulator(std::size_t measurement_steps, double simulation_time, bool phasor_sim);
 
     void runSimulation(double t_eq);
@@ -20,23 +30,187 @@ public:
     void reset() noexcept {
         total_phonons_ = 0;
         phonon_builders_.clear();
+        cell_phonons_.clear();
     }
     void setStepAdjustment(std::size_t step_adjustment) {
         step_adjustment_ = step_adjustment;
     }
+    /**
+     * Pilot run for emission biasing - simulates the phonons of the current builders and scores each phonon source
+     * (cell or emitting surface) by the samples its phonons record in the target sensors. The sources are then
+     * biased to build phonons in proportion to their energy times their root mean square score, and the phonons
+     * carry the inverse of the bias as their weight. The total number of phonons is unchanged.
+     * @param target_sensors - IDs of the sensors whose results matter. Empty -> every sensor
+     */
+    void runEmissionPilot(double t_eq, std::vector<std::size_t> target_sensors);
+    void clearEmissionBias() noexcept {
+        source_bias_.clear();
+    }
+    /**
+     * Advance all phonons together one measurement step at a time and, at the end of each step, cancel phonons of
+     * opposite sign in the same cell, frequency bin and polarization. Every phonon is built up front.
+     */
+    void setAnnihilation(bool enabled) noexcept {
+        annihilation_ = enabled;
+    }
+    /**
+     * Kinetic steady-state solver - only emitted phonons are built and each is followed from event to event until
+     * an emitting surface absorbs it, with no measurement steps. Every flight adds the time it spends in a sensor
+     * to the sensor's tally. The histories are dealt in turn to independent batches, one per steady-state
+     * measurement slot.
+     */
+    void setKinetic(bool enabled) noexcept {
+        kinetic_ = enabled;
+    }
+    /**
+     * Splits the phonon histories of time-stepped simulations into independent error batches the way the kinetic
+     * solver batches its histories - batch b records its measurement steps in tally set b of the sensors (see
+     * Sensor::setTallySets). 0 or 1 -> a single batch.
+     */
+    void setErrorBatches(std::size_t batches) noexcept {
+        error_batches_ = batches;
+    }
+    /**
+     * Adjoint (backward) Monte Carlo - estimates the given sensors only. Particles start at random points of the
+     * sensor cells with the distribution of initial phonons and are followed back in time until an emitting surface
+     * absorbs them, scoring the deviation of its temperature from t_eq. Transient particles also score the initial
+     * deviation of the cell they are in at each measurement time (looking back from that time). The scattering and
+     * boundary processes are their own time reverses, so the backward paths follow the forward rules. The scores
+     * are recorded in the sensors in energy units, so the results are interpreted with an effective energy of 1.
+     * @param particles - Number of particles started in each probe
+     * @param transient - True -> every measurement step is estimated, false -> one steady state per batch
+     */
+    void runAdjoint(const std::vector<AdjointProbe>& probes, std::size_t particles, double t_eq, bool transient) const;
+    /**
+     * Hybrid diffusion coupling - phonons crossing from a ballistic cell into a cell of a diffusive sensor are
+     * absorbed by the interface between the two cells, and the interfaces emit phonons into their ballistic cells
+     * like emitting surfaces. interfaces[i] lies on the edge its cell shares with neighbours[i]. The weight each
+     * interface absorbs is tallied per kinetic batch. The surfaces must outlive the simulation. Empty -> no coupling.
+     */
+    void setInterfaces(std::span<const EmitSurface> interfaces, std::span<const Cell* const> neighbours);
+    struct InterfaceTallies {
+        std::vector<double> absorbed;// Weight absorbed by each interface in each batch - [interface * batches + batch]
+        double returned;// Fraction of the phonons emitted by the interfaces that were absorbed by an interface
+    };
+    // The interface tallies since the interfaces were set or last taken
+    [[nodiscard]] InterfaceTallies takeInterfaceTallies();
+    /**
+     * Creates a simulator with the same settings and emission biases that records its phonons tally_offset steps
+     * further on in the sensor tallies (see Sensor::setTallySets), so that it can run alongside this one
+     */
+    [[nodiscard]] ModelSimulator ensembleMember(std::size_t tally_offset) const;
+    // Split and roulette phonons as they enter sensors of different importance
+    void setImportanceSampling(bool enabled) noexcept {
+        importance_sampling_ = enabled;
+    }
+    // Number of phonons that were stuck bouncing between surfaces and had to be moved to a random point in their
+    // cell since the simulator was created
+    [[nodiscard]] std::size_t getRescues() const noexcept {
+        return rescues_->load(std::memory_order_relaxed);
+    }
 
 private:
+    // A phonon with its age and measurement step - copies split off a phonon and paused phonons resume from here
+    struct Track {
+        Phonon phonon;
+        double age;
+        std::size_t step;
+    };
+    // What became of a tracked phonon
+    struct TrackResult {
+        bool alive;// Still in the system when it was paused
+        std::size_t target_samples;// Samples recorded in the target sensors during an emission pilot
+    };
+
+    struct SourceTally {
+        std::atomic<std::size_t> phonons{ 0 };
+        std::atomic<double> score_sq{ 0. };
+    };
+    struct EmissionPilot {
+        EmissionPilot(std::vector<std::size_t> targets, std::size_t num_sources)
+            : target_sensors{ std::move(targets) }
+            , tallies(num_sources) {
+        }
+        [[nodiscard]] bool isTarget(std::size_t sensor_id) const noexcept {
+            return target_sensors.empty() || std::ranges::binary_search(target_sensors, sensor_id);
+        }
+
+        std::vector<std::size_t> target_sensors;// Sorted
+        std::vector<SourceTally> tallies;// One per phonon source
+    };
+
     std::vector<BuilderObj> phonon_builders_;
+    std::vector<std::size_t> cell_phonons_;// Initial phonons of each cell, referenced by the cell origin builders
+    std::vector<double> source_energy_;// Energy of each phonon source - cells, then emitting surfaces
+    std::vector<double> source_bias_;// Phonon count multiplier of each source - empty -> unbiased
+    std::unique_ptr<EmissionPilot> pilot_;// Only set during runEmissionPilot
     std::vector<double> step_times_;
     double step_time_;
     bool phasor_sim_;
+    bool importance_sampling_{ false };
+    bool annihilation_{ false };
+    bool kinetic_{ false };
     std::size_t step_adjustment_{ 0 };
+    std::size_t tally_offset_{ 0 };// Added to every recorded step - selects the tally set of an ensemble member
+    std::size_t error_batches_{ 0 };
     std::size_t total_phonons_{ 0 };
+    std::unique_ptr<std::atomic<std::size_t>> rescues_;// Behind a pointer to keep the simulator movable
+
+    // Hybrid diffusion coupling (see setInterfaces)
+    struct InterfaceKey {
+        std::pair<const Cell*, const Cell*> cells;// The ballistic and the diffusive cell
+        std::size_t interface;
+    };
+    std::span<const EmitSurface> interfaces_;
+    std::vector<InterfaceKey> interface_keys_;// Sorted by cells
+    std::unique_ptr<std::atomic<double>[]> interface_absorbed_;// NOLINT - weight absorbed by interface and batch
+    std::size_t num_interface_tallies_{ 0 };
+    std::size_t interface_source_{ 0 };// Source number of the first interface
+    std::size_t interface_phonons_{ 0 };// Phonons built by the interfaces
+    std::unique_ptr<std::atomic<std::size_t>> interface_returns_;
 
     void runPhononByPhonon(double t_eq);
     void runUsingBuilders(double t_eq);
+    // Advances every phonon to the end of each measurement step before moving on to the next (see setAnnihilation)
+    void runSynchronized(double t_eq);
+    /**
+     * Cancels phonons of opposite sign with the same cell, frequency bin and polarization. In each group the
+     * phonons of the minority sign are removed and those of the majority sign survive with probability
+     * |net weight| / majority weight, so the expected weight of every group is unchanged.
+     */
+    static void annihilate(std::vector<Track>& phonons);
     static void scatter(Phonon& p, const std::array<double, 3>& relax_rates) noexcept;// NOLINT
     void simulatePhonon(Phonon&& p, std::size_t measurement_steps) const;// NOLINT
+    // Follows a phonon flight by flight until it is absorbed (see setKinetic) and records each flight in the given
+    // batch. Returns the number of flights through the target sensors during an emission pilot.
+    std::size_t traceKinetic(Track& track, std::size_t batch, std::vector<Track>& branches) const;
+    // Follows a phasor phonon (see phasor_sim_) as a straight ray from edge to edge until it leaves the system or the
+    // simulation ends. The measurements during each flight are found from the step times and recorded in one go.
+    // Returns the number of target sensor samples during an emission pilot. set_offset selects the error batch.
+    std::size_t tracePhasor(Track& track, std::size_t measurement_steps, std::size_t set_offset) const;
+    // Follows an adjoint particle back in time (see runAdjoint). scores holds the deviation from t_eq it scores at
+    // each measurement time or, if it has a single entry, the deviation of the surface that absorbs it.
+    void traceAdjoint(Phonon& p, double t_eq, std::span<double> scores) const;
+    // Prepares a newly built phonon - sets its step and source bias weight and applies the weight window.
+    // Returns false if the phonon is rouletted.
+    bool launchPhonon(Track& track, std::vector<Track>& branches) const;
+    // Tallies a phonon that crossed from the from cell into a diffusive cell (see setInterfaces)
+    void absorbAtInterface(const Cell* from, const Phonon& p, std::size_t batch) const;
+    // Follows a phonon (or a branch of it) until it leaves the system, the simulation ends or it has recorded the
+    // measurement at pause_step. The track is updated to where the phonon stopped. set_offset selects the error batch.
+    TrackResult trackPhonon(Track& track,// NOLINT
+        std::size_t measurement_steps,
+        std::size_t pause_step,
+        std::vector<Track>& branches,
+        std::size_t set_offset = 0) const;
+    /**
+     * Weight window - the target weight of a phonon is the inverse of the importance of its sensor. Phonons heavier
+     * than the window are split into copies of the target weight (their number is rounded at random) and lighter
+     * phonons survive a roulette with probability weight / target at the target weight. The expected weight is
+     * unchanged either way. Phonons within the window are left alone so they do not churn between similar sensors.
+     * @return False if the phonon is killed by the roulette
+     */
+    static bool applyWeightWindow(Phonon& p, double age, std::size_t step, std::vector<Track>& branches);
     std::optional<double> handleImpacts(Phonon& p, double drift_time, std::size_t sensor_id) const;// NOLINT
 };
 
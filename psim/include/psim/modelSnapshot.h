@@ -0,0 +1,32 @@
+#ifndef PSIM_MODELSNAPSHOT_H
+#define PSIM_MODELSNAPSHOT_H
+
+#include <filesystem>
+#include <optional>
+
+class Model;
+
+/**
+ * Binary snapshot of a fully built model. The snapshot stores the simulation settings, materials, sensors, cells,
+ * the resolved transition surfaces (neighbour links), the emitting surfaces, the periodic surface pairs and the
+ * mirror symmetries removed from the model. Loading
+ * a snapshot maps the file into memory and rebuilds the model directly from these records, skipping input parsing,
+ * cell validation and transition surface discovery. Material tables are not stored as they depend on the
+ * temperature bounds found at the start of each run and are cheap to rebuild.
+ *
+ * Snapshots are tied to the machine's byte order and the snapshot version - they are a cache, not an exchange
+ * format.
+ */
+class ModelSnapshot {
+public:
+    ModelSnapshot() = delete;
+
+    static void save(const Model& model, const std::filesystem::path& filepath);
+    /**
+     * @param filepath - Path to a snapshot written by save
+     * @return The model stored in the snapshot or nullopt if the snapshot cannot be read
+     */
+    [[nodiscard]] static std::optional<Model> load(const std::filesystem::path& filepath);
+};
+
+#endif// PSIM_MODELSNAPSHOT_H
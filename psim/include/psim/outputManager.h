@@ -22,10 +22,21 @@ public:
      * @param time - The time taken to run the simulation.
      * @param num_runs - The number of runs the simulation was executed for.
      * @param type - The type of simulation that was run.
+     * @param rescues - The number of stuck phonons that had to be relocated during the simulation.
      */
-    void exportResults(const fs::path& filepath, double time, std::size_t num_runs, SimulationType type) const;
+    void exportResults(const fs::path& filepath,
+        double time,
+        std::size_t num_runs,
+        SimulationType type,
+        std::size_t rescues) const;
     void addMeasurement(std::size_t runId, SensorMeasurements&& measurement) noexcept;
     void sortMeasurements(std::size_t runId) noexcept;
+    [[nodiscard]] const std::vector<SensorMeasurements>& getMeasurements(std::size_t runId) const {
+        return measurements_.at(runId);
+    }
+    [[nodiscard]] std::vector<SensorMeasurements>& getMeasurements(std::size_t runId) {
+        return measurements_.at(runId);
+    }
     void setStepInterval(std::size_t interval) noexcept {
         step_interval_ = interval;
     }
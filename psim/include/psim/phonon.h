@@ -3,10 +3,12 @@
 
 #include <array>
 #include <ostream>
+#include <vector>
 
 namespace Geometry {
 struct Line;
 struct Point;
+struct Polygon;
 }// namespace Geometry
 
 class Cell;
@@ -20,8 +22,13 @@ public:
 
     Phonon(signed char sign, double lifetime, Cell* cell);
 
-    [[nodiscard]] signed char getSign() const noexcept {
-        return sign_;
+    // Signed statistical weight - the sign determines how the phonon energy/flux is handled
+    [[nodiscard]] double getWeight() const noexcept {
+        return weight_;
+    }
+    // Index of the cell or emitting surface the phonon was built from (see ModelSimulator::initPhononBuilders)
+    [[nodiscard]] std::size_t getSource() const noexcept {
+        return source_;
     }
     [[nodiscard]] std::pair<double, double> getPosition() const noexcept {
         return { px_, py_ };
@@ -47,6 +54,9 @@ public:
     [[nodiscard]] std::size_t getLifeStep() const noexcept {
         return lifestep_;
     }
+    [[nodiscard]] const Cell* getCell() const noexcept {
+        return cell_;
+    }
     [[nodiscard]] bool outsideCell() const noexcept {
         return cell_ == nullptr;
     }
@@ -66,18 +76,28 @@ public:
     void setLifeStep(std::size_t step) {
         lifestep_ = step;
     }
+    void setWeight(double weight) noexcept {
+        weight_ = weight;
+    }
+    void setSource(std::size_t source) noexcept {
+        source_ = source;
+    }
     void scatterUpdate();
     void drift(double time) noexcept;
     void setRandDirection() noexcept;
 
     // All these methods will throw if the phonon is not in a cell (cell_ == nullptr)
     [[nodiscard]] std::size_t getCellSensorID() const;
+    [[nodiscard]] double getCellImportance() const;
     [[nodiscard]] std::size_t getCellMaterialID() const;
     [[nodiscard]] double getCellHeatCapacityAtFreq(std::size_t index) const;
     [[nodiscard]] RelaxRates getRelaxRates(std::size_t step) const;
-    [[nodiscard]] std::array<Geometry::Line, 3> getCellBoundaryLines() const;
-    void handleSurfaceCollision(const Geometry::Point& poi, double step_time);
-    void updateCellHeatParams(std::size_t step) const;
+    [[nodiscard]] const Geometry::Polygon& getCellPolygon() const;
+    // boundary - Position of the impacted surface in the cell's boundaries
+    void handleSurfaceCollision(std::size_t boundary, const Geometry::Point& poi, double step_time);
+    void updateCellHeatParams(std::size_t step, double occupancy = 1.) const;
+    // Records the phonon in its cell at every measurement step in [first_step, last_step)
+    void updateCellHeatSteps(std::size_t first_step, std::size_t last_step) const;
     void setRandPoint(double r1, double r2);// NOLINT
 
     friend std::ostream& operator<<(std::ostream& os, const Phonon& phonon) {// NOLINT
@@ -87,9 +107,10 @@ public:
     }
 
 private:
-    signed char sign_;// Determines how the phonon energy/flux is handled (-1, 1)
+    double weight_;// Starts at the sign (-1, 1), scaled when the phonon is split or survives roulette
     double lifetime_;
     std::size_t lifestep_{ 0 };
+    std::size_t source_{ 0 };
 
     double px_{ 0. };
     double py_{ 0. };
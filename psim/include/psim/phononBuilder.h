@@ -2,7 +2,7 @@
 #define PSIM_PHONONBUILDER_H
 
 #include "phonon.h"
-#include <stack>
+#include <span>
 
 class Cell;
 class EmitSurface;
@@ -33,24 +33,34 @@ protected:
     std::size_t total_phonons_{ 0 };
 };
 
+// Builds the initial phonons of a contiguous range of cells
 class CellOriginBuilder : public PhononBuilder {
 public:
-    CellOriginBuilder() = default;
+    /**
+     * @param cells - The cells of the range
+     * @param num_phonons - Number of phonons to build in each cell of the range (must outlive the builder)
+     * @param first_source - Source index of the first cell of the range, the other cells follow consecutively
+     */
+    CellOriginBuilder(std::span<Cell> cells,
+        std::span<const std::size_t> num_phonons,
+        std::size_t first_source) noexcept;
 
     [[nodiscard]] Phonon operator()(double t_eq) noexcept override;
     [[nodiscard]] bool hasPhonons() const noexcept override {
-        return !cells_.empty();
+        return total_phonons_ > 0;
     }
 
-    void addCellPhonons(Cell* cell, std::size_t num_phonons) noexcept;
-
 private:
-    std::stack<std::pair<Cell*, std::size_t>> cells_;
+    std::span<Cell> cells_;
+    std::span<const std::size_t> num_phonons_;
+    std::size_t first_source_;
+    std::size_t cell_{ 0 };// Index of the cell phonons are currently built in
+    std::size_t built_{ 0 };// Phonons built in that cell so far
 };
 
 class SurfaceOriginBuilder : public PhononBuilder {
 public:
-    SurfaceOriginBuilder(Cell& cell, const EmitSurface& surface, std::size_t num_phonons);
+    SurfaceOriginBuilder(Cell& cell, const EmitSurface& surface, std::size_t num_phonons, std::size_t source);
 
     [[nodiscard]] Phonon operator()(double t_eq) noexcept override;
     [[nodiscard]] bool hasPhonons() const noexcept override {
@@ -59,6 +69,7 @@ public:
 
 private:
     Cell& cell_;
+    std::size_t source_;
 
 protected:
     const EmitSurface& surface_;
@@ -6,6 +6,7 @@
 #include "utils.h"
 #include <memory>
 #include <mutex>
+#include <span>
 
 class Phonon;
 
@@ -17,12 +18,16 @@ public:
         std::size_t num_measurements,
         double t_init);
 
-    void initialUpdate(Phonon& p, const Material::Table& table) const noexcept;// NOLINT
+    void initialUpdate(Phonon& p, const Material::Table& table, double temp) const noexcept;// NOLINT
     void initialUpdate(Phonon& p) const noexcept;// NOLINT
     void scatterUpdate(Phonon& p) const noexcept;// NOLINT
     void addToArea(double area) noexcept {
         area_covered_ += area;
     }
+    // Used when the model rebuilds its cells
+    void resetArea() noexcept {
+        area_covered_ = 0.;
+    }
     // final temps vector is only needed for transient simulations -> included for all calls to keep a common interface
     [[nodiscard]] bool resetRequired(double t_final, std::vector<double>&& final_temps = {}) const noexcept;
 
@@ -41,25 +46,78 @@ public:
     [[nodiscard]] double getInitTemp() const noexcept {
         return controller_->getInitTemp();
     }
+    [[nodiscard]] double getStartTemp() const noexcept {
+        return controller_->getStartTemp();
+    }
     [[nodiscard]] double getSteadyTemp(std::size_t step = 0) const noexcept {
         return controller_->getSteadyTemp(step);
     }
     [[nodiscard]] double getArea() const noexcept {
         return area_covered_;
     }
-    [[nodiscard]] const std::vector<std::array<double, 2>>& getFluxes() const noexcept {
-        return inc_flux_;
+    // The tallies of the selected tally set
+    [[nodiscard]] std::span<const std::array<double, 2>> getFluxes() const noexcept {
+        return getFluxes(active_set_);
+    }
+    [[nodiscard]] std::span<const double> getEnergies() const noexcept {
+        return getEnergies(active_set_);
+    }
+    // The tallies of the given tally set
+    [[nodiscard]] std::span<const std::array<double, 2>> getFluxes(std::size_t set) const noexcept {
+        return { inc_flux_.data() + set * num_measurements_, num_measurements_ };
+    }
+    [[nodiscard]] std::span<const double> getEnergies(std::size_t set) const noexcept {
+        return { inc_energy_.data() + set * num_measurements_, num_measurements_ };
+    }
+    /**
+     * Keeps the given number of independent tally sets for runs that are simulated together - set k records
+     * measurement step s at step k * measurements + s. The tallies are cleared and set 0 is selected.
+     */
+    void setTallySets(std::size_t sets);
+    // The number of measurement steps in each tally set
+    [[nodiscard]] std::size_t getMeasurements() const noexcept {
+        return num_measurements_;
+    }
+    // The tally set the results are read from
+    void selectTallySet(std::size_t set) noexcept {
+        active_set_ = set;
+    }
+    // Phonons in the sensor are kept near a weight of 1 / importance - heavier phonons entering it are split and
+    // lighter ones are rouletted
+    [[nodiscard]] double getImportance() const noexcept {
+        return importance_;
+    }
+    void setImportance(double importance) noexcept {
+        importance_ = importance;
+    }
+    // Diffusive sensors are solved with the heat equation in hybrid simulations - phonons do not enter their cells
+    [[nodiscard]] bool isDiffusive() const noexcept {
+        return diffusive_;
     }
-    [[nodiscard]] const std::vector<int>& getEnergies() const noexcept {
-        return inc_energy_;
+    void setDiffusive(bool diffusive) noexcept {
+        diffusive_ = diffusive;
+    }
+    // Number of phonon measurements recorded since the last reset, regardless of their weight
+    [[nodiscard]] std::size_t getSamples() const noexcept {
+        return samples_;
     }
 
     /**
      * Updates the heat parameters (inc_energy_ & inc_flux_) at the given measurement step
      * @param Phonon - The phonon that is transferring heat/flux to the system
      * @param step - The measurement step to update
+     * @param occupancy - The number of measurements the phonon counts for. Kinetic steady-state tallies weight
+     * each flight by its duration.
+     */
+    void updateHeatParams(const Phonon& p, std::size_t step, double occupancy = 1.) noexcept;// NOLINT
+    // Updates the heat parameters at every measurement step in [first_step, last_step) under a single lock
+    void updateHeatSteps(const Phonon& p, std::size_t first_step, std::size_t last_step) noexcept;
+    /**
+     * Adds heat parameters that were not carried by a phonon (hybrid diffusion results)
+     * @param energy - Energy in phonon weight units, as the sum of the recorded phonon weights
+     * @param flux - Heat flux times the area of the contribution, in the same units as the recorded phonon velocities
      */
-    void updateHeatParams(const Phonon& p, std::size_t step) noexcept;// NOLINT
+    void addHeatParams(std::size_t step, double energy, const std::array<double, 2>& flux) noexcept;
     void reset(bool full_reset) noexcept;
     void updateTables() const {
         controller_->updateTables();
@@ -70,7 +128,13 @@ private:
     std::unique_ptr<SensorController> controller_;
     double area_covered_{ 0. };
 
-    std::vector<int> inc_energy_;
+    double importance_{ 1. };
+    std::size_t samples_{ 0 };
+    bool diffusive_{ false };
+
+    std::size_t num_measurements_;// Measurement steps in each tally set
+    std::size_t active_set_{ 0 };
+    std::vector<double> inc_energy_;
     std::vector<std::array<double, 2>> inc_flux_;
     std::unique_ptr<std::mutex> updateMutex_;
 };
@@ -21,9 +21,14 @@ public:
     [[nodiscard]] double getHeatCapacityAtFreq(std::size_t freq_index) const noexcept;
     [[nodiscard]] virtual double getHeatCapacity(std::size_t step) const noexcept = 0;
     [[nodiscard]] virtual double getInitTemp() const noexcept = 0;
+    // The initial temperature the sensor was created with (unaffected by previous runs)
+    [[nodiscard]] double getStartTemp() const noexcept {
+        return t_init_;
+    }
     [[nodiscard]] virtual double getSteadyTemp(std::size_t step) const noexcept = 0;
 
-    void initialUpdate(Phonon& p, const Material::Table& table) const noexcept;// NOLINT
+    // Emitted phonons - sampled from the emitting surface's table, or at its temperature for gray materials
+    void initialUpdate(Phonon& p, const Material::Table& table, double temp) const noexcept;// NOLINT
     void initialUpdate(Phonon& p) const noexcept;// NOLINT
     virtual void updateTables();
     virtual void scatterUpdate(Phonon& p) const noexcept;// NOLINT
@@ -51,6 +56,9 @@ protected:
         scatter_tables_;// Transient controllers need a scatter table for each measurement step
     std::vector<double> heat_capacities_;
     std::vector<double> steady_temps_;
+
+    // Gray mode - gives the phonon the gray velocity at temp instead of sampling a frequency from a table
+    void grayUpdate(Phonon& p, double temp) const noexcept;// NOLINT
 };
 
 class SteadyStateController : public SensorController {
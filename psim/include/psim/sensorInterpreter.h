@@ -2,6 +2,7 @@
 #define PSIM_SENSORINTERPRETER_H
 
 #include "sensor.h"
+#include <span>
 
 class SensorInterpreter {
 public:
@@ -15,6 +16,16 @@ public:
         ub_ = ub;
     }
     void setParams(double t_eq, double eff_energy) noexcept;
+    // Batched measurements (kinetic and adjoint steady states) are independent estimates rather than a time series
+    // starting at the initial temperature
+    void setBatched(bool batched) noexcept {
+        batched_ = batched;
+    }
+    // The sensors hold this many independent error batches (see ModelSimulator::setErrorBatches) in their tally sets.
+    // The results combine the batches and the standard errors are found from the spread of the batch means.
+    void setErrorBatches(std::size_t batches) noexcept {
+        error_batches_ = batches;
+    }
     [[nodiscard]] SensorMeasurements scaleHeatParams(const Sensor& sensor) const noexcept;
     [[nodiscard]] double getFinalTemp(const Sensor& sensor, std::size_t start_step) const noexcept;
     [[nodiscard]] std::vector<double> getFinalTemps(const Sensor& sensor) const noexcept;// For transient simulations
@@ -24,8 +35,17 @@ private:
     double lb_;// Same here but min emitting surface temperature
     double t_eq_;// Adjusted in the Model class
     double eff_energy_;// Adjusted in the Model class once the effective energy is calculated
+    bool batched_{ false };
+    std::size_t error_batches_{ 0 };
 
     [[nodiscard]] std::vector<double> findTemperature(const Sensor& sensor, std::size_t start_step = 0) const noexcept;
+    // The temperatures of the given energy tallies of the sensor when a phonon of weight 1 has eff_energy
+    [[nodiscard]] std::vector<double> toTemperatures(const Sensor& sensor,
+        std::span<const double> tallies,
+        double eff_energy) const noexcept;
+    // The energy and flux tallies of every error batch added together
+    [[nodiscard]] std::vector<double> totalEnergies(const Sensor& sensor) const noexcept;
+    [[nodiscard]] std::vector<std::array<double, 2>> totalFluxes(const Sensor& sensor) const noexcept;
 };
 
 
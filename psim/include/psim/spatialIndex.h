@@ -0,0 +1,52 @@
+#ifndef PSIM_SPATIALINDEX_H
+#define PSIM_SPATIALINDEX_H
+
+#include "geometry.h"
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Uniform hash grid over axis aligned bounding boxes. Each entry is identified by an index (the position of the
+ * entry in some external container) and is registered in every grid bucket its bounding box touches. The buckets
+ * are sized from the mean size of the boxes, but never so small that the grid over all boxes holds many more buckets
+ * than entries. The grid is rebuilt as the number of entries doubles, so the size follows the boxes as they are added.
+ */
+class SpatialIndex {
+public:
+    using BoundingBox = Geometry::PointPair;
+
+    SpatialIndex() = default;
+
+    void insert(std::size_t id, const BoundingBox& box);
+    /**
+     * @param box - The region to search
+     * @return The ids of all entries whose bounding box overlaps or touches box, in ascending order
+     */
+    [[nodiscard]] std::vector<std::size_t> query(const BoundingBox& box) const;
+    void clear() noexcept {
+        bucket_size_ = 0.;
+        buckets_.clear();
+        boxes_.clear();
+        present_.clear();
+        entries_ = 0;
+        next_rebuild_ = 0;
+    }
+
+private:
+    double bucket_size_{ 0. };
+    std::unordered_map<std::uint64_t, std::vector<std::size_t>> buckets_;
+    std::vector<BoundingBox> boxes_;
+    std::vector<bool> present_;// Whether an entry was inserted with each id
+    std::size_t entries_{ 0 };
+    std::size_t next_rebuild_{ 0 };// Number of entries at which the grid is sized again
+    BoundingBox bounds_;// Bounding box of every entry
+
+    // Sizes the buckets from the current entries and registers every entry again
+    void rebuild();
+    void addToBuckets(std::size_t id);
+    [[nodiscard]] std::int32_t bucketCoord(double coord) const noexcept;
+    [[nodiscard]] static std::uint64_t bucketKey(std::int32_t x, std::int32_t y) noexcept;// NOLINT
+};
+
+#endif// PSIM_SPATIALINDEX_H
@@ -18,7 +18,7 @@ public:
     using Line = Geometry::Line;
 
     Surface(Line surface_line, Cell& cell, double specularity, int norm_sign);
-    virtual ~Surface() = default;
+    ~Surface() = default;
     Surface(const Surface&) = default;
     Surface(Surface&&) noexcept = default;
     Surface& operator=(const Surface&) = delete;
@@ -48,18 +48,28 @@ public:
     void setNormal(Vector2D normal) noexcept {
         normal_ = normal;
     }
+    void setSpecularity(double specularity) noexcept {
+        specularity_ = specularity;
+    }
     bool operator==(const Surface& rhs) const {
         return (surface_line_ == rhs.surface_line_);
     }
     bool operator>(const Surface& rhs) const {
         return surface_line_ > rhs.surface_line_;
     }
+    // Points this surface at a new cell. Used when the model relocates its cells in memory.
+    void relink(Cell* cell) noexcept {
+        cell_ = cell;
+    }
+    [[nodiscard]] Cell* getCell() const noexcept {
+        return cell_;
+    }
 
 private:
     Line surface_line_;
 
 protected:
-    Cell& cell_;
+    Cell* cell_;
     Vector2D normal_;
     double specularity_;
 };
@@ -82,6 +92,9 @@ public:
     [[nodiscard]] double getTemp() const noexcept {
         return temp_;
     }
+    [[nodiscard]] double getStartTime() const noexcept {
+        return start_time_;
+    }
     [[nodiscard]] const Material::Table& getTable() const noexcept {
         return *emit_table_;
     }
@@ -105,4 +118,20 @@ public:
     void handlePhonon(Phonon& p) const noexcept;// NOLINT
 };
 
+// Moves phonons to the matching point of a paired surface that is a translated copy of this surface. Used to
+// simulate a single period of a periodic structure. The cell is the one holding the paired surface.
+class PeriodicSurface : public Surface {
+public:
+    PeriodicSurface(Line surface_line, Cell& cell, int norm_sign, Vector2D offset);
+    // The phonon keeps its direction and continues from the paired surface
+    void handlePhonon(Phonon& p) const noexcept;// NOLINT
+    // Translation from this surface to the paired surface
+    [[nodiscard]] Vector2D getOffset() const noexcept {
+        return offset_;
+    }
+
+private:
+    Vector2D offset_;
+};
+
 #endif// PSIM_SURFACE_H
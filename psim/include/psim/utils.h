@@ -9,6 +9,7 @@
 enum class SimulationType { SteadyState, Periodic, Transient };
 inline constexpr double GEOEPS = std::numeric_limits<double>::epsilon() * 1E9;
 inline constexpr double PI = 3.1415926535897932384626433832795028841971693993751058209749445923;
+inline constexpr double SCALING_FACTOR = 1e9;// Factor to scale the scattering time (ns per second)
 
 namespace Utils {
 
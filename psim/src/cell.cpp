@@ -1,5 +1,6 @@
 #include "psim/cell.h"
 #include "psim/geometry.h"
+#include <algorithm>
 #include <cmath>
 #include <execution>
 #include <sstream>
@@ -9,12 +10,12 @@ class Phonon;
 using Line = Geometry::Line;
 using Point = Geometry::Point;
 
-// Assumes triangle has no intersecting surfaces - this is handled by the triangle class
-Cell::Cell(const Triangle& cell, Sensor& sensor, double spec)
-    : cell_{ cell }
-    , sensor_{ sensor }
-    , boundaries_{ buildCompositeSurfaces(spec) } {
-    sensor_.addToArea(getArea());
+// Assumes the polygon has no intersecting surfaces - this is handled by the polygon class
+Cell::Cell(const Polygon& cell, Sensor& sensor, double spec, std::pmr::memory_resource* resource)
+    : cell_{ cell, resource }
+    , sensor_{ &sensor }
+    , boundaries_{ buildCompositeSurfaces(spec, resource) } {
+    sensor_->addToArea(getArea());
 }
 
 // Checks if an incoming cell is valid if this cell already exists in the model
@@ -34,9 +35,21 @@ bool Cell::setEmitSurface(const Line& line, double temp, double duration, double
     return false;
 }
 
+bool Cell::setPeriodicSurface(const Line& line, Cell& target, Geometry::Vector2D offset) {
+    const int norm_sign = (cell_.isClockwise()) ? 1 : -1;
+    for (auto& boundary : boundaries_) {
+        if (boundary.addPeriodicSurface(line, target, norm_sign, offset)) { return true; }
+    }
+    return false;
+}
+
+bool Cell::canAddSurface(const Line& line) const {
+    return std::ranges::any_of(boundaries_, [&line](const auto& boundary) { return boundary.canAddSurface(line); });
+}
+
 // Gets this initial amount of energy in this cell based on the cell starting temperature and size
 double Cell::getInitEnergy(double t_eq) const noexcept {
-    const double init_energy = getArea() * sensor_.getHeatCapacity();
+    const double init_energy = getArea() * sensor_->getHeatCapacity();
     return (t_eq == 0.) ? init_energy : init_energy * std::fabs(getInitTemp() - t_eq);
 }
 
@@ -72,8 +85,8 @@ void Cell::updateEmitTables() noexcept {
 
 // The incoming phonon contributes its energy & flux to the sensor that is linked to this cell. The step refers to the
 // time frame where this contribution occurs
-void Cell::updateHeatParams(const Phonon& p, std::size_t step) const noexcept {// NOLINT
-    sensor_.updateHeatParams(p, step);
+void Cell::updateHeatParams(const Phonon& p, std::size_t step, double occupancy) const noexcept {// NOLINT
+    sensor_->updateHeatParams(p, step, occupancy);
 }
 
 // Assumes cells can only have a single transition surface between them - this will likely remain a constraint that
@@ -97,30 +110,39 @@ void Cell::findTransitionSurface(Cell& other) {
     }
 }
 
-// Handles the interaction of a phonon colliding with the surface in which poi is located.
+void Cell::linkTransitionSurface(const Line& line, Cell& other) {
+    if (!setTransitionSurface(line, other) || !other.setTransitionSurface(line, *this)) {
+        throw CompositeSurfaceError(line, line);
+    }
+}
+
+// Handles the interaction of a phonon colliding with the given boundary surface at poi.
 // The step_time is only needed for transient simulations. It is used to check whether a surface
 // is currently acting as an emitting surface or whether it is currently acting as a boundary surface.
-void Cell::handleSurfaceCollision(Phonon& p, const Point& poi, double step_time) const noexcept {// NOLINT
-    const auto boundary_iter =
-        std::ranges::find_if(boundaries_, [&poi](const auto& boundary) { return boundary.contains(poi); });
-
-    if (boundary_iter != std::cend(boundaries_)) { boundary_iter->handlePhonon(p, poi, step_time); }
+void Cell::handleSurfaceCollision(Phonon& p, std::size_t boundary, const Point& poi, double step_time) const noexcept {// NOLINT
+    boundaries_[boundary].handlePhonon(p, poi, step_time);
 }
 
-std::array<Line, 3> Cell::getBoundaryLines() const noexcept {
-    return { boundaries_[0].getSurfaceLine(), boundaries_[1].getSurfaceLine(), boundaries_[2].getSurfaceLine() };
+std::vector<Line> Cell::getBoundaryLines() const {
+    std::vector<Line> lines;
+    lines.reserve(boundaries_.size());
+    for (const auto& boundary : boundaries_) { lines.push_back(boundary.getSurfaceLine()); }
+    return lines;
 }
 
-std::array<CompositeSurface, 3> Cell::buildCompositeSurfaces(double spec) noexcept {
+std::pmr::vector<CompositeSurface> Cell::buildCompositeSurfaces(double spec, std::pmr::memory_resource* resource) {
     if (spec < 0.) {
         spec = 0.;
     } else if (spec > 1.) {
         spec = 1.;
     }
     const int norm_sign = (cell_.isClockwise()) ? 1 : -1;
-    return { CompositeSurface{ Surface(Line{ cell_.p1, cell_.p2 }, *this, spec, norm_sign) },
-        CompositeSurface{ Surface(Line{ cell_.p2, cell_.p3 }, *this, spec, norm_sign) },
-        CompositeSurface{ Surface(Line{ cell_.p3, cell_.p1 }, *this, spec, norm_sign) } };
+    std::pmr::vector<CompositeSurface> boundaries{ resource };
+    boundaries.reserve(cell_.points.size());
+    for (auto&& line : cell_.lines()) {
+        boundaries.emplace_back(Surface(std::move(line), *this, spec, norm_sign), resource);
+    }
+    return boundaries;
 }
 
 bool Cell::setTransitionSurface(const Line& line, Cell& cell) {
@@ -132,10 +154,8 @@ bool Cell::setTransitionSurface(const Line& line, Cell& cell) {
 }
 
 std::ostream& operator<<(std::ostream& os, const Cell& cell) {// NOLINT
-    os << "(" << cell.sensor_.getID() << ") " << cell.cell_ << '\n'
-       << cell.boundaries_[0] << '\n'
-       << cell.boundaries_[1] << '\n'
-       << cell.boundaries_[2] << '\n';
+    os << "(" << cell.sensor_->getID() << ") " << cell.cell_ << '\n';
+    for (const auto& boundary : cell.boundaries_) { os << boundary << '\n'; }
     return os;
 }
 
@@ -147,7 +167,7 @@ bool Cell::operator!=(const Cell& rhs) const {
     return !(rhs == *this);
 }
 
-IntersectError::IntersectError(const Geometry::Triangle& existing, const Geometry::Triangle& incoming)// NOLINT
+IntersectError::IntersectError(const Geometry::Polygon& existing, const Geometry::Polygon& incoming)// NOLINT
     : existing_{ existing }
     , incoming_{ incoming } {
     std::ostringstream os;// NOLINT
@@ -155,7 +175,7 @@ IntersectError::IntersectError(const Geometry::Triangle& existing, const Geometr
     setMessage(os.str());
 }
 
-OverlapError::OverlapError(const Geometry::Triangle& bigger, const Geometry::Triangle& smaller)// NOLINT
+OverlapError::OverlapError(const Geometry::Polygon& bigger, const Geometry::Polygon& smaller)// NOLINT
     : bigger_{ bigger }
     , smaller_{ smaller } {
     std::ostringstream os;// NOLINT
@@ -1,5 +1,7 @@
 #include "psim/compositeSurface.h"
 #include "psim/geometry.h"
+#include "psim/utils.h"
+#include <algorithm>
 #include <ranges>
 #include <sstream>
 
@@ -9,8 +11,13 @@ class Phonon;
 
 using Line = Geometry::Line;
 
-CompositeSurface::CompositeSurface(Surface&& main_surface)
-    : main_surface_{ std::move(main_surface) } {
+CompositeSurface::CompositeSurface(Surface&& main_surface, std::pmr::memory_resource* resource)
+    : main_surface_{ std::move(main_surface) }
+    , transition_sub_surfaces_{ resource }
+    , emit_sub_surfaces_{ resource }
+    , periodic_sub_surfaces_{ resource }
+    , intervals_{ resource }
+    , param_eps_{ GEOEPS / main_surface_.getLength() } {
 }
 
 void CompositeSurface::updateEmitSurfaceTables() noexcept {
@@ -29,6 +36,7 @@ bool CompositeSurface::addEmitSurface(const Line& surface_line,
             surface_line, cell, main_surface_.getSpecularity(), norm_sign, mat, temp, duration, start_time);
         // Ensure normal is correct
         emit_sub_surfaces_.back().setNormal(main_surface_.getNormal());
+        addInterval(surface_line, SubSurfaceType::Emit, emit_sub_surfaces_.size() - 1);
         return true;
     }
     return false;
@@ -39,32 +47,60 @@ bool CompositeSurface::addTransitionSurface(const Line& surface_line, Cell& cell
         // Transition surfaces cause the phonon to diffusely (spec=0) backscatter when they lack a corresponding
         // state in the new material (frequency too high)
         transition_sub_surfaces_.emplace_back(surface_line, cell, 0., norm_sign);
+        addInterval(surface_line, SubSurfaceType::Transition, transition_sub_surfaces_.size() - 1);
         return true;
     }
     return false;
 }
 
-void CompositeSurface::handlePhonon(Phonon& p, const Point& poi, double step_time) const noexcept {// NOLINT
-    // Search transitions surfaces first since, in most scenarios, this will be the most likely impact surface
-    if (const auto transition_it = std::ranges::find_if(transition_sub_surfaces_,
-            [&poi](const auto& t_surface) { return t_surface.getSurfaceLine().contains(poi); });
-        transition_it != std::cend(transition_sub_surfaces_)) {
-        transition_it->handlePhonon(p);
-        return;
+bool CompositeSurface::addPeriodicSurface(const Line& surface_line,
+    Cell& cell,
+    int norm_sign,
+    Geometry::Vector2D offset) {
+    if (verifySurfaceLine(surface_line)) {
+        periodic_sub_surfaces_.emplace_back(surface_line, cell, norm_sign, offset);
+        addInterval(surface_line, SubSurfaceType::Periodic, periodic_sub_surfaces_.size() - 1);
+        return true;
     }
-    // Check emit surfaces next
-    const auto emit_it = std::ranges::find_if(
-        emit_sub_surfaces_, [&poi](const auto& e_surface) { return e_surface.getSurfaceLine().contains(poi); });
+    return false;
+}
 
-    if (emit_it != std::cend(emit_sub_surfaces_)) {
-        emit_it->handlePhonon(p, step_time);
-        return;
+void CompositeSurface::handlePhonon(Phonon& p, const Point& poi, double step_time) const noexcept {// NOLINT
+    // The only candidate is the last sub-surface starting at or before the impact point
+    const auto t = param(poi);
+    if (const auto next = std::ranges::upper_bound(intervals_, t + param_eps_, {}, &SubSurfaceInterval::start);
+        next != std::cbegin(intervals_)) {
+        if (const auto& interval = *std::prev(next); t <= interval.end + param_eps_) {
+            switch (interval.type) {
+            case SubSurfaceType::Transition:
+                transition_sub_surfaces_[interval.index].handlePhonon(p);
+                break;
+            case SubSurfaceType::Emit:
+                emit_sub_surfaces_[interval.index].handlePhonon(p, step_time);
+                break;
+            case SubSurfaceType::Periodic:
+                periodic_sub_surfaces_[interval.index].handlePhonon(p);
+                break;
+            }
+            return;
+        }
     }
-
     // If the phonon didn't impact a transition or emit surface, it must have hit the main (boundary) surface
     main_surface_.boundaryHandlePhonon(p);
 }
 
+double CompositeSurface::param(const Point& point) const noexcept {
+    const auto& [p1, p2] = main_surface_.getSurfaceLine().getPoints();
+    const auto length = main_surface_.getLength();
+    return ((point.x - p1.x) * (p2.x - p1.x) + (point.y - p1.y) * (p2.y - p1.y)) / (length * length);
+}
+
+void CompositeSurface::addInterval(const Line& surface_line, SubSurfaceType type, std::size_t index) {
+    const auto [start, end] = std::minmax({ param(surface_line.p1), param(surface_line.p2) });
+    const SubSurfaceInterval interval{ start, end, type, index };
+    intervals_.insert(std::ranges::upper_bound(intervals_, start, {}, &SubSurfaceInterval::start), interval);
+}
+
 bool CompositeSurface::verifySurfaceLine(const Line& surface_line) const {
     const auto& main = main_surface_.getSurfaceLine();
     // If the incoming surface is contained within the primary surface
@@ -81,6 +117,11 @@ bool CompositeSurface::verifySurfaceLine(const Line& surface_line) const {
                 throw CompositeSurfaceError(existing, surface_line);
             }
         }
+        for (const auto& ps : periodic_sub_surfaces_) {// NOLINT
+            if (const auto& existing = ps.getSurfaceLine(); surface_line.overlaps(existing)) {
+                throw CompositeSurfaceError(existing, surface_line);
+            }
+        }
         return true;
     }
     return false;
@@ -94,6 +135,9 @@ std::ostream& operator<<(std::ostream& os, const CompositeSurface& surface) {//
     for (const auto& es : surface.emit_sub_surfaces_) {// NOLINT
         os << '\t' << "Emit Surface: " << es.getSurfaceLine() << '\n';
     }
+    for (const auto& ps : surface.periodic_sub_surfaces_) {// NOLINT
+        os << '\t' << "Periodic Surface: " << ps.getSurfaceLine() << '\n';
+    }
     return os;
 }
 
@@ -0,0 +1,215 @@
+#include "psim/diffusionSolver.h"
+#include "psim/cell.h"
+#include "psim/material.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <unordered_map>
+
+using Point = Geometry::Point;
+using Line = Geometry::Line;
+
+namespace {
+
+// The linearized return of interface phonons is capped so that interfaces always exchange heat with the ballistic
+// region - a fully enclosed diffusive region would otherwise have no fixed temperature
+constexpr double MAX_RETURNED{ 0.95 };
+// Conjugate gradients stop once the residual is this fraction of the right hand side
+constexpr double CG_TOLERANCE{ 1e-10 };
+
+double distance(const Point& point, const Line& line) noexcept {
+    const auto& [p1, p2] = line.getPoints();
+    return std::fabs((p2.x - p1.x) * (point.y - p1.y) - (p2.y - p1.y) * (point.x - p1.x)) / line.length;
+}
+
+Point midpoint(const Line& line) noexcept {
+    const auto& [p1, p2] = line.getPoints();
+    return { (p1.x + p2.x) / 2., (p1.y + p2.y) / 2. };
+}
+
+double dot(const std::vector<double>& lhs, const std::vector<double>& rhs) noexcept {
+    return std::transform_reduce(std::cbegin(lhs), std::cend(lhs), std::cbegin(rhs), 0.);
+}
+
+}// namespace
+
+DiffusionSolver::DiffusionSolver(std::vector<Cell>& cells, double t_eq)
+    : t_eq_{ t_eq } {
+    constexpr auto NONE = std::numeric_limits<std::size_t>::max();
+    std::vector<std::size_t> position(cells.size(), NONE);
+    auto positionOf = [&](const Cell* cell) { return position[static_cast<std::size_t>(cell - cells.data())]; };
+    for (auto& cell : cells) {
+        if (cell.isDiffusive()) {
+            position[static_cast<std::size_t>(&cell - cells.data())] = cells_.size();
+            cells_.push_back(&cell);
+        }
+        for (const auto& boundary : cell.getBoundaries()) {
+            for (const auto& ps : boundary.getPeriodicSurfaces()) {// NOLINT
+                if (cell.isDiffusive() || ps.getCell()->isDiffusive()) {
+                    throw std::runtime_error(
+                        std::string("Periodic surfaces cannot lead into or out of diffusive sensors.\n"));
+                }
+            }
+        }
+    }
+    // The conductivity only depends on the sensor
+    std::unordered_map<std::size_t, double> sensor_conductivities;
+    std::vector<double> conductivities;
+    conductivities.reserve(cells_.size());
+    for (const auto* cell : cells_) {
+        auto [found, inserted] = sensor_conductivities.try_emplace(cell->getSensorID(), 0.);
+        if (inserted) { found->second = cell->getMaterial().conductivity(cell->getSteadyTemp()); }
+        conductivities.push_back(found->second);
+    }
+    // Conductance of the half of the cell between its centroid and the line
+    auto halfConductance = [&](std::size_t index, const Line& line) {
+        return conductivities[index] * line.length / distance(cells_[index]->getCentroid(), line);
+    };
+
+    for (std::size_t index = 0; index < cells_.size(); ++index) {
+        const auto& cell = *cells_[index];
+        for (const auto& boundary : cell.getBoundaries()) {
+            for (const auto& ts : boundary.getTransitionSurfaces()) {// NOLINT
+                const auto& line = ts.getSurfaceLine();
+                auto* neighbour = ts.getCell();
+                if (neighbour->isDiffusive()) {
+                    const auto other = positionOf(neighbour);
+                    const auto conductance =
+                        1. / (1. / halfConductance(index, line) + 1. / halfConductance(other, line));
+                    neighbours_.push_back({ index, other, conductance, 0., midpoint(line) });
+                } else {
+                    if (neighbour->getMaterialID() != cell.getMaterialID()) {
+                        throw std::runtime_error(std::string(
+                            "Diffusive sensors must have the same material as the ballistic cells they border.\n"));
+                    }
+                    interface_links_.push_back({ index, 0, halfConductance(index, line), 0., midpoint(line) });
+                    interfaces_.push_back({ neighbour, &cell, line });
+                }
+            }
+            for (const auto& es : boundary.getEmitSurfaces()) {// NOLINT
+                // Like every black body, the surface holds the medium next to it halfway between its temperature and
+                // that of the incident phonons - a slip conductance of twice its emission
+                const auto& line = es.getSurfaceLine();
+                const auto slip = cell.getMaterial().emitEnergy(es.getTemp()) * line.length / 2.;
+                const auto conductance = 1. / (1. / halfConductance(index, line) + 1. / slip);
+                emitters_.push_back({ index, 0, conductance, es.getTemp() - t_eq_, midpoint(line) });
+            }
+        }
+    }
+    temps_.resize(cells_.size(), 0.);
+    interface_power_.resize(interfaces_.size(), 0.);
+}
+
+std::vector<double> DiffusionSolver::solve(std::span<const double> absorbed,
+    std::span<const double> emit_temps,
+    double returned) {
+    returned = std::clamp(returned, 0., MAX_RETURNED);
+    std::vector<double> diagonal(cells_.size(), 0.);
+    std::vector<double> rhs(cells_.size(), 0.);
+    for (const auto& link : neighbours_) { diagonal[link.cell] += link.conductance; }
+    for (const auto& link : emitters_) {
+        diagonal[link.cell] += link.conductance;
+        rhs[link.cell] += link.conductance * link.temp;
+    }
+    // The power an interface passes into its cell is P = B - H * T_e with the black body emission G * T_e and
+    // B = absorbed - returned * G * (emitted T_e), H = (1 - returned) * G. The medium at the interface is halfway
+    // between T_e and the incident temperature absorbed / G, T_w = B / 2G + (1 + returned) / 2 * T_e, and P flows
+    // through the half cell K, so P = K * (T_w - T). This gives T_e and leaves a Robin condition on the cell.
+    struct Exchange {
+        double source;// B
+        double sink;// H
+        double slip;// (1 + returned) / 2
+        double offset;// B / 2G
+    };
+    std::vector<Exchange> exchanges(interfaces_.size());
+    for (std::size_t index = 0; index < interfaces_.size(); ++index) {
+        const auto& link = interface_links_[index];
+        const auto emission = cells_[link.cell]->getMaterial().emitEnergy(emit_temps[index])
+                              * interfaces_[index].line.length / 4.;// NOLINT
+        auto& [source, sink, slip, offset] = exchanges[index];
+        source = absorbed[index] - returned * emission * (emit_temps[index] - t_eq_);
+        sink = (1. - returned) * emission;
+        slip = (1. + returned) / 2.;
+        offset = source / (2. * emission);
+        const auto series = link.conductance / (sink + link.conductance * slip);
+        diagonal[link.cell] += sink * series;
+        rhs[link.cell] += (source * slip + sink * offset) * series;
+    }
+    conjugateGradient(diagonal, rhs);
+
+    std::vector<double> interface_temps(interfaces_.size());
+    for (std::size_t index = 0; index < interfaces_.size(); ++index) {
+        const auto& link = interface_links_[index];
+        const auto& [source, sink, slip, offset] = exchanges[index];
+        const auto deviation =
+            (source + link.conductance * (temps_[link.cell] - offset)) / (sink + link.conductance * slip);
+        interface_power_[index] = source - sink * deviation;
+        interface_temps[index] = deviation + t_eq_;
+    }
+    return interface_temps;
+}
+
+void DiffusionSolver::record(std::size_t step, double eff_energy) const {
+    // With no heat sources in a cell, the integral of the heat flux over the cell is the sum of the heat flowing out
+    // through each edge times the position of the edge
+    std::vector<Geometry::Vector2D> moments(cells_.size(), { 0., 0. });
+    auto addOutflow = [&](std::size_t index, double outflow, const Point& point) {
+        const auto centroid = cells_[index]->getCentroid();
+        moments[index].x += outflow * (point.x - centroid.x);
+        moments[index].y += outflow * (point.y - centroid.y);
+    };
+    for (const auto& link : neighbours_) {
+        addOutflow(link.cell, link.conductance * (temps_[link.cell] - temps_[link.target]), link.midpoint);
+    }
+    for (const auto& link : emitters_) {
+        addOutflow(link.cell, link.conductance * (temps_[link.cell] - link.temp), link.midpoint);
+    }
+    for (std::size_t index = 0; index < interfaces_.size(); ++index) {
+        addOutflow(interface_links_[index].cell, -interface_power_[index], interface_links_[index].midpoint);
+    }
+    for (std::size_t index = 0; index < cells_.size(); ++index) {
+        const auto& cell = *cells_[index];
+        const auto energy = cell.getHeatCapacity() * cell.getArea() * temps_[index];
+        cell.addHeatParams(step, energy / eff_energy, { moments[index].x / eff_energy, moments[index].y / eff_energy });
+    }
+}
+
+void DiffusionSolver::conjugateGradient(const std::vector<double>& diagonal, const std::vector<double>& rhs) {
+    const auto size = temps_.size();
+    auto multiply = [&](const std::vector<double>& x, std::vector<double>& y) {
+        std::transform(std::cbegin(diagonal), std::cend(diagonal), std::cbegin(x), std::begin(y), std::multiplies{});
+        for (const auto& link : neighbours_) { y[link.cell] -= link.conductance * x[link.target]; }
+    };
+    auto precondition = [&](const std::vector<double>& r, std::vector<double>& z) {
+        std::transform(std::cbegin(r), std::cend(r), std::cbegin(diagonal), std::begin(z), [](double res, double diag) {
+            return (diag > 0.) ? res / diag : 0.;// Cells without any heat path are left alone
+        });
+    };
+    std::vector<double> residual(size);
+    std::vector<double> product(size);
+    multiply(temps_, product);
+    std::transform(std::cbegin(rhs), std::cend(rhs), std::cbegin(product), std::begin(residual), std::minus{});
+    std::vector<double> preconditioned(size);
+    precondition(residual, preconditioned);
+    auto direction = preconditioned;
+    auto rz = dot(residual, preconditioned);
+    const auto tolerance = CG_TOLERANCE * CG_TOLERANCE * dot(rhs, rhs);
+    for (std::size_t iter = 0; iter < 2 * size + 1 && dot(residual, residual) > tolerance; ++iter) {
+        multiply(direction, product);
+        const auto curvature = dot(direction, product);
+        if (curvature <= 0.) { break; }// Only in regions without a fixed temperature, which stay where they are
+        const auto alpha = rz / curvature;
+        for (std::size_t i = 0; i < size; ++i) {
+            temps_[i] += alpha * direction[i];
+            residual[i] -= alpha * product[i];
+        }
+        precondition(residual, preconditioned);
+        const auto next_rz = dot(residual, preconditioned);
+        const auto beta = next_rz / rz;
+        rz = next_rz;
+        for (std::size_t i = 0; i < size; ++i) { direction[i] = preconditioned[i] + beta * direction[i]; }
+    }
+}
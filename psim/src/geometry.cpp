@@ -4,9 +4,13 @@
 
 #include <algorithm>// for minmax, any_of
 #include <array>// for array, array<>::value_type
-#include <cmath>// for fabs, sqrt
-#include <iterator>// for cbegin, cend
+#include <cmath>// for fabs, fma, sqrt
+#include <iterator>// for cbegin, cend, back_inserter
+#include <limits>// for numeric_limits
+#include <numbers>// for pi
+#include <ranges>// for views::transform
 #include <sstream>// for basic_ostringstream
+#include <tuple>// for tie
 #include <type_traits>// for add_const<>::type
 
 namespace Geometry {
@@ -16,11 +20,17 @@ namespace Geometry {
 [[nodiscard]] static bool isPointOnLine(const Line& line, const Point& p) noexcept;// NOLINT
 [[nodiscard]] static bool isPointRightOfLine(const Line& line, const Point& p) noexcept;// NOLINT
 [[nodiscard]] static bool doesSegmentCrossLine(const Line& l1, const Line& l2) noexcept;// NOLINT
+[[nodiscard]] static bool edgesCross(const Line& line1, const Line& line2) noexcept;
 [[nodiscard]] static double crossProduct(const Point& p1, const Point& p2) noexcept;// NOLINT
 [[nodiscard]] static double dotProduct(const Point& p1, const Point& p2) noexcept;// NOLINT
 [[nodiscard]] static double getLineLength(const Line& line) noexcept;
 [[nodiscard]] static double getSlope(const Point& p1, const Point& p2) noexcept;// NOLINT
 [[nodiscard]] static double getIntercept(double x, double y, double slope) noexcept;// NOLINT
+[[nodiscard]] static double exactOrient2d(const Point& a, const Point& b, const Point& c) noexcept;// NOLINT
+
+// Relative error bound of the floating point orientation determinant (Shewchuk's ccwerrboundA)
+constexpr double ORIENT_ERR_BOUND{ (3. + 16. * std::numeric_limits<double>::epsilon() / 2.)
+                                   * std::numeric_limits<double>::epsilon() / 2. };
 
 std::ostream& operator<<(std::ostream& os, const Point& point) {// NOLINT
     os << "Point (" << point.x << ", " << point.y << ')';
@@ -42,6 +52,25 @@ bool operator!=(const Point& lhs, const Point& rhs) {
     return !(lhs == rhs);
 }
 
+double orient2d(const Point& a, const Point& b, const Point& c) noexcept {// NOLINT
+    const double det_left = (a.x - c.x) * (b.y - c.y);
+    const double det_right = (a.y - c.y) * (b.x - c.x);
+    const double det = det_left - det_right;
+    // The sign is only in doubt when both products have the same sign and nearly cancel
+    double det_sum = 0.;
+    if (det_left > 0.) {
+        if (det_right <= 0.) { return det; }
+        det_sum = det_left + det_right;
+    } else if (det_left < 0.) {
+        if (det_right >= 0.) { return det; }
+        det_sum = -det_left - det_right;
+    } else {
+        return det;
+    }
+    if (std::fabs(det) >= ORIENT_ERR_BOUND * det_sum) { return det; }
+    return exactOrient2d(a, b, c);
+}
+
 Line::Line(Point pt1, Point pt2)// NOLINT
     : p1{ pt1 }
     , p2{ pt2 }
@@ -165,21 +194,12 @@ Triangle::Triangle(Point pt1, Point pt2, Point pt3)
 // or along parallel lines are not counted. This is used to build the model and ensure
 // cell placement is valid.
 bool Triangle::intersects(const Triangle& other) const noexcept {// NOLINT
-    const auto intersect = [](const Line& line1, const Line& line2) {
-        auto intersects = false;
-        const auto poi = line1.getIntersection(line2);// This function returns std::nullopt for overlapping || lines
-        if (poi) {
-            // Don't count intersections at the end points
-            if (!(*poi == line1.p1 || *poi == line1.p2 || *poi == line2.p1 || *poi == line2.p2)) { intersects = true; }
-        }
-        return intersects;
-    };
     const auto& this_lines = lines();
     const auto& other_lines = other.lines();
     // Check if any of the sides intersect
     for (const auto& line1 : this_lines) {
         if (std::any_of(std::cbegin(other_lines), std::cend(other_lines), [&](const auto& line2) {
-                return intersect(line1, line2);
+                return edgesCross(line1, line2);
             })) {
             return true;
         }
@@ -256,6 +276,16 @@ double Triangle::area() const noexcept {// NOLINT
     return sqrt(p * (p - a) * (p - b) * (p - c));
 }
 
+Point Triangle::centroid() const noexcept {
+    return { (p1.x + p2.x + p3.x) / 3., (p1.y + p2.y + p3.y) / 3. };// NOLINT
+}
+
+PointPair Triangle::boundingBox() const noexcept {
+    const auto [min_x, max_x] = std::minmax({ p1.x, p2.x, p3.x });
+    const auto [min_y, max_y] = std::minmax({ p1.y, p2.y, p3.y });
+    return { { min_x, min_y }, { max_x, max_y } };
+}
+
 // TODO: This misses some cases -> Example: [T1] [(0,0), (10,0), (0, 10)] & [T2] [(0,1), (10,0), (0,10)]
 // TODO: Catch cases where all 3 points are on the edges of existing triangle (2 is ok - transition surface)
 // Returns true if the other triangle is at all (partially or fully) contained within this triangle
@@ -268,6 +298,248 @@ std::ostream& operator<<(std::ostream& os, const Triangle& triangle) {// NOLINT
     return os;
 }
 
+Polygon::Polygon(const std::vector<Point>& pts)// NOLINT
+    : points{ std::cbegin(pts), std::cend(pts) } {
+    const auto num_points = points.size();
+    if (num_points < 3) { throw PolygonError(points); }
+    // A convex polygon turns the same way at every vertex and only goes around once
+    double prev_turn = 0.;
+    double total_turn = 0.;
+    for (std::size_t i = 0; i < num_points; ++i) {
+        const auto& pa = points[i];
+        const auto& pb = points[(i + 1) % num_points];
+        const auto& pc = points[(i + 2) % num_points];
+        if (pa == pb) { throw PolygonError(points); }
+        const auto turn = crossProduct(pb - pa, pc - pb);
+        if (turn == 0. || turn * prev_turn < 0.) { throw PolygonError(points); }
+        prev_turn = turn;
+        total_turn += std::fabs(std::atan2(turn, dotProduct(pb - pa, pc - pb)));
+    }
+    if (total_turn > 2. * std::numbers::pi + GEOEPS) { throw PolygonError(points); }
+
+    fan_areas_.reserve(num_points - 2);
+    for (std::size_t i = 1; i + 1 < num_points; ++i) {
+        area_ += std::fabs(crossProduct(points[i] - points[0], points[i + 1] - points[0])) / 2.;
+        fan_areas_.push_back(area_);
+    }
+    std::ranges::transform(fan_areas_, std::begin(fan_areas_), [this](double area) { return area / area_; });
+    fan_areas_.back() = 1.;
+    clockwise_ = prev_turn < 0.;
+}
+
+Polygon::Polygon(const Triangle& triangle)
+    : Polygon(std::vector<Point>{ triangle.p1, triangle.p2, triangle.p3 }) {
+}
+
+Polygon::Polygon(const Polygon& other, std::pmr::memory_resource* resource)
+    : points{ other.points, resource }
+    , area_{ other.area_ }
+    , clockwise_{ other.clockwise_ }
+    , fan_areas_{ other.fan_areas_, resource } {
+}
+
+std::vector<Line> Polygon::lines() const {
+    std::vector<Line> edges;
+    edges.reserve(points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) { edges.emplace_back(points[i], points[(i + 1) % points.size()]); }
+    return edges;
+}
+
+Point Polygon::centroid() const noexcept {
+    // Area weighted centroid of the fan triangles
+    double x = 0.;// NOLINT
+    double y = 0.;// NOLINT
+    double prev_share = 0.;
+    for (std::size_t i = 1; i + 1 < points.size(); ++i) {
+        const auto share = fan_areas_[i - 1] - prev_share;
+        prev_share = fan_areas_[i - 1];
+        x += share * (points[0].x + points[i].x + points[i + 1].x) / 3.;// NOLINT
+        y += share * (points[0].y + points[i].y + points[i + 1].y) / 3.;// NOLINT
+    }
+    return { x, y };
+}
+
+PointPair Polygon::boundingBox() const noexcept {
+    const auto [min_x, max_x] = std::ranges::minmax(points | std::views::transform(&Point::x));
+    const auto [min_y, max_y] = std::ranges::minmax(points | std::views::transform(&Point::y));
+    return { { min_x, min_y }, { max_x, max_y } };
+}
+
+bool Polygon::intersects(const Polygon& other) const {
+    const auto& this_lines = lines();
+    const auto& other_lines = other.lines();
+    return std::ranges::any_of(this_lines, [&other_lines](const auto& line1) {
+        return std::ranges::any_of(other_lines, [&line1](const auto& line2) { return edgesCross(line1, line2); });
+    });
+}
+
+bool Polygon::contains(const Polygon& other) const noexcept {// NOLINT
+    return std::ranges::any_of(other.points, [this](const auto& p) { return contains(p); });
+}
+
+// The point must be further than GEOEPS inside every edge
+bool Polygon::contains(const Point& p) const noexcept {// NOLINT
+    const double inside = isClockwise() ? -1. : 1.;
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        const auto& pa = points[i];
+        const auto& pb = points[(i + 1) % points.size()];
+        const auto edge = pb - pa;
+        if (inside * crossProduct(edge, p - pa) < GEOEPS * std::sqrt(dotProduct(edge, edge))) { return false; }
+    }
+    return true;
+}
+
+std::optional<EdgeCrossing> Polygon::exitCrossing(const Point& start, const Point& end) const noexcept {
+    // Walking around a counterclockwise polygon, the vertices switch from the right of the segment to its left
+    // exactly once in front of the segment (and back again behind it)
+    const double left = clockwise_ ? -1. : 1.;
+    const auto num_points = points.size();
+    bool prev_left = left * orient2d(start, end, points[0]) > 0.;
+    for (std::size_t i = 0; i < num_points; ++i) {
+        const auto& pa = points[i];
+        const auto& pb = points[(i + 1) % num_points];
+        const bool next_left = left * orient2d(start, end, pb) > 0.;
+        if (!prev_left && next_left) {
+            const auto path = end - start;
+            const auto edge = pb - pa;
+            const auto denom = crossProduct(path, edge);
+            if (denom == 0.) { return std::nullopt; }
+            const auto fraction = std::max(crossProduct(pa - start, edge) / denom, 0.);
+            if (fraction > 1.) { return std::nullopt; }
+            const auto along = std::clamp(crossProduct(pa - start, path) / denom, 0., 1.);
+            return EdgeCrossing{ i, fraction, { pa.x + along * edge.x, pa.y + along * edge.y } };
+        }
+        prev_left = next_left;
+    }
+    return std::nullopt;// Every vertex is on the same side - the segment has no length
+}
+
+std::optional<Polygon> Polygon::clip(const Line& line) const {
+    // Signed distance from the line - snapped to 0 within GEOEPS so vertices on the line are not cut off as slivers
+    auto side = [&line](const Point& p) {
+        const double distance = orient2d(line.p1, line.p2, p) / line.length;
+        return (std::fabs(distance) < GEOEPS) ? 0. : distance;
+    };
+    std::vector<Point> clipped;
+    clipped.reserve(points.size() + 1);
+    for (std::size_t i = 0; i < points.size(); ++i) {
+        const auto& pa = points[i];
+        const auto& pb = points[(i + 1) % points.size()];
+        const double side_a = side(pa);
+        const double side_b = side(pb);
+        if (side_a >= 0.) { clipped.push_back(pa); }
+        // The edge crosses the line - a convex polygon is cut by at most two such edges
+        if ((side_a > 0. && side_b < 0.) || (side_a < 0. && side_b > 0.)) {
+            const double t = side_a / (side_a - side_b);
+            clipped.push_back({ pa.x + t * (pb.x - pa.x), pa.y + t * (pb.y - pa.y) });
+        }
+    }
+    // A crossing within GEOEPS of a kept vertex duplicates it
+    clipped.erase(std::unique(std::begin(clipped), std::end(clipped)), std::end(clipped));
+    if (clipped.size() > 1 && clipped.front() == clipped.back()) { clipped.pop_back(); }
+    if (clipped.size() < 3 || std::ranges::all_of(points, [&side](const auto& p) { return side(p) <= 0.; })) {
+        return std::nullopt;
+    }
+    return Polygon{ clipped };
+}
+
+std::optional<Polygon> Polygon::intersection(const Polygon& other) const {
+    // Clip by every edge of other, directed so that the inside of other is on the left
+    std::optional<Polygon> overlap{ *this };
+    const auto num_points = other.points.size();
+    for (std::size_t i = 0; i < num_points && overlap; ++i) {
+        const auto& pa = other.points[i];
+        const auto& pb = other.points[(i + 1) % num_points];
+        overlap = overlap->clip(other.clockwise_ ? Line{ pb, pa } : Line{ pa, pb });
+    }
+    return overlap;
+}
+
+Point Polygon::getRandPoint(double r1, double r2) const noexcept {// NOLINT
+    // r1 picks the fan triangle and is then rescaled to a uniform number within that triangle's share
+    const auto index = std::min(static_cast<std::size_t>(std::distance(
+                                    std::cbegin(fan_areas_), std::ranges::upper_bound(fan_areas_, r1))),
+        fan_areas_.size() - 1);
+    const double low = (index == 0) ? 0. : fan_areas_[index - 1];
+    r1 = (r1 - low) / (fan_areas_[index] - low);
+    if (r1 + r2 > 1.) {
+        r1 = 1 - r1;
+        r2 = 1 - r2;
+    }
+    const auto& p1 = points[0];
+    const auto& p2 = points[index + 1];
+    const auto& p3 = points[index + 2];
+    const auto x = p1.x + (p2.x - p1.x) * r1 + (p3.x - p1.x) * r2;// NOLINT
+    const auto y = p1.y + (p2.y - p1.y) * r1 + (p3.y - p1.y) * r2;// NOLINT
+    return { x, y };
+}
+
+bool Polygon::operator==(const Polygon& rhs) const {
+    return points.size() == rhs.points.size() && std::ranges::all_of(points, [&rhs](const auto& p) {
+        return std::ranges::find(rhs.points, p) != std::cend(rhs.points);
+    });
+}
+
+std::ostream& operator<<(std::ostream& os, const Polygon& polygon) {// NOLINT
+    os << "Polygon: [";
+    for (std::size_t i = 0; i < polygon.points.size(); ++i) { os << ((i == 0) ? "" : ", ") << polygon.points[i]; }
+    os << ']';
+    return os;
+}
+
+Transform::Transform(double degrees, Vector2D offset)// NOLINT
+    : offset_{ offset } {
+    constexpr double QUARTER_TURN{ 90. };
+    if (const auto quarter_turns = std::round(degrees / QUARTER_TURN); quarter_turns * QUARTER_TURN == degrees) {
+        constexpr std::array<std::pair<double, double>, 4> exact{
+            { { 1., 0. }, { 0., 1. }, { -1., 0. }, { 0., -1. } }
+        };
+        const auto turn = static_cast<std::size_t>(std::fmod(std::fmod(quarter_turns, 4.) + 4., 4.));
+        std::tie(cos_, sin_) = exact.at(turn);
+    } else {
+        const double radians = degrees * std::numbers::pi / 180.;// NOLINT
+        cos_ = std::cos(radians);
+        sin_ = std::sin(radians);
+    }
+}
+
+Transform Transform::reflection(const Line& axis) noexcept {
+    // Reflecting about a line at angle a to the x axis is a reflection about the x axis followed by a rotation of 2a.
+    // The double angle is taken from the direction of the axis so that no trigonometry is involved.
+    const double dx = axis.p2.x - axis.p1.x;
+    const double dy = axis.p2.y - axis.p1.y;
+    const double length_sq = dx * dx + dy * dy;
+    Transform transform;
+    transform.cos_ = (dx * dx - dy * dy) / length_sq;
+    transform.sin_ = 2. * dx * dy / length_sq;
+    transform.reflect_ = true;
+    // Points on the axis stay in place
+    const auto image = transform.apply(Vector2D{ axis.p1.x, axis.p1.y });
+    transform.offset_ = { axis.p1.x - image.x, axis.p1.y - image.y };
+    return transform;
+}
+
+Point Transform::apply(const Point& p) const noexcept {// NOLINT
+    const auto v = apply(Vector2D{ p.x, p.y });
+    return { v.x + offset_.x, v.y + offset_.y };
+}
+
+Vector2D Transform::apply(const Vector2D& v) const noexcept {// NOLINT
+    const double y = reflect_ ? -v.y : v.y;
+    return { cos_ * v.x - sin_ * y, sin_ * v.x + cos_ * y };
+}
+
+Line Transform::apply(const Line& line) const {
+    return { apply(line.p1), apply(line.p2) };
+}
+
+Polygon Transform::apply(const Polygon& polygon) const {
+    std::vector<Point> points;
+    points.reserve(polygon.points.size());
+    std::ranges::transform(polygon.points, std::back_inserter(points), [this](const auto& p) { return apply(p); });
+    return Polygon{ points };
+}
+
 PointPair findBoundingBox(const Line& line) noexcept {
     const auto& [p1, p2] = line.getPoints();
     // Bottom left point of bounding box - assume it is p1
@@ -307,6 +579,12 @@ bool doesSegmentCrossLine(const Line& l1, const Line& l2) noexcept {// NOLINT
            || ((isPointRightOfLine(l1, l2.p1) ^ isPointRightOfLine(l1, l2.p2)) != 0);
 }
 
+// Intersections at the end points or along parallel lines are not counted
+bool edgesCross(const Line& line1, const Line& line2) noexcept {
+    const auto poi = line1.getIntersection(line2);// This function returns std::nullopt for overlapping || lines
+    return poi && !(*poi == line1.p1 || *poi == line1.p2 || *poi == line2.p1 || *poi == line2.p2);
+}
+
 double crossProduct(const Point& p1, const Point& p2) noexcept {// NOLINT
     return p1.x * p2.y - p2.x * p1.y;
 }
@@ -344,4 +622,56 @@ TriangleError::TriangleError(const Geometry::Triangle& triangle)
     setMessage("These 3 points do not allow for a valid triangle -> " + os.str());
 }
 
+PolygonError::PolygonError(std::span<const Point> points) {
+    std::ostringstream os;// NOLINT
+    for (const auto& point : points) { os << point << ' '; }
+    setMessage("These points do not allow for a valid convex polygon -> " + os.str());
+}
+
+// Evaluates the orientation determinant as a sum of error free terms - a + b (a * b) is exactly hi + lo. The terms
+// are accumulated into a nonoverlapping expansion whose largest component has the sign of the exact determinant.
+double exactOrient2d(const Point& a, const Point& b, const Point& c) noexcept {// NOLINT
+    auto two_sum = [](double x, double y) {// NOLINT
+        const double hi = x + y;
+        const double y_virtual = hi - x;
+        const double x_virtual = hi - y_virtual;
+        return std::pair{ hi, (x - x_virtual) + (y - y_virtual) };
+    };
+    auto two_product = [](double x, double y) {// NOLINT
+        const double hi = x * y;
+        return std::pair{ hi, std::fma(x, y, -hi) };
+    };
+
+    const auto [acx, acx_lo] = two_sum(a.x, -c.x);
+    const auto [bcy, bcy_lo] = two_sum(b.y, -c.y);
+    const auto [acy, acy_lo] = two_sum(a.y, -c.y);
+    const auto [bcx, bcx_lo] = two_sum(b.x, -c.x);
+    const std::array<std::pair<double, double>, 8> products{ two_product(acx, bcy),
+        two_product(acx, bcy_lo),
+        two_product(acx_lo, bcy),
+        two_product(acx_lo, bcy_lo),
+        two_product(-acy, bcx),
+        two_product(-acy, bcx_lo),
+        two_product(-acy_lo, bcx),
+        two_product(-acy_lo, bcx_lo) };
+
+    std::array<double, 2 * products.size() + 1> expansion{};
+    std::size_t length = 0;
+    auto grow = [&](double term) {
+        std::size_t next = 0;
+        for (std::size_t i = 0; i < length; ++i) {
+            const auto [sum, error] = two_sum(term, expansion[i]);// NOLINT
+            term = sum;
+            if (error != 0.) { expansion[next++] = error; }// NOLINT
+        }
+        if (term != 0.) { expansion[next++] = term; }// NOLINT
+        length = next;
+    };
+    for (const auto& [hi, lo] : products) {
+        grow(lo);
+        grow(hi);
+    }
+    return (length == 0) ? 0. : expansion[length - 1];// NOLINT
+}
+
 }// namespace Geometry
@@ -0,0 +1,26 @@
+#include "psim/geometryTemplate.h"
+#include "psim/cell.h"
+#include <algorithm>
+
+void GeometryTemplate::addCell(const Geometry::Polygon& polygon, std::size_t sensor, double specularity) {
+    const auto lines = polygon.lines();
+    for (std::size_t index = 0; index < cells_.size(); ++index) {
+        const auto& existing = cells_[index].polygon;
+        if (existing == polygon) { throw std::runtime_error(std::string("Duplicate cell detected in template.\n")); }
+        if (existing.intersects(polygon)) { throw IntersectError(existing, polygon); }
+        if (existing.contains(polygon)) { throw OverlapError(existing, polygon); }
+        if (polygon.contains(existing)) { throw OverlapError(polygon, existing); }
+        // Same rule as Cell::findTransitionSurface - the shorter of two overlapping edges is the shared edge
+        for (const auto& l1 : existing.lines()) {// NOLINT
+            for (const auto& l2 : lines) {// NOLINT
+                if (l1.contains(l2)) {
+                    links_.push_back({ cells_.size(), index, l2 });
+                } else if (l2.contains(l1)) {
+                    links_.push_back({ cells_.size(), index, l1 });
+                }
+            }
+        }
+    }
+    cells_.push_back({ polygon, sensor, specularity });
+    num_sensors_ = std::max(num_sensors_, sensor + 1);
+}
@@ -1,35 +1,451 @@
-
 #include "psim/inputManager.h"
 #include "psim/geometry.h"
+#include "psim/geometryTemplate.h"
+#include "psim/meshImporter.h"
+#include "psim/mesher.h"
 #include "psim/model.h"
 #include "psim/sensor.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <nlohmann/json.hpp>
+#include <ranges>
+#include <streambuf>
+#include <unordered_map>
 
 using json = nlohmann::json;
 using Point = Geometry::Point;
 using Triangle = Geometry::Triangle;
+using Polygon = Geometry::Polygon;
 
-std::optional<Model> InputManager::deserialize(const std::filesystem::path& filepath) {// NOLINT
+namespace {
+
+// A mesh file referenced by the "mesh" entry of the input file along with the sensor and specularity of each
+// element. Regions without a fixed sensor generate one sensor per element.
+struct MeshInput {
+    struct GeneratedSensor {
+        std::size_t id;
+        std::string material;
+        double t_init;
+    };
+
+    Mesh mesh;
+    std::vector<std::size_t> sensor_ids;
+    std::vector<double> specs;
+    std::vector<GeneratedSensor> sensors;
+};
+
+/**
+ * @param next_id - The first ID available for sensors generated for the mesh
+ */
+MeshInput loadMesh(const std::filesystem::path& json_path, const json& m_data, std::size_t next_id) {
+    MeshInput input{ MeshImporter::read(json_path.parent_path() / m_data.at("file").get<std::string>()), {}, {}, {} };
+    const auto& mesh = input.mesh;
+    // Physical groups may be referenced by tag or (Gmsh only) by name
+    auto groupOf = [&mesh](const json& group) {
+        if (group.is_string()) {
+            const auto tag = mesh.group_names.find(group.get<std::string>());
+            if (tag == std::cend(mesh.group_names)) {
+                throw std::runtime_error("Unknown mesh physical group " + group.dump() + '\n');
+            }
+            return tag->second;
+        }
+        return group.get<int>();
+    };
+
+    std::unordered_map<int, const json*> regions;
+    const json* default_region = nullptr;
+    for (const auto& r_data : m_data.at("regions")) {
+        if (r_data.contains("group")) {
+            regions[groupOf(r_data.at("group"))] = &r_data;
+        } else {
+            default_region = &r_data;
+        }
+    }
+
+    input.sensor_ids.reserve(mesh.elements.size());
+    input.specs.reserve(mesh.elements.size());
+    for (const auto& element : mesh.elements) {
+        const auto region = regions.find(element.group);
+        const auto* r_data = (region == std::cend(regions)) ? default_region : region->second;
+        if (r_data == nullptr) {
+            throw std::runtime_error("Mesh group " + std::to_string(element.group) + " is not mapped to a region.\n");
+        }
+        input.specs.push_back(r_data->value("specularity", 1.));
+        if (r_data->contains("sensor")) {
+            input.sensor_ids.push_back(r_data->at("sensor"));
+        } else {
+            input.sensors.push_back({ next_id, r_data->at("material"), r_data->at("t_init") });
+            input.sensor_ids.push_back(next_id++);
+        }
+    }
+    return input;
+}
+
+[[nodiscard]] Point getPoint(const json& p_data) {
+    return { p_data.at("x"), p_data.at("y") };
+}
+
+[[nodiscard]] std::vector<Point> getLoop(const json& l_data) {
+    std::vector<Point> points;
+    points.reserve(l_data.size());
+    for (const auto& p_data : l_data) { points.push_back(getPoint(p_data)); }
+    return points;
+}
+
+/**
+ * Meshes the polygons of the "domains" entry. A domain uses a fixed "sensor" or generates sensors on a
+ * "sensor_grid" of nx by ny (or dx by dy sized) bins over its bounding box, one sensor per bin that holds element
+ * centroids. Without either, the whole domain is one sensor.
+ * @param next_id - The first ID available for sensors generated for the domains
+ */
+MeshInput meshDomains(const json& d_data, std::size_t next_id) {
+    std::vector<MeshDomain> domains;
+    for (const auto& domain : d_data) {
+        std::vector<std::vector<Point>> holes;
+        for (const auto& h_data : domain.value("holes", json::array())) { holes.push_back(getLoop(h_data)); }
+        domains.push_back({ getLoop(domain.at("boundary")), std::move(holes), domain.at("size") });
+    }
+    MeshInput input{ Mesher::triangulate(domains), {}, {}, {} };
+    const auto& mesh = input.mesh;
+
+    // Sensor grid of each domain and the sensor ID of each bin, NONE if no element falls into it
+    constexpr auto NONE = std::numeric_limits<std::size_t>::max();
+    struct SensorGrid {
+        Point origin;
+        double dx;
+        double dy;
+        std::size_t nx;
+        std::size_t ny;
+        std::vector<std::size_t> ids;
+    };
+    std::vector<SensorGrid> grids;
+    for (std::size_t d = 0; d < domains.size(); ++d) {
+        const auto& domain = d_data[d];
+        const auto& boundary = domains[d].boundary;
+        const auto [left, right] = std::ranges::minmax(boundary | std::views::transform(&Point::x));
+        const auto [bottom, top] = std::ranges::minmax(boundary | std::views::transform(&Point::y));
+        const auto width = right - left;
+        const auto height = top - bottom;
+        auto binsOf = [](const json& g_data, const char* count, const char* size, double extent) {
+            if (g_data.contains(size)) {
+                const auto bins = std::ceil(extent / g_data.at(size).get<double>());
+                return std::max<std::size_t>(1, static_cast<std::size_t>(bins));
+            }
+            return std::max<std::size_t>(1, g_data.value(count, std::size_t{ 1 }));
+        };
+        const auto& g_data = domain.value("sensor_grid", json::object());
+        const auto nx = binsOf(g_data, "nx", "dx", width);
+        const auto ny = binsOf(g_data, "ny", "dy", height);
+        grids.push_back({ { left, bottom },
+            width / static_cast<double>(nx),
+            height / static_cast<double>(ny),
+            nx,
+            ny,
+            std::vector<std::size_t>(nx * ny, NONE) });
+    }
+    auto domainOf = [](const Mesh::Element& element) { return static_cast<std::size_t>(element.group - 1); };
+    auto binOf = [&](const Mesh::Element& element) -> std::size_t& {
+        auto& grid = grids[domainOf(element)];
+        const auto centroid = mesh.triangle(element).centroid();
+        auto clampedBin = [](double offset, double size, std::size_t count) {
+            return std::min(static_cast<std::size_t>(std::max(offset / size, 0.)), count - 1);
+        };
+        return grid.ids[clampedBin(centroid.x - grid.origin.x, grid.dx, grid.nx)
+                        + grid.nx * clampedBin(centroid.y - grid.origin.y, grid.dy, grid.ny)];
+    };
+    // Bins holding an element are marked, then numbered domain by domain and row by row
+    for (const auto& element : mesh.elements) { binOf(element) = 0; }
+    for (std::size_t d = 0; d < domains.size(); ++d) {
+        const auto& domain = d_data[d];
+        if (domain.contains("sensor")) { continue; }
+        for (auto& id : grids[d].ids) {
+            if (id == NONE) { continue; }
+            input.sensors.push_back({ next_id, domain.at("material"), domain.at("t_init") });
+            id = next_id++;
+        }
+    }
+
+    input.sensor_ids.reserve(mesh.elements.size());
+    input.specs.reserve(mesh.elements.size());
+    for (const auto& element : mesh.elements) {
+        const auto& domain = d_data[domainOf(element)];
+        input.specs.push_back(domain.value("specularity", 1.));
+        input.sensor_ids.push_back(domain.contains("sensor") ? domain.at("sensor").get<std::size_t>() : binOf(element));
+    }
+    return input;
+}
 
-    // ************************ Helper methods **********************************
-    auto buildModel = [](std::size_t num_cells, std::size_t num_sensors, const auto& s_data) {
+// Passes characters through from the file buffer while counting the lines read so far
+class LineCountingBuffer : public std::streambuf {
+public:
+    explicit LineCountingBuffer(std::streambuf* source)
+        : source_{ source } {
+    }
+    [[nodiscard]] std::size_t line() const noexcept {
+        return line_;
+    }
+
+protected:
+    int_type underflow() override {
+        return source_->sgetc();
+    }
+    int_type uflow() override {
+        const auto c = source_->sbumpc();
+        if (traits_type::eq_int_type(c, traits_type::to_int_type('\n'))) { ++line_; }
+        return c;
+    }
+
+private:
+    std::streambuf* source_;
+    std::size_t line_{ 1 };
+};
+
+// An error in the input file along with the line of the entry that caused it
+class InputError : public std::runtime_error {
+public:
+    InputError(std::size_t line, const std::string& message)
+        : std::runtime_error{ message }
+        , line_{ line } {
+    }
+    [[nodiscard]] std::size_t line() const noexcept {
+        return line_;
+    }
+
+private:
+    std::size_t line_;
+};
+
+// Top level entries of the input file in the order they must be added to the model
+enum class Section : std::size_t {
+    Settings,
+    Materials,
+    Sensors,
+    Cells,
+    Templates,
+    Instances,
+    Mesh,
+    Domains,
+    EmitSurfaces,
+    PeriodicSurfaces
+};
+constexpr std::size_t NUM_SECTIONS{ 10 };
+
+constexpr std::size_t index(Section section) noexcept {
+    return static_cast<std::size_t>(section);
+}
+
+/**
+ * Builds the model from the top level entries of the input file as they are read. Entries of a section depend on
+ * every section before it in Section (materials need the settings, cells need the sensors...). Entries are added
+ * to the model as soon as the sections they depend on are complete and are held back otherwise, so input files
+ * written in this order are never held in memory.
+ */
+class ModelBuilder {
+public:
+    explicit ModelBuilder(std::filesystem::path filepath)
+        : filepath_{ std::move(filepath) } {
+    }
+
+    // Sections whose arrays are passed to the builder element by element
+    [[nodiscard]] static bool isStreamed(const std::string& name) {
+        const auto section = sectionOf(name);
+        return section == Section::Sensors || section == Section::Cells || section == Section::Templates
+               || section == Section::Instances || section == Section::EmitSurfaces
+               || section == Section::PeriodicSurfaces;
+    }
+    // A complete top level entry
+    void addSection(const std::string& name, json&& data, std::size_t line) {
+        if (const auto section = sectionOf(name); section) {
+            if (isStreamed(name)) {
+                if (!data.is_array()) { throw InputError(line, "The " + name + " entry must be an array.\n"); }
+                for (auto& element : data) { addEntry(*section, std::move(element), line); }
+            } else {
+                addEntry(*section, std::move(data), line);
+            }
+            endSection(name);
+        }
+    }
+    // A single element of a streamed section
+    void addElement(const std::string& name, json&& data, std::size_t line) {
+        if (const auto section = sectionOf(name); section) { addEntry(*section, std::move(data), line); }
+    }
+    void endSection(const std::string& name) {
+        if (const auto section = sectionOf(name); section) {
+            complete_[index(*section)] = true;
+            flush();
+        }
+    }
+    // Adds any entries that are still held back and returns the finished model
+    [[nodiscard]] Model finish() {
+        complete_.fill(true);
+        flush();
+        if (!model_) { throw std::runtime_error(std::string("The input file does not contain any settings.\n")); }
+        if (reduce_symmetry_) { model_->reduceSymmetry(); }
+        model_->reorderCells();
+        return std::move(*model_);
+    }
+
+private:
+    struct Entry {
+        json data;
+        std::size_t line;
+    };
+
+    std::filesystem::path filepath_;
+    std::optional<Model> model_;
+    SimulationType type_{ SimulationType::SteadyState };
+    double t_eq_{ 0. };
+    bool reduce_symmetry_{ true };
+    bool gray_{ false };
+    std::size_t next_material_id_{ 0 };
+    std::size_t next_sensor_id_{ 0 };// Sensors generated for a mesh are numbered from here
+    std::array<bool, NUM_SECTIONS> complete_{};
+    std::array<std::vector<Entry>, NUM_SECTIONS> pending_;
+    std::unordered_map<std::string, GeometryTemplate> templates_;
+
+    [[nodiscard]] static std::optional<Section> sectionOf(const std::string& name) {
+        static const std::unordered_map<std::string, Section> sections{ { "settings", Section::Settings },
+            { "materials", Section::Materials },
+            { "sensors", Section::Sensors },
+            { "cells", Section::Cells },
+            { "templates", Section::Templates },
+            { "instances", Section::Instances },
+            { "mesh", Section::Mesh },
+            { "domains", Section::Domains },
+            { "emit_surfaces", Section::EmitSurfaces },
+            { "periodic_surfaces", Section::PeriodicSurfaces } };
+        const auto section = sections.find(name);
+        return (section == std::cend(sections)) ? std::nullopt : std::optional{ section->second };
+    }
+    [[nodiscard]] bool ready(Section section) const noexcept {
+        return std::all_of(std::cbegin(complete_), std::cbegin(complete_) + index(section), [](bool c) { return c; });
+    }
+    void addEntry(Section section, json&& data, std::size_t line) {
+        if (ready(section) && pending_[index(section)].empty()) {
+            apply(section, data, line);
+        } else {
+            pending_[index(section)].push_back({ std::move(data), line });
+        }
+    }
+    void flush() {
+        for (std::size_t section = 0; section < NUM_SECTIONS; ++section) {
+            if (!ready(static_cast<Section>(section))) { return; }
+            for (const auto& [data, line] : pending_[section]) { apply(static_cast<Section>(section), data, line); }
+            pending_[section].clear();
+        }
+    }
+    void apply(Section section, const json& data, std::size_t line) {
+        try {
+            if (section != Section::Settings && !model_) {
+                throw std::runtime_error(std::string("The input file does not contain any settings.\n"));
+            }
+            switch (section) {
+            case Section::Settings:
+                buildModel(data);
+                break;
+            case Section::Materials:
+                for (const auto& m_data : data) { addMaterial(m_data); }
+                break;
+            case Section::Sensors:
+                model_->addSensor(data.at("id"), data.at("material"), data.at("t_init"), type_);
+                next_sensor_id_ = std::max(next_sensor_id_, data.at("id").get<std::size_t>() + 1);
+                break;
+            case Section::Cells:
+                model_->addCell(getPolygon(data), data.at("sensorID"), data.at("specularity"));
+                break;
+            case Section::Templates:
+                addTemplate(data);
+                break;
+            case Section::Instances:
+                addInstance(data);
+                break;
+            case Section::Mesh:
+                addMesh(data);
+                break;
+            case Section::Domains:
+                addDomains(data);
+                break;
+            case Section::EmitSurfaces:
+                // TODO: better exception here
+                if (!model_->setEmitSurface(getPoint(data.at("p1")),
+                        getPoint(data.at("p2")),
+                        data.at("temp"),
+                        data.at("duration"),
+                        data.at("start_time"))) {
+                    throw std::runtime_error(std::string("Unable to add emitting surface.\n"));
+                }
+                break;
+            case Section::PeriodicSurfaces:
+                if (!model_->setPeriodicSurface(getPoint(data.at("p1")),
+                        getPoint(data.at("p2")),
+                        getPoint(data.at("q1")),
+                        getPoint(data.at("q2")))) {
+                    throw std::runtime_error(std::string("Unable to add periodic surface.\n"));
+                }
+                break;
+            default:
+                break;
+            }
+        } catch (const InputError&) { throw; } catch (const std::exception& e) {
+            throw InputError(line, e.what());
+        }
+    }
+
+    void buildModel(const json& s_data) {
+        type_ = [&s_data]() {
+            switch (static_cast<int>(s_data.at("sim_type"))) {
+            case 1:
+                return SimulationType::Periodic;
+            case 2:
+                return SimulationType::Transient;
+            default:
+                return SimulationType::SteadyState;
+            }
+        }();
+        t_eq_ = s_data.at("t_eq");
         const bool phasor_sim = s_data.at("phasor_sim").dump() == "true";
+        // The number of cells and sensors is not known until the file is read - the model storage grows instead
         ModelParams params{ 1,
-            num_cells,
-            num_sensors,
+            0,
+            0,
             s_data.at("num_measurements"),
             s_data.at("num_phonons"),
             s_data.at("sim_time"),
-            s_data.at("t_eq"),
+            t_eq_,
             phasor_sim };
         if (s_data.contains("num_runs")) { params.num_runs = s_data.at("num_runs"); }
+        if (s_data.contains("ensemble")) { params.ensemble = s_data.at("ensemble"); }
+        if (s_data.contains("target_temp_error")) { params.target_temp_error = s_data.at("target_temp_error"); }
+        if (s_data.contains("target_flux_error")) { params.target_flux_error = s_data.at("target_flux_error"); }
+        if (s_data.contains("time_budget")) { params.time_budget = s_data.at("time_budget"); }
+        if (s_data.contains("error_batches")) { params.error_batches = s_data.at("error_batches"); }
+        if (s_data.contains("symmetry_reduction")) { reduce_symmetry_ = s_data.at("symmetry_reduction"); }
+        if (s_data.contains("gray")) { gray_ = s_data.at("gray"); }
+        if (s_data.contains("importance_sampling")) { params.importance_sampling = s_data.at("importance_sampling"); }
+        if (s_data.contains("annihilation")) { params.annihilation = s_data.at("annihilation"); }
+        if (s_data.contains("kinetic")) { params.kinetic = s_data.at("kinetic"); }
+        if (s_data.contains("emission_bias")) { params.emission_bias = s_data.at("emission_bias"); }
+        if (s_data.contains("target_sensors")) {
+            params.target_sensors = s_data.at("target_sensors").get<std::vector<std::size_t>>();
+        }
+        if (s_data.contains("adjoint_sensors")) {
+            params.adjoint_sensors = s_data.at("adjoint_sensors").get<std::vector<std::size_t>>();
+        }
+        if (s_data.contains("diffusive_sensors")) {
+            params.diffusive_sensors = s_data.at("diffusive_sensors").get<std::vector<std::size_t>>();
+        }
+        if (s_data.contains("diffusive_knudsen")) { params.diffusive_knudsen = s_data.at("diffusive_knudsen"); }
+        model_.emplace(params);
+        // Set the model simulation type
+        (type_ == SimulationType::SteadyState) ? model_->setSimulationType(type_)
+                                               : model_->setSimulationType(type_, s_data.at("step_interval"));
+    }
 
-        return Model(params);
-    };
-
-    auto addMaterial = [](auto& model, double t_eq, const auto& m_data, std::size_t id) {// NOLINT
+    void addMaterial(const json& m_data) {
         const auto& jd_data = m_data.at("d_data");
         const auto& jr_data = m_data.at("r_data");
 
@@ -39,71 +455,234 @@ std::optional<Model> InputManager::deserialize(const std::filesystem::path& file
         const RelaxationData r_data{
             jr_data.at("b_l"), jr_data.at("b_tn"), jr_data.at("b_tu"), jr_data.at("b_i"), jr_data.at("w")
         };
-        auto material = Material(id, d_data, r_data);
-        if (t_eq == 0.) { material.setFullSimulation(); }
-        model.addMaterial(m_data.at("name"), material);
-    };
-
-    auto getPoint = [](const auto& p_data) { return Point{ p_data.at("x"), p_data.at("y") }; };
+        auto material = Material(next_material_id_++, d_data, r_data);
+        if (t_eq_ == 0.) { material.setFullSimulation(); }
+        if (gray_) { material.setGray(); }
+        model_->addMaterial(m_data.at("name"), material);
+    }
 
-    auto addCell = [&](auto& model, const auto& c_data) {
+    // Cells are either a "triangle" (p1, p2 & p3) or a convex "polygon" (array of points in perimeter order)
+    [[nodiscard]] static Polygon getPolygon(const json& c_data) {
+        if (c_data.contains("polygon")) {
+            return Polygon{ getLoop(c_data.at("polygon")) };
+        }
         const auto& t_data = c_data.at("triangle");
-        Triangle t{ getPoint(t_data.at("p1")), getPoint(t_data.at("p2")), getPoint(t_data.at("p3")) };// NOLINT
-        model.addCell(std::move(t), c_data.at("sensorID"), c_data.at("specularity"));// NOLINT
-    };
+        return Triangle{ getPoint(t_data.at("p1")), getPoint(t_data.at("p2")), getPoint(t_data.at("p3")) };
+    }
 
-    // ************************ End Helper methods **********************************
+    // Template cells are written like the cells section, with the sensorID giving a local sensor index
+    void addTemplate(const json& t_data) {
+        GeometryTemplate geometry;
+        for (const auto& c_data : t_data.at("cells")) {
+            geometry.addCell(getPolygon(c_data), c_data.at("sensorID"), c_data.at("specularity"));
+        }
+        if (!templates_.try_emplace(t_data.at("name"), std::move(geometry)).second) {
+            throw std::runtime_error(std::string("Template names must be unique.\n"));
+        }
+    }
 
-    if (is_regular_file(filepath)) {
-        if (std::ifstream file(filepath.string().data()); file.is_open()) {
-            try {
-                json jdata;
-                file >> jdata;
-
-                const auto& settings = jdata.at("settings");
-                const auto type = [&settings]() {
-                    switch (static_cast<int>(settings.at("sim_type"))) {
-                    case 1:
-                        return SimulationType::Periodic;
-                    case 2:
-                        return SimulationType::Transient;
-                    default:
-                        return SimulationType::SteadyState;
-                    }
-                }();
-
-                const auto& sensors = jdata.at("sensors");
-                const auto& cells = jdata.at("cells");
-                const auto t_eq = settings.at("t_eq");
-                // Generate the base model
-                Model model = buildModel(cells.size(), sensors.size(), settings);
-                // Set the model simulation type
-                (type == SimulationType::SteadyState) ? model.setSimulationType(type)
-                                                      : model.setSimulationType(type, settings.at("step_interval"));
-
-                const auto& materials = jdata.at("materials");
-                std::size_t material_id = 0;
-                // Incorporate material data into the model
-                for (const auto& m_data : materials) { addMaterial(model, t_eq, m_data, material_id++); }
-                // Add sensors to the model
-                for (const auto& s_data : sensors) {
-                    model.addSensor(s_data.at("id"), s_data.at("material"), s_data.at("t_init"), type);
+    // An instance places a template rotated counterclockwise by "rotation" degrees and then moved by "offset"
+    void addInstance(const json& i_data) {
+        const auto name = i_data.at("template").get<std::string>();
+        const auto geometry = templates_.find(name);
+        if (geometry == std::cend(templates_)) {
+            throw std::runtime_error("Template " + name + " does not exist.\n");
+        }
+        const auto offset = i_data.contains("offset") ? getPoint(i_data.at("offset")) : Point{ 0., 0. };
+        const Geometry::Transform transform{ i_data.value("rotation", 0.), { offset.x, offset.y } };
+        model_->addInstance(geometry->second, transform, i_data.at("sensors").get<std::vector<std::size_t>>());
+    }
+
+    // An external triangle mesh may be used alongside (or instead of) the python generated cells
+    void addMesh(const json& m_data) {
+        auto mesh_input = loadMesh(filepath_, m_data, next_sensor_id_);
+        for (const auto& [id, material, t_init] : mesh_input.sensors) { model_->addSensor(id, material, t_init, type_); }
+        next_sensor_id_ += mesh_input.sensors.size();
+        const auto& mesh = mesh_input.mesh;
+        model_->addMesh(mesh, mesh_input.sensor_ids, mesh_input.specs);
+        if (!m_data.contains("emit_surfaces")) { return; }
+        // Boundary edges in an emitting group become emitting surfaces
+        for (const auto& s_data : m_data.at("emit_surfaces")) {
+            const auto& group = s_data.at("group");
+            const int tag = group.is_string() ? mesh.group_names.at(group.get<std::string>()) : group.get<int>();
+            for (const auto& edge : mesh.edges) {
+                if (edge.group == tag
+                    && !model_->setEmitSurface(mesh.nodes[edge.nodes[0]],
+                        mesh.nodes[edge.nodes[1]],
+                        s_data.at("temp"),
+                        s_data.at("duration"),
+                        s_data.at("start_time"))) {
+                    throw std::runtime_error(std::string("Unable to add mesh emitting surface.\n"));
                 }
-                // Add cells to the model
-                for (const auto& c_data : cells) { addCell(model, c_data); }
-                const auto& surfaces = jdata.at("emit_surfaces");
-                // Add the emitting surfaces to the model
-                for (const auto& s_data : surfaces) {
-                    // TODO: better exception here
-                    if (!model.setEmitSurface(getPoint(s_data.at("p1")),
-                            getPoint(s_data.at("p2")),
+            }
+        }
+    }
+    // Polygonal domains meshed in place of python generated cells
+    void addDomains(const json& d_data) {
+        auto mesh_input = meshDomains(d_data, next_sensor_id_);
+        for (const auto& [id, material, t_init] : mesh_input.sensors) { model_->addSensor(id, material, t_init, type_); }
+        next_sensor_id_ += mesh_input.sensors.size();
+        const auto& mesh = mesh_input.mesh;
+        model_->addMesh(mesh, mesh_input.sensor_ids, mesh_input.specs);
+        // Boundary edges along an emitting segment of a domain become emitting surfaces
+        for (const auto& domain : d_data) {
+            for (const auto& s_data : domain.value("emit_surfaces", json::array())) {
+                const Geometry::Line line{ getPoint(s_data.at("p1")), getPoint(s_data.at("p2")) };
+                bool found = false;
+                for (const auto& edge : mesh.edges) {
+                    const Geometry::Line boundary{ mesh.nodes[edge.nodes[0]], mesh.nodes[edge.nodes[1]] };
+                    if (!line.contains(boundary)) { continue; }
+                    if (!model_->setEmitSurface(boundary.p1,
+                            boundary.p2,
                             s_data.at("temp"),
                             s_data.at("duration"),
                             s_data.at("start_time"))) {
-                        throw std::runtime_error(std::string("Unable to add emitting surface.\n"));
+                        throw std::runtime_error(std::string("Unable to add domain emitting surface.\n"));
                     }
+                    found = true;
+                }
+                if (!found) {
+                    throw std::runtime_error(std::string("Domain emitting surface is not on a domain boundary.\n"));
                 }
-                return model;
+            }
+        }
+    }
+};
+
+/**
+ * SAX handler that splits the input file into its top level entries. Each entry is assembled into a small json
+ * value and handed to the builder once it is complete. Arrays of the streamed sections are handed over element by
+ * element so that only one cell (sensor...) is held in memory at a time.
+ */
+class SectionReader {
+public:
+    SectionReader(ModelBuilder& builder, const LineCountingBuffer& lines)
+        : builder_{ builder }
+        , lines_{ lines } {
+    }
+
+    bool null() {
+        return value(nullptr);
+    }
+    bool boolean(bool val) {
+        return value(val);
+    }
+    bool number_integer(json::number_integer_t val) {
+        return value(val);
+    }
+    bool number_unsigned(json::number_unsigned_t val) {
+        return value(val);
+    }
+    bool number_float(json::number_float_t val, const json::string_t& /*unused*/) {
+        return value(val);
+    }
+    bool string(json::string_t& val) {
+        return value(std::move(val));
+    }
+    bool binary(json::binary_t& val) {
+        return value(json::binary(std::move(val)));
+    }
+    bool start_object(std::size_t /*unused*/) {
+        return open(json::object());
+    }
+    bool key(json::string_t& val) {
+        (depth_ == 1) ? section_ = std::move(val) : key_ = std::move(val);
+        return true;
+    }
+    bool end_object() {
+        return close();
+    }
+    bool start_array(std::size_t /*unused*/) {
+        return open(json::array());
+    }
+    bool end_array() {
+        return close();
+    }
+    // Parse errors already contain the line and column
+    bool parse_error(std::size_t /*unused*/, const std::string& /*unused*/, const json::exception& ex) {
+        throw std::runtime_error(std::string(ex.what()) + '\n');
+    }
+
+private:
+    ModelBuilder& builder_;
+    const LineCountingBuffer& lines_;
+    std::size_t depth_{ 0 };// Number of open objects/arrays
+    bool streaming_{ false };// Inside the array of a streamed section
+    std::string section_;
+    std::string key_;
+    json entry_;
+    std::vector<json*> stack_;// Open containers of entry_
+    std::size_t entry_line_{ 0 };
+
+    // Depth at which entries start - the elements of a streamed array are one level deeper than sections
+    [[nodiscard]] std::size_t entryDepth() const noexcept {
+        return streaming_ ? 2 : 1;
+    }
+    bool open(json&& container) {
+        if (depth_ == 0) {
+            if (!container.is_object()) { throw InputError(lines_.line(), "The input must be a JSON object.\n"); }
+        } else if (depth_ == 1 && container.is_array() && ModelBuilder::isStreamed(section_)) {
+            streaming_ = true;
+        } else if (depth_ == entryDepth()) {
+            entry_ = std::move(container);
+            stack_.assign(1, &entry_);
+            entry_line_ = lines_.line();
+        } else {
+            stack_.push_back(insert(std::move(container)));
+        }
+        ++depth_;
+        return true;
+    }
+    bool close() {
+        --depth_;
+        if (depth_ == 1 && streaming_) {
+            streaming_ = false;
+            builder_.endSection(section_);
+        } else if (depth_ > 0) {
+            stack_.pop_back();
+            if (stack_.empty()) { complete(std::move(entry_)); }
+        }
+        return true;
+    }
+    bool value(json&& val) {
+        if (stack_.empty()) {
+            entry_line_ = lines_.line();
+            complete(std::move(val));
+        } else {
+            insert(std::move(val));
+        }
+        return true;
+    }
+    json* insert(json&& val) {
+        auto& parent = *stack_.back();
+        if (parent.is_array()) {
+            parent.push_back(std::move(val));
+            return &parent.back();
+        }
+        auto& slot = parent[key_];
+        slot = std::move(val);
+        return &slot;
+    }
+    void complete(json&& entry) {
+        streaming_ ? builder_.addElement(section_, std::move(entry), entry_line_)
+                   : builder_.addSection(section_, std::move(entry), entry_line_);
+    }
+};
+
+}// namespace
+
+std::optional<Model> InputManager::deserialize(const std::filesystem::path& filepath) {// NOLINT
+    if (is_regular_file(filepath)) {
+        if (std::ifstream file(filepath.string().data()); file.is_open()) {
+            try {
+                LineCountingBuffer lines{ file.rdbuf() };
+                std::istream input{ &lines };
+                ModelBuilder builder{ filepath };
+                SectionReader reader{ builder, lines };
+                json::sax_parse(input, &reader);
+                return builder.finish();
+            } catch (const InputError& e) {
+                std::cerr << "Error at line " << e.line() << " of " << filepath << ": " << e.what() << '\n';
             } catch (const std::exception& e) { std::cerr << e.what() << '\n'; }
         } else {
             std::cerr << "Error opening file at " << filepath << '\n';
@@ -1,26 +1,42 @@
 #include "psim/inputManager.h"
 #include "psim/model.h"
+#include "psim/modelSnapshot.h"
 #include "psim/timer.h"
 #include <filesystem>
 #include <iostream>
 #include <string>
 #include <vector>
 
+namespace {
+
+constexpr std::string_view SNAPSHOT_FLAG{ "--snapshot" };
+constexpr std::string_view SNAPSHOT_EXTENSION{ ".psnap" };
+
+}// namespace
+
 // NOLINTNEXTLINE(bugprone-exception-escape)
 int main(int argc, char* argv[]) {
     if (argc > 1) {
         try {
-            const std::vector<std::string> filenames(argv + 1, argv + argc);
+            std::vector<std::string> filenames(argv + 1, argv + argc);
+            // --snapshot -> build each input model and store it as a snapshot next to the input file
+            const auto snapshot = std::erase(filenames, SNAPSHOT_FLAG) > 0;
             for (const auto& filename : filenames) {
                 const std::filesystem::path filepath = filename;
-                if (auto model = InputManager::deserialize(filepath); model) {
+                auto model = filepath.extension() == SNAPSHOT_EXTENSION ? ModelSnapshot::load(filepath)
+                                                                         : InputManager::deserialize(filepath);
+                if (!model) {
+                    std::cerr << "There was an error reading the data from the file at " << filepath << '\n';
+                } else if (snapshot) {
+                    auto snapshot_path = filepath;
+                    ModelSnapshot::save(*model, snapshot_path.replace_extension(SNAPSHOT_EXTENSION));
+                    std::cout << "Snapshot written to " << snapshot_path << '\n';
+                } else {
                     Timer timer;
                     model->runSimulation();
                     const auto time = timer.get_time_diff();
                     std::cout << "Time Taken: " << time << "[s]\n";
                     model->exportResults(filepath, time);
-                } else {
-                    std::cerr << "There was an error reading the data from the file at " << filepath << '\n';
                 }
             }
         } catch (const std::exception& e) { std::cerr << e.what() << '\n'; }
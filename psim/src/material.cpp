@@ -1,11 +1,11 @@
 #include "psim/material.h"
 #include "psim/phonon.h"// for Phonon, Phonon::RelaxRates
-#include "psim/utils.h"// for urand
+#include "psim/utils.h"// for urand, SCALING_FACTOR
 #include <algorithm>// for transform, generate, max, lower_bound
 #include <cmath>// for pow, sqrt, exp, isnan, sinh
 #include <functional>// for multiplies
-#include <iterator>// for cbegin, cend, begin, end, distance
-#include <numeric>// for accumulate
+#include <iterator>// for cbegin, cend, begin, end, distance, back_inserter
+#include <numeric>// for accumulate, transform_reduce
 #include <utility>// for pair
 
 namespace {
@@ -19,6 +19,8 @@ using Polar = Material::Polar;
 
 Material::Material(std::size_t mat_id, const DispersionData& disp_data, const RelaxationData& relax_data)
     : id_{ mat_id }
+    , disp_data_{ disp_data }
+    , relax_data_{ relax_data }
     , b_l_{ relax_data.b_l }
     , b_tn_{ relax_data.b_tn }
     , b_tu_{ relax_data.b_tu }
@@ -98,6 +100,48 @@ double Material::theoreticalEnergy(double temp, bool pseudo) const noexcept {
     return (pseudo) ? scatterEnergy(temp) : baseData(temp).second;
 }
 
+double Material::conductivity(double temp) const {
+    struct Mode {
+        double heat_capacity;
+        double vel;
+        double tau;
+        double n_fraction;// Chance that the mode ends its free flight with a Normal scatter
+    };
+    const auto& table = *baseTable(temp);
+    const auto heat_capacity = baseEnergy(temp);
+    std::vector<Mode> modes;
+    modes.reserve(2 * NUM_FREQ_BINS);
+    for (std::size_t index = 0; index < NUM_FREQ_BINS; ++index) {
+        const auto share = (index == 0) ? table[0].first : table[index].first - table[index - 1].first;
+        for (const auto polar : { Polar::LA, Polar::TA }) {
+            const auto mode_capacity =
+                heat_capacity * share * ((polar == Polar::LA) ? table[index].second : 1. - table[index].second);
+            const auto rates = relaxRates(temp, frequencies_[index], polar);
+            const auto tau_inv = std::accumulate(std::cbegin(rates), std::cend(rates), 0.);
+            // Modes that never scatter cannot be treated as diffusive
+            if (mode_capacity <= 0. || tau_inv <= 0.) { continue; }
+            modes.push_back({ mode_capacity, getVel(index, polar), SCALING_FACTOR / tau_inv, rates[0] / tau_inv });
+        }
+    }
+    // Scatters draw the new mode in proportion to its heat capacity times its scattering rate, so the distance a
+    // phonon keeps moving in its direction after a Normal scatter is the mean of that distribution (chained). Each
+    // mode covers v * tau before its first scatter and then the chained distance if the scatter is a Normal one:
+    // chained = sum(w * v * tau) / sum(w) + sum(w * n_fraction) / sum(w) * chained
+    double flight = 0.;
+    double normal = 0.;
+    double weight = 0.;
+    for (const auto& [mode_capacity, vel, tau, n_fraction] : modes) {
+        const auto w = mode_capacity / tau;
+        flight += w * vel * tau;
+        normal += w * n_fraction;
+        weight += w;
+    }
+    const auto chained = (weight > normal) ? flight / (weight - normal) : 0.;
+    return std::transform_reduce(std::cbegin(modes), std::cend(modes), 0., std::plus{}, [chained](const Mode& mode) {
+        return mode.heat_capacity * mode.vel * (mode.vel * mode.tau + mode.n_fraction * chained) / 3.;// NOLINT
+    });
+}
+
 void Material::initializeTables(double low_temp, double high_temp, float temp_interval) {
     const auto num_steps = static_cast<std::size_t>((high_temp - low_temp) / static_cast<double>(temp_interval));
     temps_.resize(num_steps, 0.);
@@ -120,6 +164,15 @@ void Material::initializeTables(double low_temp, double high_temp, float temp_in
         auto scatterData = cumulDistScatter(phononDist(temp, Polar::LA), phononDist(temp, Polar::TA), temp);
         scatter_tables_.emplace_back(scatterData.first, scatterData.second);
     }
+    if (gray_) {
+        // k = C * v * mfp / 3 with mfp = v * SCALING_FACTOR / rate
+        std::ranges::transform(temps_, std::back_inserter(gray_data_), [this](double temp) {
+            const auto velocity = emitEnergy(temp) / baseEnergy(temp);
+            const auto k = conductivity(temp);
+            const auto rate = (k > 0.) ? SCALING_FACTOR * baseEnergy(temp) * velocity * velocity / (3. * k) : 0.;
+            return GrayData{ velocity, rate };
+        });
+    }
 }
 
 std::pair<const Table*, double> Material::baseData(double temp) const {
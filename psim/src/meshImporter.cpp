@@ -0,0 +1,361 @@
+#include "psim/meshImporter.h"
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Gmsh element type identifiers
+constexpr int GMSH_LINE{ 1 };
+constexpr int GMSH_TRIANGLE{ 2 };
+constexpr int GMSH_POINT{ 15 };
+
+// Number of nodes of the first-order Gmsh element types that may appear alongside triangles
+int gmshNodeCount(int type) {
+    switch (type) {
+    case GMSH_LINE:
+        return 2;
+    case GMSH_TRIANGLE:
+        return 3;
+    case GMSH_POINT:
+        return 1;
+    default:
+        return -1;
+    }
+}
+
+// Converts external node tags (which need not be contiguous) into positions in Mesh::nodes
+class NodeMap {
+public:
+    void add(std::size_t tag, std::size_t index) {
+        indices_.emplace(tag, index);
+    }
+    [[nodiscard]] std::size_t at(const fs::path& filepath, std::size_t tag) const {
+        const auto index = indices_.find(tag);
+        if (index == std::cend(indices_)) {
+            throw MeshError(filepath, "element references undefined node " + std::to_string(tag));
+        }
+        return index->second;
+    }
+
+private:
+    std::unordered_map<std::size_t, std::size_t> indices_;
+};
+
+template<typename T> T readValue(std::istream& in, const fs::path& filepath, std::string_view what) {
+    T value{};
+    if (!(in >> value)) { throw MeshError(filepath, "unexpected end of data while reading " + std::string(what)); }
+    return value;
+}
+
+void skipSection(std::istream& in, const std::string& section) {
+    const auto end_tag = "$End" + section.substr(1);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.rfind(end_tag, 0) == 0) { return; }
+    }
+}
+
+void expectEnd(std::istream& in, const fs::path& filepath, const std::string& section) {
+    const auto end_tag = "$End" + section.substr(1);
+    if (readValue<std::string>(in, filepath, end_tag) != end_tag) { throw MeshError(filepath, "missing " + end_tag); }
+}
+
+void readPhysicalNames(std::istream& in, const fs::path& filepath, Mesh& mesh) {
+    const auto count = readValue<std::size_t>(in, filepath, "physical names");
+    for (std::size_t i = 0; i < count; ++i) {
+        [[maybe_unused]] const auto dim = readValue<int>(in, filepath, "physical name dimension");
+        const auto tag = readValue<int>(in, filepath, "physical tag");
+        std::string name;
+        std::getline(in >> std::ws, name);
+        if (const auto first = name.find('"'), last = name.rfind('"'); first != last) {
+            name = name.substr(first + 1, last - first - 1);
+        }
+        mesh.group_names[name] = tag;
+    }
+}
+
+// Adds a first-order line or triangle to the mesh. Other element types are rejected since cells are triangles.
+void addGmshElement(const fs::path& filepath,
+    Mesh& mesh,
+    const NodeMap& nodes,
+    int type,
+    int group,
+    const std::vector<std::size_t>& tags) {
+    switch (type) {
+    case GMSH_TRIANGLE:
+        mesh.elements.push_back({ { nodes.at(filepath, tags[0]), nodes.at(filepath, tags[1]),
+                                      nodes.at(filepath, tags[2]) },
+            group });
+        break;
+    case GMSH_LINE:
+        mesh.edges.push_back({ { nodes.at(filepath, tags[0]), nodes.at(filepath, tags[1]) }, group });
+        break;
+    case GMSH_POINT:
+        break;
+    default:
+        throw MeshError(filepath, "unsupported element type " + std::to_string(type) + " (only 3-node triangles)");
+    }
+}
+
+void readGmsh2(std::istream& in, const fs::path& filepath, Mesh& mesh) {
+    NodeMap nodes;
+    std::string section;
+    while (in >> section) {
+        if (section == "$PhysicalNames") {
+            readPhysicalNames(in, filepath, mesh);
+            expectEnd(in, filepath, section);
+        } else if (section == "$Nodes") {
+            const auto count = readValue<std::size_t>(in, filepath, "node count");
+            mesh.nodes.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto tag = readValue<std::size_t>(in, filepath, "node tag");
+                const auto x = readValue<double>(in, filepath, "node coordinates");// NOLINT
+                const auto y = readValue<double>(in, filepath, "node coordinates");// NOLINT
+                [[maybe_unused]] const auto z = readValue<double>(in, filepath, "node coordinates");// NOLINT
+                nodes.add(tag, mesh.nodes.size());
+                mesh.nodes.push_back({ x, y });
+            }
+            expectEnd(in, filepath, section);
+        } else if (section == "$Elements") {
+            const auto count = readValue<std::size_t>(in, filepath, "element count");
+            std::vector<std::size_t> node_tags;
+            for (std::size_t i = 0; i < count; ++i) {
+                [[maybe_unused]] const auto tag = readValue<std::size_t>(in, filepath, "element tag");
+                const auto type = readValue<int>(in, filepath, "element type");
+                const auto num_tags = readValue<int>(in, filepath, "element tag count");
+                int group = 0;
+                for (int t = 0; t < num_tags; ++t) {
+                    const auto value = readValue<int>(in, filepath, "element tags");
+                    if (t == 0) { group = value; }// First tag is the physical group
+                }
+                const auto num_nodes = gmshNodeCount(type);
+                if (num_nodes < 0) {
+                    throw MeshError(
+                        filepath, "unsupported element type " + std::to_string(type) + " (only 3-node triangles)");
+                }
+                node_tags.resize(static_cast<std::size_t>(num_nodes));
+                for (auto& node_tag : node_tags) { node_tag = readValue<std::size_t>(in, filepath, "element nodes"); }
+                addGmshElement(filepath, mesh, nodes, type, group, node_tags);
+            }
+            expectEnd(in, filepath, section);
+        } else {
+            skipSection(in, section);
+        }
+    }
+}
+
+void readGmsh4(std::istream& in, const fs::path& filepath, Mesh& mesh) {
+    NodeMap nodes;
+    // Physical group of each (dimension, entity tag) pair - the first physical tag of the entity is used
+    std::array<std::unordered_map<int, int>, 4> entity_groups;
+    std::string section;
+    while (in >> section) {
+        if (section == "$PhysicalNames") {
+            readPhysicalNames(in, filepath, mesh);
+            expectEnd(in, filepath, section);
+        } else if (section == "$Entities") {
+            std::array<std::size_t, 4> counts{};
+            for (auto& count : counts) { count = readValue<std::size_t>(in, filepath, "entity counts"); }
+            for (std::size_t dim = 0; dim < counts.size(); ++dim) {
+                for (std::size_t i = 0; i < counts[dim]; ++i) {
+                    const auto tag = readValue<int>(in, filepath, "entity tag");
+                    // Points store a single coordinate triplet, other entities store a bounding box
+                    const int num_coords = (dim == 0) ? 3 : 6;// NOLINT
+                    for (int c = 0; c < num_coords; ++c) { readValue<double>(in, filepath, "entity coordinates"); }
+                    const auto num_physicals = readValue<std::size_t>(in, filepath, "entity physical tags");
+                    for (std::size_t p = 0; p < num_physicals; ++p) {
+                        const auto physical = readValue<int>(in, filepath, "entity physical tags");
+                        entity_groups[dim].try_emplace(tag, physical);
+                    }
+                    if (dim > 0) {
+                        const auto num_bounding = readValue<std::size_t>(in, filepath, "entity boundary");
+                        for (std::size_t b = 0; b < num_bounding; ++b) {
+                            readValue<int>(in, filepath, "entity boundary");
+                        }
+                    }
+                }
+            }
+            expectEnd(in, filepath, section);
+        } else if (section == "$Nodes") {
+            const auto num_blocks = readValue<std::size_t>(in, filepath, "node block count");
+            mesh.nodes.reserve(readValue<std::size_t>(in, filepath, "node count"));
+            readValue<std::size_t>(in, filepath, "node tag range");
+            readValue<std::size_t>(in, filepath, "node tag range");
+            std::vector<std::size_t> tags;
+            for (std::size_t block = 0; block < num_blocks; ++block) {
+                const auto dim = readValue<int>(in, filepath, "node block dimension");
+                readValue<int>(in, filepath, "node block entity");
+                const auto parametric = readValue<int>(in, filepath, "node block parametric flag");
+                const auto count = readValue<std::size_t>(in, filepath, "node block size");
+                tags.resize(count);
+                for (auto& tag : tags) { tag = readValue<std::size_t>(in, filepath, "node tag"); }
+                for (const auto tag : tags) {
+                    const auto x = readValue<double>(in, filepath, "node coordinates");// NOLINT
+                    const auto y = readValue<double>(in, filepath, "node coordinates");// NOLINT
+                    readValue<double>(in, filepath, "node coordinates");
+                    for (int u = 0; parametric != 0 && u < dim; ++u) {
+                        readValue<double>(in, filepath, "node parameters");
+                    }
+                    nodes.add(tag, mesh.nodes.size());
+                    mesh.nodes.push_back({ x, y });
+                }
+            }
+            expectEnd(in, filepath, section);
+        } else if (section == "$Elements") {
+            const auto num_blocks = readValue<std::size_t>(in, filepath, "element block count");
+            mesh.elements.reserve(readValue<std::size_t>(in, filepath, "element count"));
+            readValue<std::size_t>(in, filepath, "element tag range");
+            readValue<std::size_t>(in, filepath, "element tag range");
+            std::vector<std::size_t> node_tags;
+            for (std::size_t block = 0; block < num_blocks; ++block) {
+                const auto dim = readValue<std::size_t>(in, filepath, "element block dimension");
+                const auto entity = readValue<int>(in, filepath, "element block entity");
+                const auto type = readValue<int>(in, filepath, "element block type");
+                const auto count = readValue<std::size_t>(in, filepath, "element block size");
+                const auto num_nodes = gmshNodeCount(type);
+                if (num_nodes < 0 || dim >= entity_groups.size()) {
+                    throw MeshError(
+                        filepath, "unsupported element type " + std::to_string(type) + " (only 3-node triangles)");
+                }
+                const auto group_it = entity_groups[dim].find(entity);
+                const int group = (group_it == std::cend(entity_groups[dim])) ? 0 : group_it->second;
+                node_tags.resize(static_cast<std::size_t>(num_nodes));
+                for (std::size_t i = 0; i < count; ++i) {
+                    readValue<std::size_t>(in, filepath, "element tag");
+                    for (auto& tag : node_tags) { tag = readValue<std::size_t>(in, filepath, "element nodes"); }
+                    addGmshElement(filepath, mesh, nodes, type, group, node_tags);
+                }
+            }
+            expectEnd(in, filepath, section);
+        } else {
+            skipSection(in, section);
+        }
+    }
+}
+
+// Triangle files allow '#' comments anywhere
+std::istringstream nextTriangleLine(std::istream& in, const fs::path& filepath) {
+    std::string line;
+    while (std::getline(in, line)) {
+        if (const auto comment = line.find('#'); comment != std::string::npos) { line.erase(comment); }
+        if (line.find_first_not_of(" \t\r") != std::string::npos) { return std::istringstream{ line }; }
+    }
+    throw MeshError(filepath, "unexpected end of file");
+}
+
+}// namespace
+
+Mesh MeshImporter::read(const fs::path& filepath) {
+    const auto extension = filepath.extension();
+    if (extension == ".msh") { return readGmsh(filepath); }
+    auto base_path = filepath;
+    if (extension == ".node" || extension == ".ele" || extension == ".edge") { base_path.replace_extension(); }
+    return readTriangle(base_path);
+}
+
+Mesh MeshImporter::readGmsh(const fs::path& filepath) {
+    std::ifstream in{ filepath };
+    if (!in.is_open()) { throw MeshError(filepath, "unable to open file"); }
+    std::string section;
+    if (!(in >> section) || section != "$MeshFormat") { throw MeshError(filepath, "missing $MeshFormat header"); }
+    const auto version = readValue<std::string>(in, filepath, "format version");
+    const auto file_type = readValue<int>(in, filepath, "file type");
+    readValue<int>(in, filepath, "data size");
+    if (file_type != 0) { throw MeshError(filepath, "binary .msh files are not supported, export as ASCII"); }
+    expectEnd(in, filepath, section);
+
+    Mesh mesh;
+    if (version.rfind("2.", 0) == 0) {
+        readGmsh2(in, filepath, mesh);
+    } else if (version.rfind("4.", 0) == 0) {
+        readGmsh4(in, filepath, mesh);
+    } else {
+        throw MeshError(filepath, "unsupported .msh version " + version);
+    }
+    if (mesh.elements.empty()) { throw MeshError(filepath, "no triangles found"); }
+    return mesh;
+}
+
+Mesh MeshImporter::readTriangle(const fs::path& base_path) {
+    auto with_extension = [&base_path](const char* extension) {
+        auto path = base_path;
+        path += extension;
+        return path;
+    };
+    Mesh mesh;
+    NodeMap nodes;
+
+    const auto node_path = with_extension(".node");
+    std::ifstream node_file{ node_path };
+    if (!node_file.is_open()) { throw MeshError(node_path, "unable to open file"); }
+    std::size_t num_nodes = 0;
+    int dim = 0;
+    std::size_t num_attributes = 0;
+    int has_marker = 0;
+    nextTriangleLine(node_file, node_path) >> num_nodes >> dim >> num_attributes >> has_marker;
+    if (dim != 2) { throw MeshError(node_path, "only 2D meshes are supported"); }
+    mesh.nodes.reserve(num_nodes);
+    for (std::size_t i = 0; i < num_nodes; ++i) {
+        auto line = nextTriangleLine(node_file, node_path);
+        std::size_t tag = 0;
+        Geometry::Point point{ 0., 0. };
+        if (!(line >> tag >> point.x >> point.y)) { throw MeshError(node_path, "malformed node entry"); }
+        nodes.add(tag, mesh.nodes.size());
+        mesh.nodes.push_back(point);
+    }
+
+    const auto ele_path = with_extension(".ele");
+    std::ifstream ele_file{ ele_path };
+    if (!ele_file.is_open()) { throw MeshError(ele_path, "unable to open file"); }
+    std::size_t num_elements = 0;
+    std::size_t nodes_per_element = 0;
+    std::size_t num_regions = 0;
+    nextTriangleLine(ele_file, ele_path) >> num_elements >> nodes_per_element >> num_regions;
+    if (nodes_per_element != 3) { throw MeshError(ele_path, "only 3-node triangles are supported"); }
+    mesh.elements.reserve(num_elements);
+    for (std::size_t i = 0; i < num_elements; ++i) {
+        auto line = nextTriangleLine(ele_file, ele_path);
+        std::size_t tag = 0;
+        std::array<std::size_t, 3> node_tags{};
+        if (!(line >> tag >> node_tags[0] >> node_tags[1] >> node_tags[2])) {
+            throw MeshError(ele_path, "malformed element entry");
+        }
+        // The first regional attribute (set with triangle -A) identifies the region
+        double region = 0.;
+        if (num_regions > 0) { line >> region; }
+        mesh.elements.push_back({ { nodes.at(ele_path, node_tags[0]), nodes.at(ele_path, node_tags[1]),
+                                      nodes.at(ele_path, node_tags[2]) },
+            static_cast<int>(region) });
+    }
+
+    // Boundary markers are optional and only available when triangle was run with -e
+    const auto edge_path = with_extension(".edge");
+    if (std::ifstream edge_file{ edge_path }; edge_file.is_open()) {
+        std::size_t num_edges = 0;
+        int has_markers = 0;
+        nextTriangleLine(edge_file, edge_path) >> num_edges >> has_markers;
+        for (std::size_t i = 0; i < num_edges; ++i) {
+            auto line = nextTriangleLine(edge_file, edge_path);
+            std::size_t tag = 0;
+            std::array<std::size_t, 2> node_tags{};
+            int marker = 0;
+            if (!(line >> tag >> node_tags[0] >> node_tags[1])) { throw MeshError(edge_path, "malformed edge entry"); }
+            if (has_markers != 0) { line >> marker; }
+            // Marker 0 is an interior edge and 1 is the default boundary marker, neither identifies a group
+            if (marker > 1) {
+                mesh.edges.push_back({ { nodes.at(edge_path, node_tags[0]), nodes.at(edge_path, node_tags[1]) },
+                    marker });
+            }
+        }
+    }
+    return mesh;
+}
+
+MeshError::MeshError(const fs::path& filepath, std::string_view message) {
+    std::ostringstream os;// NOLINT
+    os << "Unable to import mesh " << filepath << ": " << message << '\n';
+    message_ = os.str();
+}
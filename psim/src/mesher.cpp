@@ -0,0 +1,636 @@
+#include "psim/mesher.h"
+#include "psim/utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+using Point = Geometry::Point;
+
+namespace {
+
+constexpr std::size_t NONE{ std::numeric_limits<std::size_t>::max() };
+// Lattice points closer than this fraction of the element size to a boundary segment are dropped
+constexpr double BOUNDARY_CLEARANCE{ 0.5 };
+// Elements whose circumradius to shortest edge ratio exceeds this are refined (minimum angle of about 20.7 degrees)
+constexpr double MAX_RADIUS_EDGE_RATIO{ std::numbers::sqrt2 };
+// Elements whose circumradius exceeds this fraction of the element size are refined. An equilateral element with
+// edges of the element size has a circumradius of 0.577 element sizes.
+constexpr double MAX_RADIUS_SIZE_RATIO{ 0.8 };
+// Segments and elements smaller than this fraction of the element size are not refined any further, which stops
+// the refinement from cascading into small input angles
+constexpr double MIN_SIZE_RATIO{ 1e-3 };
+// Caps the number of vertices inserted by refinement as a multiple of the initial vertex count
+constexpr std::size_t MAX_REFINEMENT_FACTOR{ 10 };
+// The triangle enclosing every vertex extends this many times the size of the domains in each direction
+constexpr double SUPER_TRIANGLE_SCALE{ 20. };
+
+[[nodiscard]] std::uint64_t edgeKey(std::size_t a, std::size_t b) noexcept {
+    const auto [low, high] = std::minmax(a, b);
+    return (static_cast<std::uint64_t>(low) << 32U) | static_cast<std::uint64_t>(high);// NOLINT
+}
+[[nodiscard]] std::pair<std::size_t, std::size_t> edgeNodes(std::uint64_t key) noexcept {
+    return { key >> 32U, key & 0xFFFFFFFFU };// NOLINT
+}
+
+// Positive if d lies inside the circumcircle of the counterclockwise triangle (a, b, c)
+[[nodiscard]] double incircle(const Point& a, const Point& b, const Point& c, const Point& d) noexcept {// NOLINT
+    const double adx = a.x - d.x;
+    const double ady = a.y - d.y;
+    const double bdx = b.x - d.x;
+    const double bdy = b.y - d.y;
+    const double cdx = c.x - d.x;
+    const double cdy = c.y - d.y;
+    return (adx * adx + ady * ady) * (bdx * cdy - cdx * bdy) + (bdx * bdx + bdy * bdy) * (cdx * ady - adx * cdy)
+           + (cdx * cdx + cdy * cdy) * (adx * bdy - bdx * ady);
+}
+
+[[nodiscard]] Point circumcenter(const Point& a, const Point& b, const Point& c) noexcept {// NOLINT
+    const double bx = b.x - a.x;
+    const double by = b.y - a.y;
+    const double cx = c.x - a.x;
+    const double cy = c.y - a.y;
+    const double b2 = bx * bx + by * by;
+    const double c2 = cx * cx + cy * cy;
+    const double d = 2. * (bx * cy - by * cx);
+    return { a.x + (cy * b2 - by * c2) / d, a.y + (bx * c2 - cx * b2) / d };
+}
+
+[[nodiscard]] double distance2(const Point& a, const Point& b) noexcept {
+    return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+}
+
+// Negative if p lies strictly inside the circle with diameter (a, b)
+[[nodiscard]] double diametralTest(const Point& a, const Point& b, const Point& p) noexcept {
+    return (a.x - p.x) * (b.x - p.x) + (a.y - p.y) * (b.y - p.y);
+}
+
+[[nodiscard]] double segmentDistance2(const Point& a, const Point& b, const Point& p) noexcept {
+    const double dx = b.x - a.x;
+    const double dy = b.y - a.y;
+    const double t = std::clamp(((p.x - a.x) * dx + (p.y - a.y) * dy) / (dx * dx + dy * dy), 0., 1.);
+    return distance2({ a.x + t * dx, a.y + t * dy }, p);
+}
+
+// Even-odd rule, the polygon may be listed in either direction
+[[nodiscard]] bool insidePolygon(const std::vector<Point>& polygon, const Point& p) noexcept {
+    bool inside = false;
+    for (std::size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        const auto& a = polygon[i];
+        const auto& b = polygon[j];
+        if ((a.y > p.y) != (b.y > p.y) && p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x) { inside = !inside; }
+    }
+    return inside;
+}
+
+[[nodiscard]] bool insideDomain(const MeshDomain& domain, const Point& p) noexcept {
+    return insidePolygon(domain.boundary, p)
+           && std::none_of(std::cbegin(domain.holes), std::cend(domain.holes), [&p](const auto& hole) {
+                  return insidePolygon(hole, p);
+              });
+}
+
+/**
+ * Incremental Delaunay triangulation (Bowyer-Watson) inside a triangle that encloses every vertex. Vertices 0-2
+ * are the corners of the enclosing triangle. Triangles that are removed leave dead slots that are reused.
+ */
+class Triangulation {
+public:
+    struct Triangle {
+        std::array<std::size_t, 3> v;// Counterclockwise
+        std::array<std::size_t, 3> n;// n[i] is the neighbour across the edge opposite v[i], NONE on the hull
+        bool alive;
+    };
+
+    explicit Triangulation(const Geometry::PointPair& box) {
+        const auto& [bl, tr] = box;
+        const Point center{ (bl.x + tr.x) / 2., (bl.y + tr.y) / 2. };
+        const double span = SUPER_TRIANGLE_SCALE * std::max(tr.x - bl.x, tr.y - bl.y);
+        points_ = { { center.x - span, center.y - span }, { center.x + span, center.y - span },
+            { center.x, center.y + span } };
+        triangles_.push_back({ { 0, 1, 2 }, { NONE, NONE, NONE }, true });
+    }
+
+    [[nodiscard]] static bool isSuper(std::size_t vertex) noexcept {
+        return vertex < 3;
+    }
+    [[nodiscard]] const std::vector<Point>& points() const noexcept {
+        return points_;
+    }
+    [[nodiscard]] const std::vector<Triangle>& triangles() const noexcept {
+        return triangles_;
+    }
+
+    /**
+     * @return The index of the new vertex or of the existing vertex that p coincides with
+     */
+    std::size_t insert(const Point& p) {
+        const auto start = locate(p);
+        for (const auto vertex : triangles_[start].v) {
+            if (points_[vertex] == p) { return vertex; }
+        }
+        const auto vertex = points_.size();
+        points_.push_back(p);
+        findCavity(start, p);
+
+        for (const auto t : cavity_) {
+            triangles_[t].alive = false;
+            free_.push_back(t);
+        }
+        created_.clear();
+        for (const auto& [a, b, outside] : boundary_) {
+            std::size_t t = triangles_.size();
+            if (free_.empty()) {
+                triangles_.push_back({});
+            } else {
+                t = free_.back();
+                free_.pop_back();
+            }
+            triangles_[t] = { { vertex, a, b }, { outside, NONE, NONE }, true };
+            if (outside != NONE) {
+                auto& neighbour = triangles_[outside];
+                for (std::size_t i = 0; i < 3; ++i) {
+                    if (neighbour.v[i] != a && neighbour.v[i] != b) { neighbour.n[i] = t; }
+                }
+            }
+            created_.push_back(t);
+        }
+        // The fan around the new vertex - the edge (b, vertex) of one triangle is the edge (vertex, a) of another
+        for (const auto t : created_) {
+            auto& triangle = triangles_[t];
+            for (const auto other : created_) {
+                const auto& v = triangles_[other].v;
+                if (v[1] == triangle.v[2]) { triangle.n[1] = other; }
+                if (v[2] == triangle.v[1]) { triangle.n[2] = other; }
+            }
+        }
+        last_ = created_.front();
+        return vertex;
+    }
+
+private:
+    struct BoundaryEdge {
+        std::size_t a;
+        std::size_t b;
+        std::size_t outside;
+    };
+
+    std::vector<Point> points_;
+    std::vector<Triangle> triangles_;
+    std::vector<std::size_t> free_;
+    std::size_t last_{ 0 };
+    // Scratch space reused between insertions
+    std::vector<std::size_t> cavity_;
+    std::vector<BoundaryEdge> boundary_;
+    std::vector<std::size_t> created_;
+    std::vector<std::uint32_t> marks_;
+    std::uint32_t mark_{ 0 };
+
+    // Visibility walk from the last created triangle. The start edge rotates so the walk cannot cycle.
+    [[nodiscard]] std::size_t locate(const Point& p) const {
+        auto t = last_;
+        for (std::size_t step = 0; step <= triangles_.size(); ++step) {
+            const auto& triangle = triangles_[t];
+            bool moved = false;
+            for (std::size_t k = 0; k < 3 && !moved; ++k) {
+                const auto i = (k + step) % 3;
+                const auto next = triangle.n[i];
+                if (next != NONE
+                    && orient2d(points_[triangle.v[(i + 1) % 3]], points_[triangle.v[(i + 2) % 3]], p) < 0.) {
+                    t = next;
+                    moved = true;
+                }
+            }
+            if (!moved) { return t; }
+        }
+        throw std::runtime_error(std::string("Unable to locate a mesh vertex in the triangulation.\n"));
+    }
+
+    // The triangles whose circumcircles contain p, grown until the cavity is star shaped around p
+    void findCavity(std::size_t start, const Point& p) {
+        ++mark_;
+        marks_.resize(triangles_.size(), 0);
+        cavity_.assign(1, start);
+        marks_[start] = mark_;
+        for (std::size_t i = 0; i < cavity_.size(); ++i) {
+            for (const auto neighbour : triangles_[cavity_[i]].n) {
+                if (neighbour == NONE || marks_[neighbour] == mark_) { continue; }
+                const auto& v = triangles_[neighbour].v;
+                if (incircle(points_[v[0]], points_[v[1]], points_[v[2]], p) > 0.) {
+                    marks_[neighbour] = mark_;
+                    cavity_.push_back(neighbour);
+                }
+            }
+        }
+        // Rounding in incircle can leave boundary edges that p does not see - the triangles beyond them join
+        for (bool star = false; !star;) {
+            star = true;
+            boundary_.clear();
+            for (std::size_t c = 0; c < cavity_.size() && star; ++c) {
+                const auto& triangle = triangles_[cavity_[c]];
+                for (std::size_t i = 0; i < 3; ++i) {
+                    const auto outside = triangle.n[i];
+                    if (outside != NONE && marks_[outside] == mark_) { continue; }
+                    const auto a = triangle.v[(i + 1) % 3];
+                    const auto b = triangle.v[(i + 2) % 3];
+                    if (orient2d(points_[a], points_[b], p) > 0.) {
+                        boundary_.push_back({ a, b, outside });
+                        continue;
+                    }
+                    if (outside == NONE) {
+                        throw std::runtime_error(std::string("Mesh vertex outside of the triangulation.\n"));
+                    }
+                    marks_[outside] = mark_;
+                    cavity_.push_back(outside);
+                    star = false;
+                    break;
+                }
+            }
+        }
+    }
+};
+
+// Builds a conforming Delaunay mesh of the domains with Ruppert's refinement
+class DomainMesher {
+public:
+    explicit DomainMesher(const std::vector<MeshDomain>& domains)
+        : domains_{ domains }
+        , triangulation_{ boundingBox(domains) } {
+        for (const auto& domain : domains_) { max_size_ = std::max(max_size_, domain.size); }
+        for (const auto& domain : domains_) {
+            min_length_ = std::min(min_length_, MIN_SIZE_RATIO * domain.size);
+        }
+    }
+
+    [[nodiscard]] Mesh mesh() {
+        addBoundaries();
+        addLattice();
+        recoverSegments();
+        refine();
+        return extract();
+    }
+
+private:
+    const std::vector<MeshDomain>& domains_;
+    Triangulation triangulation_;
+    double max_size_{ 0. };
+    double min_length_{ std::numeric_limits<double>::max() };
+    // Boundary subsegments, which must all be edges of the final mesh
+    std::unordered_set<std::uint64_t> segments_;
+    // Subsegments by the grid cell of their midpoint. The cells are max_size_ wide, at least as long as any
+    // subsegment, so every subsegment whose diametral circle contains a point is found in the 3x3 cells around it.
+    std::unordered_map<std::uint64_t, std::vector<std::uint64_t>> grid_;
+
+    [[nodiscard]] static Geometry::PointPair boundingBox(const std::vector<MeshDomain>& domains) {
+        constexpr double inf = std::numeric_limits<double>::max();
+        Point bl{ inf, inf };
+        Point tr{ -inf, -inf };
+        for (const auto& domain : domains) {
+            for (const auto& p : domain.boundary) {
+                bl = { std::min(bl.x, p.x), std::min(bl.y, p.y) };
+                tr = { std::max(tr.x, p.x), std::max(tr.y, p.y) };
+            }
+        }
+        return { bl, tr };
+    }
+
+    [[nodiscard]] const Point& point(std::size_t vertex) const noexcept {
+        return triangulation_.points()[vertex];
+    }
+    [[nodiscard]] std::pair<std::int64_t, std::int64_t> cellOf(const Point& p) const noexcept {
+        return { static_cast<std::int64_t>(std::floor(p.x / max_size_)),
+            static_cast<std::int64_t>(std::floor(p.y / max_size_)) };
+    }
+    [[nodiscard]] static std::uint64_t cellKey(std::int64_t x, std::int64_t y) noexcept {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32U)// NOLINT
+               | static_cast<std::uint32_t>(y);
+    }
+    [[nodiscard]] Point midpoint(std::uint64_t segment) const noexcept {
+        const auto [a, b] = edgeNodes(segment);
+        return { (point(a).x + point(b).x) / 2., (point(a).y + point(b).y) / 2. };
+    }
+    [[nodiscard]] double length(std::uint64_t segment) const noexcept {
+        const auto [a, b] = edgeNodes(segment);
+        return std::sqrt(distance2(point(a), point(b)));
+    }
+
+    void addSegment(std::size_t a, std::size_t b) {
+        const auto key = edgeKey(a, b);
+        if (!segments_.insert(key).second) { return; }
+        const auto [x, y] = cellOf(midpoint(key));
+        grid_[cellKey(x, y)].push_back(key);
+    }
+    void removeSegment(std::uint64_t key) {
+        segments_.erase(key);
+        const auto [x, y] = cellOf(midpoint(key));
+        auto& cell = grid_[cellKey(x, y)];
+        cell.erase(std::find(std::begin(cell), std::end(cell), key));
+    }
+    void splitSegment(std::uint64_t key) {
+        const auto [a, b] = edgeNodes(key);
+        const auto mid = midpoint(key);
+        removeSegment(key);
+        const auto vertex = triangulation_.insert(mid);
+        addSegment(a, vertex);
+        addSegment(vertex, b);
+    }
+
+    // Calls f with every subsegment near p until it returns true
+    template<typename F> bool anySegmentNear(const Point& p, F&& f) const {
+        const auto [x, y] = cellOf(p);
+        for (std::int64_t dx = -1; dx <= 1; ++dx) {
+            for (std::int64_t dy = -1; dy <= 1; ++dy) {
+                const auto cell = grid_.find(cellKey(x + dx, y + dy));
+                if (cell == std::cend(grid_)) { continue; }
+                if (std::any_of(std::cbegin(cell->second), std::cend(cell->second), f)) { return true; }
+            }
+        }
+        return false;
+    }
+    // A subsegment whose diametral circle contains p
+    [[nodiscard]] std::optional<std::uint64_t> encroached(const Point& p) const {
+        std::optional<std::uint64_t> found;
+        anySegmentNear(p, [&](std::uint64_t key) {
+            const auto [a, b] = edgeNodes(key);
+            if (point(a) == p || point(b) == p || diametralTest(point(a), point(b), p) >= 0.) { return false; }
+            found = key;
+            return true;
+        });
+        return found;
+    }
+    [[nodiscard]] std::optional<std::size_t> domainOf(const Point& p) const {
+        for (std::size_t d = 0; d < domains_.size(); ++d) {
+            if (insideDomain(domains_[d], p)) { return d; }
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * Inserts the domain boundaries split into subsegments no longer than the element size. Boundary edges are
+     * first cut at any input vertex lying on them so that boundaries shared by domains (in full or in part) are
+     * split once, with the smaller element size of the domains on either side.
+     */
+    void addBoundaries() {
+        struct Edge {
+            Point p1;
+            Point p2;
+            double size;
+        };
+        std::vector<Edge> edges;
+        std::vector<Point> corners;
+        for (const auto& domain : domains_) {
+            auto addLoop = [&](const std::vector<Point>& loop) {
+                for (std::size_t i = 0; i < loop.size(); ++i) {
+                    const auto& p1 = loop[i];
+                    const auto& p2 = loop[(i + 1) % loop.size()];
+                    if (p1 != p2) { edges.push_back({ p1, p2, domain.size }); }
+                    corners.push_back(p1);
+                }
+            };
+            addLoop(domain.boundary);
+            for (const auto& hole : domain.holes) { addLoop(hole); }
+        }
+
+        std::unordered_map<std::uint64_t, double> pieces;
+        for (const auto& [p1, p2, size] : edges) {
+            const auto length = std::sqrt(distance2(p1, p2));
+            std::vector<double> cuts{ 0., 1. };
+            for (const auto& corner : corners) {
+                if (corner == p1 || corner == p2 || std::abs(orient2d(p1, p2, corner)) > GEOEPS * length) { continue; }
+                const auto t =
+                    ((corner.x - p1.x) * (p2.x - p1.x) + (corner.y - p1.y) * (p2.y - p1.y)) / (length * length);
+                if (t > 0. && t < 1.) { cuts.push_back(t); }
+            }
+            std::sort(std::begin(cuts), std::end(cuts));
+            auto previous = triangulation_.insert(p1);
+            for (std::size_t c = 1; c < cuts.size(); ++c) {
+                const auto t = cuts[c];
+                const auto next = triangulation_.insert({ p1.x + t * (p2.x - p1.x), p1.y + t * (p2.y - p1.y) });
+                if (next == previous) { continue; }
+                auto [piece, inserted] = pieces.try_emplace(edgeKey(previous, next), size);
+                if (!inserted) { piece->second = std::min(piece->second, size); }
+                previous = next;
+            }
+        }
+
+        // Sorted so the mesh does not depend on the hash order
+        std::vector<std::pair<std::uint64_t, double>> sorted(std::cbegin(pieces), std::cend(pieces));
+        std::sort(std::begin(sorted), std::end(sorted));
+        for (const auto& [key, size] : sorted) {
+            const auto [a, b] = edgeNodes(key);
+            const auto p1 = point(a);
+            const auto p2 = point(b);
+            const auto count = static_cast<std::size_t>(std::ceil(length(key) / size - GEOEPS));
+            auto previous = a;
+            for (std::size_t i = 1; i < count; ++i) {
+                const double t = static_cast<double>(i) / static_cast<double>(count);
+                const auto next = triangulation_.insert({ p1.x + t * (p2.x - p1.x), p1.y + t * (p2.y - p1.y) });
+                addSegment(previous, next);
+                previous = next;
+            }
+            addSegment(previous, b);
+        }
+    }
+
+    // Seeds each domain with a triangular lattice of points spaced by its element size
+    void addLattice() {
+        for (const auto& domain : domains_) {
+            const auto h = domain.size;
+            const auto row_height = h * std::numbers::sqrt3 / 2.;
+            const auto min_distance2 = BOUNDARY_CLEARANCE * BOUNDARY_CLEARANCE * h * h;
+            const auto [bl, tr] = boundingBox({ domain });
+            const auto rows = static_cast<std::size_t>((tr.y - bl.y) / row_height) + 1;
+            const auto columns = static_cast<std::size_t>((tr.x - bl.x) / h) + 1;
+            for (std::size_t row = 0; row < rows; ++row) {
+                const double y = bl.y + (static_cast<double>(row) + 0.5) * row_height;
+                const double shift = (row % 2 == 0) ? 0.25 : 0.75;// NOLINT
+                for (std::size_t column = 0; column < columns; ++column) {
+                    const Point p{ bl.x + (static_cast<double>(column) + shift) * h, y };
+                    if (!insideDomain(domain, p)) { continue; }
+                    const bool close = anySegmentNear(p, [&](std::uint64_t key) {
+                        const auto [a, b] = edgeNodes(key);
+                        return segmentDistance2(point(a), point(b), p) < min_distance2;
+                    });
+                    if (!close) { triangulation_.insert(p); }
+                }
+            }
+        }
+    }
+
+    /**
+     * Splits subsegments that are missing from the triangulation or whose diametral circle contains a vertex
+     * until every subsegment is an edge. A vertex inside the diametral circle is always the apex of one of the two
+     * triangles next to the subsegment.
+     */
+    void recoverSegments() {
+        for (;;) {
+            std::unordered_map<std::uint64_t, std::array<std::size_t, 2>> apexes;
+            for (const auto& triangle : triangulation_.triangles()) {
+                if (!triangle.alive) { continue; }
+                for (std::size_t i = 0; i < 3; ++i) {
+                    const auto key = edgeKey(triangle.v[(i + 1) % 3], triangle.v[(i + 2) % 3]);
+                    if (!segments_.contains(key)) { continue; }
+                    auto& apex = apexes.try_emplace(key, std::array{ NONE, NONE }).first->second;
+                    apex[apex[0] == NONE ? 0 : 1] = triangle.v[i];
+                }
+            }
+            std::vector<std::uint64_t> split;
+            for (const auto key : segments_) {
+                const auto apex = apexes.find(key);
+                const auto [a, b] = edgeNodes(key);
+                const bool missing = apex == std::cend(apexes);
+                auto inside = [&](std::size_t c) {
+                    return c != NONE && !Triangulation::isSuper(c) && diametralTest(point(a), point(b), point(c)) < 0.;
+                };
+                const bool encroached =
+                    !missing && std::any_of(std::cbegin(apex->second), std::cend(apex->second), inside);
+                if (!missing && !encroached) { continue; }
+                if (length(key) > min_length_) {
+                    split.push_back(key);
+                } else if (missing) {
+                    throw std::runtime_error(
+                        std::string("Unable to mesh the domain boundaries - the angles between them are too small.\n"));
+                }
+            }
+            if (split.empty()) { return; }
+            std::sort(std::begin(split), std::end(split));
+            for (const auto key : split) { splitSegment(key); }
+        }
+    }
+
+    // Inserts the circumcenters of poorly shaped or oversized elements, splitting the subsegments they encroach on
+    void refine() {
+        const auto limit = MAX_REFINEMENT_FACTOR * triangulation_.points().size();
+        std::size_t total = 0;
+        for (;;) {
+            struct Candidate {
+                std::size_t triangle;
+                std::array<std::size_t, 3> v;
+            };
+            std::vector<Candidate> bad;
+            const auto& triangles = triangulation_.triangles();
+            for (std::size_t t = 0; t < triangles.size(); ++t) {
+                const auto& [v, n, alive] = triangles[t];
+                if (!alive || std::any_of(std::cbegin(v), std::cend(v), Triangulation::isSuper)) { continue; }
+                const auto& a = point(v[0]);
+                const auto& b = point(v[1]);
+                const auto& c = point(v[2]);
+                const auto radius2 = distance2(circumcenter(a, b, c), a);
+                const auto shortest2 = std::min({ distance2(a, b), distance2(b, c), distance2(c, a) });
+                const bool skinny = radius2 > MAX_RADIUS_EDGE_RATIO * MAX_RADIUS_EDGE_RATIO * shortest2
+                                    && shortest2 > min_length_ * min_length_;
+                const auto max_radius = MAX_RADIUS_SIZE_RATIO * max_size_;
+                if (!skinny && radius2 <= max_radius * max_radius) { continue; }
+                const auto domain = domainOf({ (a.x + b.x + c.x) / 3., (a.y + b.y + c.y) / 3. });
+                if (!domain) { continue; }
+                const auto domain_radius = MAX_RADIUS_SIZE_RATIO * domains_[*domain].size;
+                if (skinny || radius2 > domain_radius * domain_radius) { bad.push_back({ t, v }); }
+            }
+
+            std::size_t inserted = 0;
+            for (const auto& [t, v] : bad) {
+                const auto& triangle = triangulation_.triangles()[t];
+                if (!triangle.alive || triangle.v != v) { continue; }// Already replaced by an earlier insertion
+                const auto center = circumcenter(point(v[0]), point(v[1]), point(v[2]));
+                if (const auto segment = encroached(center); segment) {
+                    if (length(*segment) > min_length_) {
+                        splitSegment(*segment);
+                        ++inserted;
+                    }
+                    continue;
+                }
+                if (!domainOf(center)) { continue; }
+                const auto count = triangulation_.points().size();
+                if (triangulation_.insert(center) == count) { ++inserted; }
+            }
+            recoverSegments();
+            total += inserted;
+            if (inserted == 0) { return; }
+            if (total > limit) {
+                reportUnrefined();
+                return;
+            }
+        }
+    }
+
+    // Reports the element size and quality reached when refinement stops at the vertex limit
+    void reportUnrefined() const {
+        double longest2 = 0.;
+        double worst_ratio = 0.;
+        for (const auto& [v, n, alive] : triangulation_.triangles()) {
+            if (!alive || std::any_of(std::cbegin(v), std::cend(v), Triangulation::isSuper)) { continue; }
+            const auto& a = point(v[0]);
+            const auto& b = point(v[1]);
+            const auto& c = point(v[2]);
+            if (!domainOf({ (a.x + b.x + c.x) / 3., (a.y + b.y + c.y) / 3. })) { continue; }
+            const auto edges2 = std::minmax({ distance2(a, b), distance2(b, c), distance2(c, a) });
+            longest2 = std::max(longest2, edges2.second);
+            worst_ratio = std::max(worst_ratio, std::sqrt(distance2(circumcenter(a, b, c), a) / edges2.first));
+        }
+        // The smallest angle of a triangle is asin(shortest edge / (2 * circumradius))
+        const auto min_angle = std::asin(std::min(1. / (2. * worst_ratio), 1.)) * 180. / std::numbers::pi;
+        std::cout << "Warning: mesh refinement stopped after inserting " << MAX_REFINEMENT_FACTOR
+                  << " times the initial number of vertices. Longest element edge: " << std::sqrt(longest2)
+                  << " (element size " << max_size_ << "), smallest angle: " << min_angle << " degrees\n";
+    }
+
+    // Keeps the triangles inside a domain. Their vertices are renumbered without the enclosing triangle.
+    [[nodiscard]] Mesh extract() const {
+        Mesh mesh;
+        std::vector<std::size_t> nodes(triangulation_.points().size(), NONE);
+        std::unordered_map<std::uint64_t, std::size_t> edge_count;
+        std::vector<const Triangulation::Triangle*> kept;
+        for (const auto& triangle : triangulation_.triangles()) {
+            const auto& [v, n, alive] = triangle;
+            if (!alive || std::any_of(std::cbegin(v), std::cend(v), Triangulation::isSuper)) { continue; }
+            const auto& a = point(v[0]);
+            const auto& b = point(v[1]);
+            const auto& c = point(v[2]);
+            const auto domain = domainOf({ (a.x + b.x + c.x) / 3., (a.y + b.y + c.y) / 3. });
+            if (!domain) { continue; }
+            Mesh::Element element{ {}, static_cast<int>(*domain) + 1 };
+            for (std::size_t i = 0; i < 3; ++i) {
+                if (nodes[v[i]] == NONE) {
+                    nodes[v[i]] = mesh.nodes.size();
+                    mesh.nodes.push_back(point(v[i]));
+                }
+                element.nodes[i] = nodes[v[i]];
+                ++edge_count[edgeKey(v[i], v[(i + 1) % 3])];
+            }
+            mesh.elements.push_back(element);
+            kept.push_back(&triangle);
+        }
+        // Edges of a single element bound the meshed region
+        for (const auto* triangle : kept) {
+            const auto& v = triangle->v;
+            for (std::size_t i = 0; i < 3; ++i) {
+                const auto key = edgeKey(v[i], v[(i + 1) % 3]);
+                const auto count = edge_count.find(key);
+                if (count != std::cend(edge_count) && count->second == 1 && segments_.contains(key)) {
+                    mesh.edges.push_back({ { nodes[v[i]], nodes[v[(i + 1) % 3]] }, 0 });
+                }
+            }
+        }
+        return mesh;
+    }
+};
+
+}// namespace
+
+Mesh Mesher::triangulate(const std::vector<MeshDomain>& domains) {
+    if (domains.empty()) { throw std::runtime_error(std::string("There are no domains to mesh.\n")); }
+    for (const auto& domain : domains) {
+        if (!(domain.size > 0.)) { throw std::runtime_error(std::string("The element size must be positive.\n")); }
+        const auto too_small = [](const auto& loop) { return loop.size() < 3; };
+        if (too_small(domain.boundary) || std::any_of(std::cbegin(domain.holes), std::cend(domain.holes), too_small)) {
+            throw std::runtime_error(std::string("Domain boundaries and holes need at least 3 points.\n"));
+        }
+    }
+    return DomainMesher{ domains }.mesh();
+}
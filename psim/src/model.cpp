@@ -1,9 +1,16 @@
 #include "psim/model.h"
+#include "psim/diffusionSolver.h"
 #include "psim/geometry.h"
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <execution>
 #include <iostream>
+#include <numeric>
 #include <ranges>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace {
 // Maximum number of simulations resets
@@ -23,6 +30,162 @@ constexpr double SS_STEPS_PERCENT{ 0.1 };
 // Temperature intervals to create distribution tables. A smaller interval may increase precision
 // but will take up more memory. Primarily a concern for transient simulations
 constexpr float TEMP_INTERVAL{ .1F };
+// Resolution (bits per axis) of the grid the cell centroids are snapped to before computing their Hilbert index
+constexpr unsigned HILBERT_ORDER{ 16 };
+// Smallest capacity the cell and sensor storage grows to when more entries are added than expected
+constexpr std::size_t MIN_CAPACITY{ 64 };
+// Expected arena memory used by a triangular cell with a couple of sub-surfaces - only sets the first block size
+constexpr std::size_t ARENA_BYTES_PER_CELL{ 1024 };
+// Orientations of the candidate mirror axes - vertical, horizontal and the two diagonals
+constexpr std::size_t NUM_MIRROR_AXES{ 4 };
+// Relative tolerance on the area of a cell's mirror image covered by other cells
+constexpr double MIRROR_AREA_TOLERANCE{ 1e-6 };
+// Fraction of the phonons simulated by the pilot run that sets the sensor importances
+constexpr double PILOT_FRACTION{ 0.1 };
+// Prior number of samples added to each sensor's pilot count - sparse pilots then leave importances near 1
+constexpr double PILOT_PRIOR_SAMPLES{ 10. };
+// Sensor importances are kept within [1 / MAX_IMPORTANCE, MAX_IMPORTANCE] so that splitting cannot run away
+constexpr double MAX_IMPORTANCE{ 10. };
+// Hybrid simulations stop the coupling iterations once no interface temperature changes by more than this fraction
+// of the largest emitting surface deviation from t_eq, or after MAX_COUPLING_ITERS pilot runs. The noise of the pilot
+// runs limits how far the interface temperatures can converge
+constexpr double COUPLING_TOLERANCE{ 0.01 };
+constexpr std::size_t MAX_COUPLING_ITERS{ 10 };
+// Adaptive runs split num_phonons into this many batches and check the error targets from the MIN_ADAPTIVE_BATCHES
+// batch on - a single batch gives a poor estimate of its own standard errors
+constexpr std::size_t ADAPTIVE_BATCHES{ 20 };
+constexpr std::size_t MIN_ADAPTIVE_BATCHES{ 2 };
+
+// Position of the grid point (x, y) along a Hilbert curve filling a 2^HILBERT_ORDER x 2^HILBERT_ORDER grid
+std::uint64_t hilbertIndex(std::uint32_t x, std::uint32_t y) noexcept {// NOLINT
+    std::uint64_t index = 0;
+    for (std::uint32_t s = 1U << (HILBERT_ORDER - 1); s > 0; s >>= 1U) {// NOLINT
+        const std::uint32_t rx = ((x & s) > 0) ? 1 : 0;// NOLINT
+        const std::uint32_t ry = ((y & s) > 0) ? 1 : 0;// NOLINT
+        index += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the curve remains continuous
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+// The candidate mirror axis of the given orientation through the centre of the bounding box. Diagonals are only
+// candidates for square boxes.
+std::optional<Geometry::Line> mirrorAxis(const Geometry::PointPair& box, std::size_t orientation) {
+    const auto& [bl, tr] = box;
+    const Geometry::Point centre{ (bl.x + tr.x) / 2., (bl.y + tr.y) / 2. };
+    switch (orientation) {
+    case 0:
+        return Geometry::Line{ { centre.x, bl.y }, { centre.x, tr.y } };
+    case 1:
+        return Geometry::Line{ { tr.x, centre.y }, { bl.x, centre.y } };
+    case 2:
+        if (Utils::approxEqual(tr.x - bl.x, tr.y - bl.y)) { return Geometry::Line{ bl, tr }; }
+        return std::nullopt;
+    default:
+        if (Utils::approxEqual(tr.x - bl.x, tr.y - bl.y)) { return Geometry::Line{ { tr.x, bl.y }, { bl.x, tr.y } }; }
+        return std::nullopt;
+    }
+}
+
+// Signed distance of p from the infinite line through line (positive on the left), 0 within GEOEPS
+double lineDistance(const Geometry::Line& line, const Geometry::Point& p) noexcept {// NOLINT
+    const double distance = Geometry::orient2d(line.p1, line.p2, p) / line.length;
+    return (std::fabs(distance) < GEOEPS) ? 0. : distance;
+}
+
+// Length shared by two collinear segments, 0 if they are not collinear
+double sharedLength(const Geometry::Line& line, const Geometry::Line& other) noexcept {
+    if (lineDistance(line, other.p1) != 0. || lineDistance(line, other.p2) != 0.) { return 0.; }
+    auto along = [&line](const Geometry::Point& p) {
+        return ((p.x - line.p1.x) * (line.p2.x - line.p1.x) + (p.y - line.p1.y) * (line.p2.y - line.p1.y))
+               / line.length;
+    };
+    const auto [low, high] = std::minmax({ along(other.p1), along(other.p2) });
+    return std::max(std::min(high, line.length) - std::max(low, 0.), 0.);
+}
+
+// 1 if the polygon lies on the left of (or on) the axis, -1 if it lies on the right and 0 if the axis cuts it
+int axisSide(const Geometry::Polygon& polygon, const Geometry::Line& axis) noexcept {
+    const auto [low, high] = std::ranges::minmax(
+        polygon.points | std::views::transform([&axis](const auto& p) { return lineDistance(axis, p); }));
+    if (low >= 0.) { return 1; }
+    return (high <= 0.) ? -1 : 0;
+}
+
+// The part of line on the left of (or on) the axis or nullopt if there is none
+std::optional<Geometry::Line> clipLine(const Geometry::Line& line, const Geometry::Line& axis) {
+    const double side_1 = lineDistance(axis, line.p1);
+    const double side_2 = lineDistance(axis, line.p2);
+    if (side_1 >= 0. && side_2 >= 0.) { return line; }
+    if (side_1 <= 0. && side_2 <= 0.) { return std::nullopt; }
+    const double t = side_1 / (side_1 - side_2);
+    const Geometry::Point cut{ line.p1.x + t * (line.p2.x - line.p1.x), line.p1.y + t * (line.p2.y - line.p1.y) };
+    return (side_1 > 0.) ? Geometry::Line{ line.p1, cut } : Geometry::Line{ cut, line.p2 };
+}
+
+// True if other, a cell overlapping the mirror image of cell, holds the same material and initial temperature and
+// the boundary edges the two cells have in common after the reflection share the same specularity
+bool mirrorsCell(const Cell& cell, const Cell& other, const Geometry::Transform& mirror) {
+    if (cell.getMaterialID() != other.getMaterialID() || !Utils::approxEqual(cell.getInitTemp(), other.getInitTemp())) {
+        return false;
+    }
+    return std::ranges::all_of(cell.getBoundaries(), [&](const auto& boundary) {
+        const auto image = mirror.apply(boundary.getSurfaceLine());
+        return std::ranges::all_of(other.getBoundaries(), [&](const auto& other_boundary) {
+            return sharedLength(image, other_boundary.getSurfaceLine()) < GEOEPS
+                   || Utils::approxEqual(boundary.getSpecularity(), other_boundary.getSpecularity());
+        });
+    });
+}
+
+SensorMeasurements mirrorMeasurement(SensorMeasurements measurement,
+    std::size_t ID,// NOLINT
+    const Geometry::Transform& mirror) noexcept {
+    using Vector2D = Geometry::Vector2D;
+    measurement.id = ID;
+    const auto flux = mirror.apply(Vector2D{ measurement.x_flux, measurement.y_flux });
+    // The mirror axes are axis aligned or diagonal, so the standard deviations are at most swapped
+    const auto std_flux = mirror.apply(Vector2D{ measurement.std_x_flux, measurement.std_y_flux });
+    measurement.x_flux = flux.x;
+    measurement.y_flux = flux.y;
+    measurement.std_x_flux = std::fabs(std_flux.x);
+    measurement.std_y_flux = std::fabs(std_flux.y);
+    for (auto& step_flux : measurement.final_fluxes) {
+        const auto image = mirror.apply(Vector2D{ step_flux[0], step_flux[1] });
+        step_flux = { image.x, image.y };
+    }
+    return measurement;
+}
+
+// Averages the measurement with its mirror image, which removes the flux perpendicular to the mirror axis
+void symmetrizeMeasurement(SensorMeasurements& measurement, const Geometry::Transform& mirror) noexcept {
+    using Vector2D = Geometry::Vector2D;
+    auto average = [&mirror](const Vector2D& v) {
+        const auto image = mirror.apply(v);
+        return Vector2D{ (v.x + image.x) / 2., (v.y + image.y) / 2. };
+    };
+    const auto flux = average({ measurement.x_flux, measurement.y_flux });
+    // Each averaged component is a fixed combination of the measured components
+    const auto from_x = average({ 1., 0. });
+    const auto from_y = average({ 0., 1. });
+    const auto std_x = measurement.std_x_flux;
+    const auto std_y = measurement.std_y_flux;
+    measurement.x_flux = flux.x;
+    measurement.y_flux = flux.y;
+    measurement.std_x_flux = std::hypot(from_x.x * std_x, from_y.x * std_y);
+    measurement.std_y_flux = std::hypot(from_x.y * std_x, from_y.y * std_y);
+    for (auto& step_flux : measurement.final_fluxes) {
+        const auto step = average({ step_flux[0], step_flux[1] });
+        step_flux = { step.x, step.y };
+    }
+}
 }// namespace
 
 using Point = Geometry::Point;
@@ -30,21 +193,71 @@ using Line = Geometry::Line;
 
 Model::Model(const ModelParams& params)
     : num_runs_{ params.num_runs }
-    , num_cells_{ params.num_cells }
     , measurement_steps_{ params.measurement_steps }
     , simulation_time_{ params.simulation_time }
     , num_phonons_{ params.num_phonons }
     , t_eq_{ params.t_eq }
     , phasor_sim_{ params.phasor_sim }
+    , importance_sampling_{ params.importance_sampling }
+    , emission_bias_{ params.emission_bias || !params.target_sensors.empty() }
+    , target_sensors_{ params.target_sensors }
+    , annihilation_{ params.annihilation }
+    , kinetic_{ params.kinetic || !params.diffusive_sensors.empty() || params.diffusive_knudsen > 0. }
+    , adjoint_sensors_{ params.adjoint_sensors }
+    , diffusive_sensors_{ params.diffusive_sensors }
+    , diffusive_knudsen_{ params.diffusive_knudsen }
+    , ensemble_{ params.ensemble }
+    , target_temp_error_{ params.target_temp_error }
+    , target_flux_error_{ params.target_flux_error }
+    , time_budget_{ params.time_budget }
+    , error_batches_{ params.error_batches }
     , simulator_{ params.measurement_steps, params.simulation_time, params.phasor_sim }
     , interpreter_{}
-    , addMeasurementMutex_{ std::make_unique<std::mutex>() } {
+    , addMeasurementMutex_{ std::make_unique<std::mutex>() }
+    , arena_{ std::make_unique<std::pmr::monotonic_buffer_resource>(
+          std::max(params.num_cells, MIN_CAPACITY) * ARENA_BYTES_PER_CELL) } {
+    if (importance_sampling_ && emission_bias_) {
+        throw std::runtime_error(std::string("Emission biasing cannot be combined with importance sampling.\n"));
+    }
+    if (kinetic_ && (phasor_sim_ || t_eq_ == 0.)) {// NOLINT(clang-diagnostic-float-equal)
+        throw std::runtime_error(
+            std::string("Kinetic steady-state simulations must be run using the deviational approach.\n"));
+    }
+    if (kinetic_ && annihilation_) {
+        throw std::runtime_error(std::string("Annihilation cannot be combined with the kinetic solver.\n"));
+    }
+    if (!adjoint_sensors_.empty() && (phasor_sim_ || t_eq_ == 0.)) {// NOLINT(clang-diagnostic-float-equal)
+        throw std::runtime_error(std::string("Adjoint simulations must be run using the deviational approach.\n"));
+    }
+    if (!adjoint_sensors_.empty() && (importance_sampling_ || emission_bias_ || annihilation_ || kinetic_)) {
+        throw std::runtime_error(std::string("Adjoint simulations cannot be combined with importance sampling, "
+                                             "emission biasing, annihilation or the kinetic solver.\n"));
+    }
+    if (isHybrid() && (importance_sampling_ || emission_bias_)) {
+        throw std::runtime_error(std::string(
+            "Hybrid diffusion simulations cannot be combined with importance sampling or emission biasing.\n"));
+    }
+    if (target_temp_error_ < 0. || target_flux_error_ < 0. || time_budget_ < 0.) {
+        throw std::runtime_error(std::string("Error targets and time budgets cannot be negative.\n"));
+    }
+    if (isAdaptive() && (!adjoint_sensors_.empty() || isHybrid())) {
+        throw std::runtime_error(
+            std::string("Adaptive stopping cannot be combined with adjoint or hybrid diffusion simulations.\n"));
+    }
+    if (error_batches_ > 1 && (kinetic_ || annihilation_ || ensemble_ || !adjoint_sensors_.empty())) {
+        throw std::runtime_error(std::string("Error batches cannot be combined with the kinetic solver, annihilation, "
+                                             "ensemble runs or adjoint simulations.\n"));
+    }
+    simulator_.setAnnihilation(annihilation_);
+    simulator_.setKinetic(kinetic_);
+    interpreter_.setBatched(kinetic_);
     cells_.reserve(params.num_cells);
     sensors_.reserve(params.num_sensors);
 }
 
 void Model::setSimulationType(SimulationType type, std::size_t step_interval) {
     sim_type_ = type;
+    step_interval_ = step_interval;
     // Throwing here so the user doesn't run a full simulation only to realize after that they
     // are using the incorrect settings.
     if (type == SimulationType::Transient || type == SimulationType::Periodic) {
@@ -55,6 +268,12 @@ void Model::setSimulationType(SimulationType type, std::size_t step_interval) {
                 std::string("Step interval of 0 is invalid for transient and periodic simulations.\n"));
         }
     }
+    if (!adjoint_sensors_.empty() && type == SimulationType::Periodic) {
+        throw std::runtime_error(std::string("Adjoint simulations cannot be periodic.\n"));
+    }
+    if (kinetic_ && type != SimulationType::SteadyState) {
+        throw std::runtime_error(std::string("The kinetic solver only runs steady-state simulations.\n"));
+    }
     if ((type == SimulationType::Transient && t_eq_ == 0)) {// NOLINT(clang-diagnostic-float-equal)
         throw std::runtime_error(std::string("Transient simulations must be run using the deviational approach.\n"));
     }
@@ -82,34 +301,33 @@ void Model::addSensor(std::size_t ID,// NOLINT
     const std::string& material_name,
     double t_init,
     SimulationType type) {
-    const auto sensor = std::ranges::find_if(sensors_, [&ID](auto& s) {// NOLINT
-        return s.getID() == ID;
-    });
-    if (sensor == std::end(sensors_)) {
+    if (!sensor_index_.contains(ID)) {
         const std::size_t steps_to_record = (type == SimulationType::SteadyState) ? static_cast<std::size_t>(
                                                 static_cast<double>(measurement_steps_) * SS_STEPS_PERCENT)
                                                                                   : measurement_steps_;// NOLINT
+        if (sensors_.size() == sensors_.capacity()) { reserveSensors(std::max(sensors_.size() * 2, MIN_CAPACITY)); }
         sensors_.emplace_back(ID, materials_.at(material_name), type, steps_to_record, t_init);
+        sensor_index_.emplace(ID, sensors_.size() - 1);
     } else {
         throw std::runtime_error(std::string("Sensor with this ID already exists\n"));
     }
 }
 
-void Model::addCell(Geometry::Triangle triangle, std::size_t sensor_ID, double spec) {
-    if (cells_.size() >= num_cells_) { throw std::runtime_error(std::string("Too many cells\n")); }
-    cells_.emplace_back(triangle, getSensor(sensor_ID), spec);
+void Model::addCell(const Geometry::Polygon& polygon, std::size_t sensor_ID, double spec) {
+    if (cells_.size() == cells_.capacity()) { reserveCells(std::max(cells_.size() * 2, MIN_CAPACITY)); }
+    cells_.emplace_back(polygon, getSensor(sensor_ID), spec, arena_.get());
     Cell& inc_cell = cells_.back();
-    std::size_t identical_cells = 0;// Should only be 1 identical cell (check against itself)
-    for (auto& cell : cells_) {
-        if (inc_cell != cell) {
-            // Throws if the incoming cell is incompatible with any existing cells
-            // TODO: Misses cases when all 3 points of a cell are on the edges of another cell
-            inc_cell.validate(cell);
-            inc_cell.findTransitionSurface(cell);
-        } else if (++identical_cells == 2) {// else { ++identical_cells; if (identical_cells == 2) { throw } }
-            throw std::runtime_error(std::string("Duplicate cell detected.\n"));
-        }
+    const auto box = inc_cell.getBoundingBox();
+    // Only cells whose bounding boxes touch the incoming cell can conflict with it or share a transition surface
+    for (const auto index : cell_index_.query(box)) {
+        auto& cell = cells_[index];
+        if (inc_cell == cell) { throw std::runtime_error(std::string("Duplicate cell detected.\n")); }
+        // Throws if the incoming cell is incompatible with any existing cells
+        // TODO: Misses cases when all 3 points of a cell are on the edges of another cell
+        inc_cell.validate(cell);
+        inc_cell.findTransitionSurface(cell);
     }
+    cell_index_.insert(cells_.size() - 1, box);
 }
 
 // Not used if the python interface is used
@@ -117,8 +335,84 @@ void Model::addCell(Point&& p1, Point&& p2, std::size_t sensor_ID, double spec)
     if (Utils::approxEqual(p1.x, p2.x) || Utils::approxEqual(p1.y, p2.y)) {
         throw std::runtime_error(std::string("These points do not specify a rectangle\n"));
     }
-    addCell(Geometry::Triangle{ p1, { p1.x, p2.y }, { p2.x, p1.y } }, sensor_ID, spec);
-    addCell(Geometry::Triangle{ p2, { p2.x, p1.y }, { p1.x, p2.y } }, sensor_ID, spec);
+    addCell(Geometry::Polygon{ std::vector<Point>{ p1, { p2.x, p1.y }, p2, { p1.x, p2.y } } }, sensor_ID, spec);
+}
+
+void Model::addMesh(const Mesh& mesh, const std::vector<std::size_t>& sensor_IDs, const std::vector<double>& specs) {
+    if (sensor_IDs.size() != mesh.elements.size() || specs.size() != mesh.elements.size()) {
+        throw std::runtime_error(std::string("Each mesh element needs a sensor and a specularity.\n"));
+    }
+    reserveCells(cells_.size() + mesh.elements.size());
+    const auto first_cell = cells_.size();
+    for (std::size_t element = 0; element < mesh.elements.size(); ++element) {
+        cells_.emplace_back(
+            mesh.triangle(mesh.elements[element]), getSensor(sensor_IDs[element]), specs[element], arena_.get());
+        Cell& inc_cell = cells_.back();
+        const auto box = inc_cell.getBoundingBox();
+        // Mesh elements are linked to each other below, but must still be checked against and joined to earlier cells
+        for (const auto index : cell_index_.query(box)) {
+            if (index >= first_cell) { continue; }
+            auto& cell = cells_[index];
+            if (inc_cell == cell) { throw std::runtime_error(std::string("Duplicate cell detected.\n")); }
+            inc_cell.validate(cell);
+            inc_cell.findTransitionSurface(cell);
+        }
+        cell_index_.insert(cells_.size() - 1, box);
+    }
+    // Interior edges are seen exactly twice - once from each adjacent element
+    auto edgeKey = [](std::size_t n1, std::size_t n2) {// NOLINT
+        const auto [low, high] = std::minmax(n1, n2);
+        return std::pair{ low, high };
+    };
+    auto edgeHash = [](const std::pair<std::size_t, std::size_t>& key) {
+        return std::hash<std::size_t>{}(key.first) ^ (std::hash<std::size_t>{}(key.second) * 0x9E3779B97F4A7C15ULL);// NOLINT
+    };
+    std::unordered_map<std::pair<std::size_t, std::size_t>, std::size_t, decltype(edgeHash)> open_edges(
+        mesh.elements.size() * 2, edgeHash);// NOLINT
+    for (std::size_t element = 0; element < mesh.elements.size(); ++element) {
+        const auto& nodes = mesh.elements[element].nodes;
+        for (std::size_t side = 0; side < nodes.size(); ++side) {
+            const auto n1 = nodes[side];
+            const auto n2 = nodes[(side + 1) % nodes.size()];
+            const auto [edge, inserted] = open_edges.try_emplace(edgeKey(n1, n2), element);
+            if (inserted) { continue; }
+            if (edge->second == mesh.elements.size()) {
+                throw std::runtime_error(std::string("A mesh edge is shared by more than two elements.\n"));
+            }
+            cells_[first_cell + element].linkTransitionSurface(
+                Line{ mesh.nodes[n1], mesh.nodes[n2] }, cells_[first_cell + edge->second]);
+            edge->second = mesh.elements.size();// Mark the edge as closed
+        }
+    }
+}
+
+void Model::addInstance(const GeometryTemplate& geometry,
+    const Geometry::Transform& transform,
+    const std::vector<std::size_t>& sensor_IDs) {
+    if (sensor_IDs.size() < geometry.numSensors()) {
+        throw std::runtime_error(std::string("The instance does not map every sensor of its template.\n"));
+    }
+    const auto& template_cells = geometry.getCells();
+    const auto first_cell = cells_.size();
+    if (const auto required = first_cell + template_cells.size(); required > cells_.capacity()) {
+        reserveCells(std::max({ required, cells_.size() * 2, MIN_CAPACITY }));
+    }
+    for (const auto& [polygon, sensor, spec] : template_cells) {
+        cells_.emplace_back(transform.apply(polygon), getSensor(sensor_IDs[sensor]), spec, arena_.get());
+        Cell& inc_cell = cells_.back();
+        const auto box = inc_cell.getBoundingBox();
+        for (const auto index : cell_index_.query(box)) {
+            if (index >= first_cell) { continue; }// Cells of this instance were checked when the template was built
+            auto& cell = cells_[index];
+            if (inc_cell == cell) { throw std::runtime_error(std::string("Duplicate cell detected.\n")); }
+            inc_cell.validate(cell);
+            inc_cell.findTransitionSurface(cell);
+        }
+        cell_index_.insert(cells_.size() - 1, box);
+    }
+    for (const auto& [cell, other, line] : geometry.getLinks()) {
+        cells_[first_cell + cell].linkTransitionSurface(transform.apply(line), cells_[first_cell + other]);
+    }
 }
 
 // TODO: Fix emit surface placement failing when incoming surface is not exact in rare circumstances
@@ -131,49 +425,162 @@ bool Model::setEmitSurface(const Point& p1, const Point& p2, double temp, double
     if ((start_time > 0. || duration < simulation_time_) && sim_type_ != SimulationType::Transient) {
         throw std::runtime_error(std::string("Cannot add a transient surface to a non transient simulation.\n"));
     }
-    for (auto& cell : cells_) {
-        if (cell.setEmitSurface(Line{ p1, p2 }, temp, duration, start_time)) { return true; }
+    const Line line{ p1, p2 };
+    for (const auto index : cell_index_.query(line.boundingBox)) {
+        if (cells_[index].setEmitSurface(line, temp, duration, start_time)) { return true; }
     }
     return false;
 }
 
+bool Model::setPeriodicSurface(const Point& p1, const Point& p2, const Point& q1, const Point& q2) {// NOLINT
+    if (q2 - q1 != p2 - p1) {
+        throw std::runtime_error(std::string("Periodic surfaces must be translated copies of each other.\n"));
+    }
+    const Line line{ p1, p2 };
+    const Line paired{ q1, q2 };
+    Cell* cell = findBoundaryCell(line);
+    Cell* paired_cell = findBoundaryCell(paired);
+    if (cell == nullptr || paired_cell == nullptr) { return false; }
+    if (cell->getMaterialID() != paired_cell->getMaterialID()) {
+        throw std::runtime_error(std::string("Periodic surfaces must join cells of the same material.\n"));
+    }
+    // Both sides are checked first so a failure never leaves a one-sided pairing
+    if (!cell->canAddSurface(line) || !paired_cell->canAddSurface(paired)) { return false; }
+    const Geometry::Vector2D offset{ q1.x - p1.x, q1.y - p1.y };
+    return cell->setPeriodicSurface(line, *paired_cell, offset)
+           && paired_cell->setPeriodicSurface(paired, *cell, { -offset.x, -offset.y });
+}
+
+void Model::reorderCells(bool reorder_sensors) {
+    if (cells_.size() < 2) { return; }
+    std::vector<Point> centroids;
+    centroids.reserve(cells_.size());
+    std::ranges::transform(cells_, std::back_inserter(centroids), [](const auto& cell) { return cell.getCentroid(); });
+    const auto [min_x, max_x] = std::ranges::minmax(centroids | std::views::transform(&Point::x));
+    const auto [min_y, max_y] = std::ranges::minmax(centroids | std::views::transform(&Point::y));
+    const double extent = std::max({ max_x - min_x, max_y - min_y, GEOEPS });
+    const double grid_max = static_cast<double>((1U << HILBERT_ORDER) - 1);
+
+    std::vector<std::uint64_t> keys(cells_.size());
+    std::ranges::transform(centroids, std::begin(keys), [&](const auto& centroid) {
+        return hilbertIndex(static_cast<std::uint32_t>((centroid.x - min_x) / extent * grid_max),
+            static_cast<std::uint32_t>((centroid.y - min_y) / extent * grid_max));
+    });
+    std::vector<std::size_t> cell_order(cells_.size());
+    std::iota(std::begin(cell_order), std::end(cell_order), 0);
+    std::ranges::stable_sort(cell_order, [&keys](auto lhs, auto rhs) { return keys[lhs] < keys[rhs]; });
+    permuteCells(cell_order);
+
+    if (!reorder_sensors) { return; }
+    // Sensors follow the order in which their first cell appears along the curve
+    std::vector<std::size_t> sensor_order;
+    sensor_order.reserve(sensors_.size());
+    std::vector<bool> placed(sensors_.size(), false);
+    for (const auto& cell : cells_) {
+        const auto index = static_cast<std::size_t>(&getSensor(cell.getSensorID()) - sensors_.data());
+        if (!placed[index]) {
+            placed[index] = true;
+            sensor_order.push_back(index);
+        }
+    }
+    // Sensors without any cells keep their relative order at the end
+    for (std::size_t index = 0; index < sensors_.size(); ++index) {
+        if (!placed[index]) { sensor_order.push_back(index); }
+    }
+    permuteSensors(sensor_order);
+}
+
+std::size_t Model::reduceSymmetry() {
+    const bool periodic = std::ranges::any_of(cells_, [](const auto& cell) {
+        return std::ranges::any_of(
+            cell.getBoundaries(), [](const auto& boundary) { return !boundary.getPeriodicSurfaces().empty(); });
+    });
+    // Adjoint runs only follow particles from their own sensors, so halving the model saves nothing
+    if (cells_.empty() || periodic || !adjoint_sensors_.empty()) { return 0; }
+    // Reflections about perpendicular axes commute, so an axis that fails is not retested on the reduced model
+    std::size_t reductions = 0;
+    for (std::size_t orientation = 0; orientation < NUM_MIRROR_AXES; ++orientation) {
+        auto box = cells_.front().getBoundingBox();
+        for (const auto& cell : cells_) {
+            const auto [bl, tr] = cell.getBoundingBox();
+            box = { { std::min(box.first.x, bl.x), std::min(box.first.y, bl.y) },
+                { std::max(box.second.x, tr.x), std::max(box.second.y, tr.y) } };
+        }
+        const auto axis = mirrorAxis(box, orientation);
+        if (!axis) { continue; }
+        if (const auto mirror_sensors = findMirrorSensors(*axis)) {
+            removeMirrorHalf(*axis, *mirror_sensors);
+            std::cout << "Mirror symmetry about " << *axis << " - simulating half of the model\n";
+            ++reductions;
+        }
+    }
+    return reductions;
+}
+
 // TODO: Change cout to logging
 void Model::runSimulation() {
+    if ((target_temp_error_ > 0. || target_flux_error_ > 0.) && sim_type_ != SimulationType::SteadyState) {
+        throw std::runtime_error(std::string("Error targets can only be used in steady-state simulations.\n"));
+    }
+    if (error_batches_ > 1 && sim_type_ != SimulationType::SteadyState) {
+        throw std::runtime_error(std::string("Error batches can only be used in steady-state simulations.\n"));
+    }
+    if (!adjoint_sensors_.empty()) {
+        runAdjoint();
+        return;
+    }
+    const auto emitting = std::ranges::any_of(cells_, [this](const auto& cell) {
+        return std::ranges::any_of(cell.getBoundaries(), [this](const auto& boundary) {
+            return std::ranges::any_of(boundary.getEmitSurfaces(),
+                [this](const auto& es) { return !Utils::approxEqual(es.getTemp(), t_eq_); });
+        });
+    });
+    if (kinetic_ && !emitting) {
+        throw std::runtime_error(
+            std::string("The kinetic solver needs an emitting surface with a temperature other than t_eq.\n"));
+    }
+    if (isHybrid()) {
+        runHybrid();
+        return;
+    }
+    if (emission_bias_) { buildEmissionBias(); }
+    if (importance_sampling_) { buildImportanceMap(); }
+    if (error_batches_ > 1) {// After the pilots, which record a single batch
+        for (auto& sensor : sensors_) { sensor.setTallySets(error_batches_); }
+        simulator_.setErrorBatches(error_batches_);
+        interpreter_.setErrorBatches(error_batches_);
+    }
+    if (ensemble_ && num_runs_ > 1) {
+        runEnsemble();
+        return;
+    }
     for (std::size_t runId = 0; runId < num_runs_; ++runId) {
         std::cout << "Run: " << runId + 1 << '\n';
         // TODO: could run checks here to verify there is at least 1 sensor/cell etc.
         const auto [min, max] = setTemperatureBounds();
         initializeMaterialTables(min, max);
-
-        auto refresh = [this]() {
-            auto total_energy = getTotalInitialEnergy();
-            double energy_per_phonon = total_energy / static_cast<double>(num_phonons_);// NOLINT
-            interpreter_.setParams(t_eq_, energy_per_phonon);
-            return std::pair{ total_energy, energy_per_phonon };
-        };
-
-        auto [total_energy, energy_per_phonon] = refresh();
+        auto energy_per_phonon = updatePhononEnergy();
 
         std::size_t iter = 0;
         bool reset_required = true;
         while (reset_required && ++iter <= MAX_ITERS) {
-            simulator_.initPhononBuilders(cells_, t_eq_, energy_per_phonon);
-            simulator_.runSimulation(t_eq_);
+            runPhonons(energy_per_phonon);
             // Check if sensor temperatures are stable
             if (const auto new_t_eq = resetRequired(); new_t_eq && iter < MAX_ITERS && !phasor_sim_) {
                 reset();
                 t_eq_ = *new_t_eq;
                 std::cout << "system not stable\n";
                 std::cout << "updated t_eq: " << t_eq_ << '\n';
+                energy_per_phonon = updatePhononEnergy();
             } else {
                 reset_required = false;
             }
-            std::tie(total_energy, energy_per_phonon) = refresh();
         }
         if (iter >= MAX_ITERS) {
             // Should log this or include in output title
             std::cout << "System did not stabilize!!\n";
         }
+        reportRescues();
         storeResults(runId);
         if (runId + 1 < num_runs_) {
             reset(true);// Full reset (return sensors to t_init)
@@ -181,22 +588,623 @@ void Model::runSimulation() {
     }
 }
 
+void Model::runEnsemble() {
+    std::cout << "Runs 1-" << num_runs_ << " simulated together\n";
+    const auto [min, max] = setTemperatureBounds();
+    initializeMaterialTables(min, max);
+    auto energy_per_phonon = updatePhononEnergy();
+    for (auto& sensor : sensors_) { sensor.setTallySets(num_runs_); }
+    // Steady-state sensors only record the steps after start_step_
+    const auto set_size = sensors_.front().getMeasurements();
+    std::vector<ModelSimulator> members;
+    members.reserve(num_runs_ - 1);
+    for (std::size_t runId = 1; runId < num_runs_; ++runId) {
+        members.push_back(simulator_.ensembleMember(runId * set_size));
+    }
+
+    std::size_t iter = 0;
+    bool reset_required = true;
+    while (reset_required && ++iter <= MAX_ITERS) {
+        runPhonons(energy_per_phonon, members);
+        if (const auto new_t_eq = resetRequired(); new_t_eq && iter < MAX_ITERS && !phasor_sim_) {
+            reset();
+            for (auto& member : members) { member.reset(); }
+            t_eq_ = *new_t_eq;
+            std::cout << "system not stable\n";
+            std::cout << "updated t_eq: " << t_eq_ << '\n';
+            energy_per_phonon = updatePhononEnergy();
+        } else {
+            reset_required = false;
+        }
+    }
+    if (iter >= MAX_ITERS) {
+        // Should log this or include in output title
+        std::cout << "System did not stabilize!!\n";
+    }
+    ensemble_rescues_ = std::transform_reduce(std::cbegin(members), std::cend(members), std::size_t{ 0 },
+        std::plus{}, [](const auto& member) { return member.getRescues(); });
+    std::cout << "Stuck phonons rescued: " << simulator_.getRescues() + ensemble_rescues_ << '\n';
+    for (std::size_t runId = 0; runId < num_runs_; ++runId) {
+        for (auto& sensor : sensors_) { sensor.selectTallySet(runId); }
+        storeResults(runId);
+    }
+}
+
+void Model::runPhonons(double energy_per_phonon, std::span<ModelSimulator> members) {
+    std::vector<ModelSimulator*> simulators{ &simulator_ };
+    std::ranges::transform(members, std::back_inserter(simulators), [](auto& member) { return &member; });
+    auto runBatch = [&](double batch_energy) {
+        // Each simulator already runs its phonons in parallel, running the ensemble members together fills the cores
+        // that a small model leaves idle
+        std::for_each(std::execution::par, std::begin(simulators), std::end(simulators), [&](auto* simulator) {
+            simulator->initPhononBuilders(cells_, t_eq_, batch_energy);
+            simulator->runSimulation(t_eq_);
+        });
+    };
+    if (!isAdaptive()) {
+        runBatch(energy_per_phonon);
+        return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    const auto batch_energy = energy_per_phonon * static_cast<double>(ADAPTIVE_BATCHES);
+    std::size_t batches = 0;
+    bool done = false;
+    while (!done && batches < ADAPTIVE_BATCHES) {
+        if (batches > 0) {// The phonons of the last batch are done, their tallies stay in the sensors
+            simulator_.reset();
+            for (auto& member : members) { member.reset(); }
+        }
+        runBatch(batch_energy);
+        ++batches;
+        interpreter_.setParams(t_eq_, batch_energy / static_cast<double>(batches));
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        done = time_budget_ > 0. && elapsed.count() >= time_budget_;
+        if ((target_temp_error_ > 0. || target_flux_error_ > 0.) && batches >= MIN_ADAPTIVE_BATCHES) {
+            const auto [temp_error, flux_error] = relativeErrors(members.size() + 1);
+            std::cout << "Batch " << batches << " - relative standard errors: temperature " << temp_error
+                      << ", flux " << flux_error << '\n';
+            auto met = [](double error, double target) { return target <= 0. || error <= target; };
+            done = done || (met(temp_error, target_temp_error_) && met(flux_error, target_flux_error_));
+        }
+    }
+    std::cout << "Simulated " << batches << " of " << ADAPTIVE_BATCHES << " phonon batches\n";
+}
+
+std::pair<double, double> Model::relativeErrors(std::size_t tally_sets) {
+    double temp_error = 0.;
+    double flux_error = 0.;
+    for (std::size_t set = 0; set < tally_sets; ++set) {
+        double max_deviation = 0.;
+        double max_flux = 0.;
+        double max_temp_std = 0.;
+        double max_flux_std = 0.;
+        for (auto& sensor : sensors_) {
+            if (sensor.getArea() == 0.) { continue; }// NOLINT(clang-diagnostic-float-equal)
+            sensor.selectTallySet(set);
+            const auto sm = interpreter_.scaleHeatParams(sensor);
+            max_deviation = std::max(max_deviation, std::fabs(sm.t_steady - t_eq_));
+            max_flux = std::max(max_flux, std::hypot(sm.x_flux, sm.y_flux));
+            max_temp_std = std::max(max_temp_std, sm.std_t_steady);
+            max_flux_std = std::max(max_flux_std, std::hypot(sm.std_x_flux, sm.std_y_flux));
+        }
+        // A model without any deviation or heat flux has nothing to resolve
+        if (max_deviation > 0.) { temp_error = std::max(temp_error, max_temp_std / max_deviation); }
+        if (max_flux > 0.) { flux_error = std::max(flux_error, max_flux_std / max_flux); }
+    }
+    for (auto& sensor : sensors_) { sensor.selectTallySet(0); }// Resets are decided on the first run
+    return { temp_error, flux_error };
+}
+
+double Model::updatePhononEnergy() {
+    const auto energy_per_phonon = getTotalInitialEnergy() / static_cast<double>(num_phonons_);
+    interpreter_.setParams(t_eq_, energy_per_phonon);
+    return energy_per_phonon;
+}
+
 void Model::exportResults(const fs::path& filepath, double time) const {
-    outputManager_.exportResults(filepath, time, num_runs_, sim_type_);
+    outputManager_.exportResults(filepath, time, num_runs_, sim_type_, simulator_.getRescues() + ensemble_rescues_);
 }
 
 Sensor& Model::getSensor(std::size_t ID) {// NOLINT
-    const auto sensor = std::ranges::find_if(sensors_, [&ID](auto& s) {// NOLINT
-        return s.getID() == ID;
-    });
-    if (sensor == std::end(sensors_)) { throw std::runtime_error(std::string("Sensor does not exist\n")); }
-    return *sensor;
+    const auto sensor = sensor_index_.find(ID);
+    if (sensor == std::end(sensor_index_)) { throw std::runtime_error(std::string("Sensor does not exist\n")); }
+    return sensors_[sensor->second];
+}
+
+Cell* Model::findBoundaryCell(const Line& line) {
+    for (const auto index : cell_index_.query(line.boundingBox)) {
+        if (std::ranges::any_of(cells_[index].getBoundaries(),
+                [&line](const auto& boundary) { return boundary.getSurfaceLine().contains(line); })) {
+            return &cells_[index];
+        }
+    }
+    return nullptr;
+}
+
+bool Model::reachesEmitSurface(const std::vector<Cell*>& start) const {
+    std::vector<bool> visited(cells_.size(), false);
+    std::vector<const Cell*> pending;
+    auto visit = [&](const Cell* cell) {
+        const auto index = static_cast<std::size_t>(cell - cells_.data());
+        if (visited[index]) { return; }
+        visited[index] = true;
+        pending.push_back(cell);
+    };
+    for (const auto* cell : start) { visit(cell); }
+    while (!pending.empty()) {
+        const auto* cell = pending.back();
+        pending.pop_back();
+        for (const auto& boundary : cell->getBoundaries()) {
+            if (!boundary.getEmitSurfaces().empty()) { return true; }
+            for (const auto& ts : boundary.getTransitionSurfaces()) { visit(ts.getCell()); }// NOLINT
+            for (const auto& ps : boundary.getPeriodicSurfaces()) { visit(ps.getCell()); }// NOLINT
+        }
+    }
+    return false;
+}
+
+std::optional<std::unordered_map<std::size_t, std::size_t>> Model::findMirrorSensors(const Line& axis) const {
+    const auto mirror = Geometry::Transform::reflection(axis);
+    // The cells do not need to be mirror images of each other one to one (a triangulated rectangle is symmetric
+    // even though its triangles are not). The image of every cell must be covered by cells of a single sensor.
+    std::unordered_map<std::size_t, std::size_t> mirror_sensors;
+    std::unordered_map<std::size_t, int> sensor_sides;// 0 if the sensor has cells on both sides or crossing the axis
+    for (const auto& cell : cells_) {
+        const auto image = mirror.apply(cell.getPolygon());
+        double covered = 0.;
+        std::optional<std::size_t> image_ID;
+        for (const auto index : cell_index_.query(image.boundingBox())) {
+            const auto overlap = image.intersection(cells_[index].getPolygon());
+            if (!overlap) { continue; }
+            const auto& other = cells_[index];
+            if ((image_ID && *image_ID != other.getSensorID()) || !mirrorsCell(cell, other, mirror)) {
+                return std::nullopt;
+            }
+            image_ID = other.getSensorID();
+            covered += overlap->area();
+        }
+        if (!image_ID || std::fabs(covered - image.area()) > MIRROR_AREA_TOLERANCE * image.area()) {
+            return std::nullopt;
+        }
+        const auto sensor_ID = cell.getSensorID();
+        if (mirror_sensors.try_emplace(sensor_ID, *image_ID).first->second != *image_ID) { return std::nullopt; }
+        const auto side = axisSide(cell.getPolygon(), axis);
+        if (auto& sensor_side = sensor_sides.try_emplace(sensor_ID, side).first->second; sensor_side != side) {
+            sensor_side = 0;
+        }
+    }
+    // A sensor that is not its own mirror image must be entirely on one side, so either it or its image is removed
+    for (const auto& [sensor_ID, image_ID] : mirror_sensors) {
+        if (sensor_ID != image_ID && sensor_sides[sensor_ID] == 0) { return std::nullopt; }
+    }
+    // The image of every emitting surface must be covered by emitting surfaces with the same settings
+    std::vector<const EmitSurface*> emit_surfaces;
+    for (const auto& cell : cells_) {
+        for (const auto& boundary : cell.getBoundaries()) {
+            for (const auto& es : boundary.getEmitSurfaces()) { emit_surfaces.push_back(&es); }// NOLINT
+        }
+    }
+    for (const auto* es : emit_surfaces) {
+        const auto image = mirror.apply(es->getSurfaceLine());
+        double covered = 0.;
+        for (const auto* other : emit_surfaces) {
+            if (Utils::approxEqual(other->getTemp(), es->getTemp())
+                && Utils::approxEqual(other->getEmitDuration(), es->getEmitDuration())
+                && Utils::approxEqual(other->getStartTime(), es->getStartTime())) {
+                covered += sharedLength(image, other->getSurfaceLine());
+            }
+        }
+        if (std::fabs(covered - image.length) > GEOEPS) { return std::nullopt; }
+    }
+    return mirror_sensors;
+}
+
+void Model::removeMirrorHalf(const Line& axis, const std::unordered_map<std::size_t, std::size_t>& mirror_sensors) {
+    struct HalfCell {
+        Geometry::Polygon polygon;
+        std::size_t sensor_ID;
+        std::vector<double> specs;// One per edge of the polygon
+    };
+    struct HalfEmitSurface {
+        Line line;
+        double temp;
+        double duration;
+        double start_time;
+    };
+    auto onAxis = [&axis](const Line& line) {
+        return lineDistance(axis, line.p1) == 0. && lineDistance(axis, line.p2) == 0.;
+    };
+    std::vector<HalfCell> half_cells;
+    std::vector<HalfEmitSurface> half_emit_surfaces;
+    std::unordered_set<std::size_t> removed_sensors;
+    for (const auto& cell : cells_) {
+        const auto sensor_ID = cell.getSensorID();
+        auto half = cell.getPolygon().clip(axis);
+        if (!half) {
+            if (mirror_sensors.at(sensor_ID) != sensor_ID) { removed_sensors.insert(sensor_ID); }
+            continue;
+        }
+        // Edges on the axis become mirrors, the other edges keep the specularity of the edge they are part of
+        const auto& boundaries = cell.getBoundaries();
+        std::vector<double> specs;
+        for (const auto& line : half->lines()) {
+            const auto boundary = std::ranges::find_if(
+                boundaries, [&line](const auto& surface) { return surface.getSurfaceLine().contains(line); });
+            specs.push_back((onAxis(line) || boundary == std::cend(boundaries)) ? 1. : boundary->getSpecularity());
+        }
+        half_cells.push_back({ std::move(*half), sensor_ID, std::move(specs) });
+        for (const auto& boundary : boundaries) {
+            for (const auto& es : boundary.getEmitSurfaces()) {// NOLINT
+                if (const auto line = clipLine(es.getSurfaceLine(), axis)) {
+                    half_emit_surfaces.push_back({ *line, es.getTemp(), es.getEmitDuration(), es.getStartTime() });
+                }
+            }
+        }
+    }
+    Reflection reflection{ axis, {}, {} };
+    for (const auto sensor_ID : removed_sensors) {
+        reflection.sensors.emplace_back(sensor_ID, mirror_sensors.at(sensor_ID));
+    }
+    for (const auto& [sensor_ID, image_ID] : mirror_sensors) {
+        if (sensor_ID == image_ID) { reflection.symmetric.push_back(sensor_ID); }
+    }
+    std::ranges::sort(reflection.sensors);
+    std::ranges::sort(reflection.symmetric);
+
+    // Rebuild the model from the kept half
+    cells_.clear();
+    cell_index_.clear();
+    std::erase_if(
+        sensors_, [&removed_sensors](const auto& sensor) { return removed_sensors.contains(sensor.getID()); });
+    sensor_index_.clear();
+    for (std::size_t index = 0; index < sensors_.size(); ++index) {
+        sensors_[index].resetArea();
+        sensor_index_.emplace(sensors_[index].getID(), index);
+    }
+    for (const auto& [polygon, sensor_ID, specs] : half_cells) {
+        addCell(polygon, sensor_ID, specs.front());
+        for (std::size_t edge = 1; edge < specs.size(); ++edge) { cells_.back().setSpecularity(edge, specs[edge]); }
+    }
+    for (const auto& [line, temp, duration, start_time] : half_emit_surfaces) {
+        if (!setEmitSurface(line.p1, line.p2, temp, duration, start_time)) {
+            throw std::runtime_error(std::string("Unable to add emitting surface to the reduced model.\n"));
+        }
+    }
+    // Each phonon carries the same energy as it would have in the full model
+    num_phonons_ = (num_phonons_ + 1) / 2;
+    reflections_.push_back(std::move(reflection));
+}
+
+void Model::addMirroredResults(std::size_t runId) {
+    auto& measurements = outputManager_.getMeasurements(runId);
+    std::unordered_map<std::size_t, std::size_t> positions;// Sensor ID -> position in measurements
+    for (std::size_t index = 0; index < measurements.size(); ++index) {
+        positions.emplace(measurements[index].id, index);
+    }
+    // The sources of the last reflection are all simulated, earlier reflections may copy results added by later ones
+    for (const auto& [axis, sensors, symmetric] : reflections_ | std::views::reverse) {
+        const auto mirror = Geometry::Transform::reflection(axis);
+        // Only the simulated half of these sensors was tallied
+        for (const auto sensor_ID : symmetric) { symmetrizeMeasurement(measurements[positions.at(sensor_ID)], mirror); }
+        for (const auto& [removed_ID, image_ID] : sensors) {
+            auto measurement = mirrorMeasurement(measurements[positions.at(image_ID)], removed_ID, mirror);
+            positions.emplace(removed_ID, measurements.size());
+            outputManager_.addMeasurement(runId, std::move(measurement));
+        }
+    }
+}
+
+void Model::reserveCells(std::size_t capacity) {
+    if (capacity <= cells_.capacity()) { return; }
+    std::vector<Cell> relocated;
+    relocated.reserve(capacity);
+    std::ranges::move(cells_, std::back_inserter(relocated));
+    const Cell* old_cells = cells_.data();
+    for (auto& cell : relocated) {
+        cell.relink([&](const Cell* old) { return &relocated[static_cast<std::size_t>(old - old_cells)]; },
+            [](Sensor* sensor) { return sensor; });
+    }
+    cells_ = std::move(relocated);
+}
+
+void Model::reserveSensors(std::size_t capacity) {
+    if (capacity <= sensors_.capacity()) { return; }
+    std::vector<Sensor> relocated;
+    relocated.reserve(capacity);
+    std::ranges::move(sensors_, std::back_inserter(relocated));
+    const Sensor* old_sensors = sensors_.data();
+    for (auto& cell : cells_) {
+        cell.relink([](Cell* other) { return other; },
+            [&](const Sensor* old) { return &relocated[static_cast<std::size_t>(old - old_sensors)]; });
+    }
+    sensors_ = std::move(relocated);
+}
+
+void Model::permuteCells(const std::vector<std::size_t>& new_order) {
+    std::vector<std::size_t> new_index(cells_.size());
+    std::vector<Cell> permuted;
+    permuted.reserve(cells_.capacity());
+    for (const auto old_index : new_order) {
+        new_index[old_index] = permuted.size();
+        permuted.push_back(std::move(cells_[old_index]));
+    }
+    const Cell* old_cells = cells_.data();
+    for (auto& cell : permuted) {
+        cell.relink(
+            [&](const Cell* old) { return &permuted[new_index[static_cast<std::size_t>(old - old_cells)]]; },
+            [](Sensor* sensor) { return sensor; });
+    }
+    cells_ = std::move(permuted);
+    cell_index_.clear();
+    for (std::size_t index = 0; index < cells_.size(); ++index) {
+        cell_index_.insert(index, cells_[index].getBoundingBox());
+    }
+}
+
+void Model::permuteSensors(const std::vector<std::size_t>& new_order) {
+    std::vector<std::size_t> new_index(sensors_.size());
+    std::vector<Sensor> permuted;
+    permuted.reserve(sensors_.capacity());
+    for (const auto old_index : new_order) {
+        new_index[old_index] = permuted.size();
+        permuted.push_back(std::move(sensors_[old_index]));
+    }
+    const Sensor* old_sensors = sensors_.data();
+    for (auto& cell : cells_) {
+        cell.relink([](Cell* other) { return other; },
+            [&](const Sensor* old) { return &permuted[new_index[static_cast<std::size_t>(old - old_sensors)]]; });
+    }
+    sensors_ = std::move(permuted);
+    for (std::size_t index = 0; index < sensors_.size(); ++index) { sensor_index_[sensors_[index].getID()] = index; }
+}
+
+std::size_t Model::keptSensorID(std::size_t ID) const noexcept {
+    for (const auto& reflection : reflections_) {
+        const auto removed = std::ranges::find(reflection.sensors, ID, &std::pair<std::size_t, std::size_t>::first);
+        if (removed != std::cend(reflection.sensors)) { ID = removed->second; }
+    }
+    return ID;
+}
+
+void Model::buildImportanceMap() {
+    std::cout << "Importance sampling pilot run\n";
+    simulator_.setImportanceSampling(false);
+    for (auto& sensor : sensors_) { sensor.setImportance(1.); }
+    const auto [min, max] = setTemperatureBounds();
+    initializeMaterialTables(min, max);
+    const auto pilot_phonons = std::max(1., PILOT_FRACTION * static_cast<double>(num_phonons_));
+    simulator_.initPhononBuilders(cells_, t_eq_, getTotalInitialEnergy() / pilot_phonons);
+    simulator_.runSimulation(t_eq_);
+
+    // Aim for the same density of samples (per unit area) in every sensor. Splitting cannot make up for a sensor
+    // being small, since the copies cross it along the same path, but it does fill regions phonons rarely reach.
+    // The prior density keeps sensors with few pilot samples, whose counts are mostly noise, close to the mean.
+    const auto total_area = std::transform_reduce(std::cbegin(sensors_), std::cend(sensors_), 0., std::plus{},
+        [](const Sensor& sensor) { return sensor.getArea(); });
+    const auto total_samples = std::transform_reduce(std::cbegin(sensors_), std::cend(sensors_), 0., std::plus{},
+        [](const Sensor& sensor) { return static_cast<double>(sensor.getSamples()); });
+    if (total_samples > 0.) {
+        const auto prior = PILOT_PRIOR_SAMPLES * static_cast<double>(sensors_.size()) / total_area;
+        auto importanceOf = [prior](const Sensor& sensor, double target) {
+            if (sensor.getArea() <= 0.) { return 1.; }
+            const auto density = static_cast<double>(sensor.getSamples()) / sensor.getArea() + prior;
+            return std::clamp(target / density, 1. / MAX_IMPORTANCE, MAX_IMPORTANCE);
+        };
+        auto target = total_samples / total_area + prior;
+        // Importances scale the samples a sensor receives - keep the expected total equal to the pilot's
+        const auto expected = std::transform_reduce(std::cbegin(sensors_), std::cend(sensors_), 0., std::plus{},
+            [&](const Sensor& sensor) {
+                return static_cast<double>(sensor.getSamples()) * importanceOf(sensor, target);
+            });
+        target *= total_samples / expected;
+        for (auto& sensor : sensors_) { sensor.setImportance(importanceOf(sensor, target)); }
+        const auto [least, most] = std::ranges::minmax(
+            sensors_ | std::views::transform([](const Sensor& sensor) { return sensor.getImportance(); }));
+        std::cout << "Sensor importances between " << least << " and " << most << '\n';
+    }
+    reset(true);
+    simulator_.setImportanceSampling(true);
+}
+
+void Model::buildEmissionBias() {
+    std::vector<std::size_t> targets;
+    for (const auto target : target_sensors_) {
+        const auto ID = keptSensorID(target);
+        if (!sensor_index_.contains(ID)) {
+            throw std::runtime_error("Target sensor " + std::to_string(ID) + " does not exist.\n");
+        }
+        targets.push_back(ID);
+    }
+    std::cout << "Emission bias pilot run\n";
+    simulator_.clearEmissionBias();
+    const auto [min, max] = setTemperatureBounds();
+    initializeMaterialTables(min, max);
+    const auto pilot_phonons = std::max(1., PILOT_FRACTION * static_cast<double>(num_phonons_));
+    simulator_.initPhononBuilders(cells_, t_eq_, getTotalInitialEnergy() / pilot_phonons);
+    simulator_.runEmissionPilot(t_eq_, std::move(targets));
+    reset(true);
+}
+
+void Model::runAdjoint() {
+    std::vector<ModelSimulator::AdjointProbe> probes;
+    std::vector<Sensor*> probe_sensors;
+    for (const auto ID : adjoint_sensors_) {
+        if (!sensor_index_.contains(ID)) {
+            throw std::runtime_error("Adjoint sensor " + std::to_string(ID) + " does not exist.\n");
+        }
+        probe_sensors.push_back(&getSensor(ID));
+        auto& [cells, energy_per_kelvin] = probes.emplace_back();
+        for (auto& cell : cells_) {
+            if (cell.getSensorID() == ID) { cells.push_back(&cell); }
+        }
+        if (cells.empty()) { throw std::runtime_error("Adjoint sensor " + std::to_string(ID) + " has no cells.\n"); }
+    }
+    if (std::ranges::any_of(cells_, [this](const auto& cell) {
+            return cell.getMaterialID() != cells_.front().getMaterialID();
+        })) {
+        throw std::runtime_error(std::string("Adjoint simulations require a single material.\n"));
+    }
+    for (const auto& cell : cells_) {
+        for (const auto& boundary : cell.getBoundaries()) {
+            for (const auto& es : boundary.getEmitSurfaces()) {// NOLINT
+                if (es.getStartTime() > 0. || es.getEmitDuration() < simulation_time_) {
+                    throw std::runtime_error(
+                        std::string("Adjoint simulations cannot use emitting surfaces that switch on or off.\n"));
+                }
+            }
+        }
+    }
+    const bool transient = sim_type_ == SimulationType::Transient;
+    // A steady-state particle that can never be absorbed would be followed forever
+    for (std::size_t probe = 0; probe < probes.size() && !transient; ++probe) {
+        if (!reachesEmitSurface(probes[probe].cells)) {
+            throw std::runtime_error(
+                "Adjoint sensor " + std::to_string(adjoint_sensors_[probe]) + " cannot reach an emitting surface.\n");
+        }
+    }
+    // Steady-state measurements are independent batches of the particles
+    interpreter_.setBatched(!transient);
+    const auto particles = std::max(num_phonons_ / adjoint_sensors_.size(), std::size_t{ 1 });
+    for (std::size_t runId = 0; runId < num_runs_; ++runId) {
+        std::cout << "Run: " << runId + 1 << " (adjoint)\n";
+        const auto [min, max] = setTemperatureBounds();
+        initializeMaterialTables(min, max);
+        interpreter_.setParams(t_eq_, 1.);// The scores are recorded in energy units
+        for (std::size_t probe = 0; probe < probes.size(); ++probe) {
+            const auto& sensor = *probe_sensors[probe];
+            probes[probe].energy_per_kelvin = sensor.getArea() * sensor.getHeatCapacity();
+        }
+        simulator_.runAdjoint(probes, particles, t_eq_, transient);
+        reportRescues();
+        storeResults(runId);
+        if (runId + 1 < num_runs_) { reset(true); }
+    }
+}
+
+void Model::runHybrid() {
+    for (std::size_t runId = 0; runId < num_runs_; ++runId) {
+        std::cout << "Run: " << runId + 1 << " (hybrid)\n";
+        const auto [min, max] = setTemperatureBounds();
+        initializeMaterialTables(min, max);
+        std::cout << "Diffusive sensors: " << markDiffusiveSensors() << '\n';
+        DiffusionSolver solver{ cells_, t_eq_ };
+        const auto& interfaces = solver.getInterfaces();
+        std::vector<const Cell*> neighbours;
+        std::ranges::transform(interfaces, std::back_inserter(neighbours), &DiffusionSolver::Interface::diffusive);
+        const auto batches = sensors_.front().getEnergies().size();// One batch per steady-state measurement
+        // The interface temperatures are converged relative to the largest deviation of an emitting surface
+        const auto scale = std::max(std::fabs(min - t_eq_), std::fabs(max - t_eq_));
+
+        // The interfaces emit into the ballistic region like emitting surfaces at the interface temperatures
+        std::vector<double> emit_temps(interfaces.size(), t_eq_);
+        std::vector<EmitSurface> surfaces;
+        auto runBallistic = [&](double phonons) {
+            surfaces.clear();
+            surfaces.reserve(interfaces.size());
+            auto energy = std::transform_reduce(
+                std::cbegin(cells_), std::cend(cells_), 0., std::plus{}, [this](const Cell& cell) {
+                    return cell.isDiffusive() ? 0. : cell.getEmitEnergy(t_eq_);
+                });
+            for (std::size_t index = 0; index < interfaces.size(); ++index) {
+                const auto& [ballistic, diffusive, line] = interfaces[index];
+                const auto& material = ballistic->getMaterial();
+                const auto temp = emit_temps[index];
+                auto& es = surfaces.emplace_back(line, *ballistic, 1., 1, material, temp, simulation_time_, 0.);
+                auto normal = line.normal();
+                const auto [px, py] = line.p1;
+                const auto [cx, cy] = ballistic->getCentroid();
+                if (normal.x * (cx - px) + normal.y * (cy - py) < 0.) { normal = { -normal.x, -normal.y }; }
+                es.setNormal(normal);
+                es.updateTable();
+                energy += line.length * simulation_time_ * material.emitEnergy(temp) / 4. * std::fabs(temp - t_eq_);
+            }
+            simulator_.setInterfaces(surfaces, neighbours);
+            const auto eff_energy = (energy > 0.) ? energy / phonons : 1.;
+            if (energy > 0.) {
+                simulator_.initPhononBuilders(cells_, t_eq_, eff_energy);
+                simulator_.runSimulation(t_eq_);
+            }
+            return std::pair{ simulator_.takeInterfaceTallies(), eff_energy };
+        };
+        // Power absorbed by each interface in the given batch or, with batch = batches, in all of them
+        auto absorbedPower = [&](const std::vector<double>& absorbed, double eff_energy, std::size_t batch) {
+            std::vector<double> power(interfaces.size(), 0.);
+            for (std::size_t index = 0; index < interfaces.size(); ++index) {
+                const auto first = std::cbegin(absorbed) + static_cast<std::ptrdiff_t>(index * batches);
+                power[index] = (batch == batches) ? std::reduce(first, first + static_cast<std::ptrdiff_t>(batches))
+                                                  : *(first + static_cast<std::ptrdiff_t>(batch))
+                                                        * static_cast<double>(batches);
+                power[index] *= eff_energy / simulation_time_;
+            }
+            return power;
+        };
+
+        // The ballistic region starts out as a black body at t_eq
+        auto interface_temps = solver.solve(std::vector<double>(interfaces.size(), 0.), emit_temps, 0.);
+        double returned = 0.;
+        const auto pilot_phonons = std::max(1., PILOT_FRACTION * static_cast<double>(num_phonons_));
+        for (std::size_t iter = 1; !interfaces.empty(); ++iter) {
+            emit_temps = interface_temps;
+            const auto [tallies, eff_energy] = runBallistic(pilot_phonons);
+            returned = tallies.returned;
+            interface_temps = solver.solve(absorbedPower(tallies.absorbed, eff_energy, batches), emit_temps, returned);
+            double change = 0.;
+            for (std::size_t index = 0; index < interfaces.size(); ++index) {
+                change = std::max(change, std::fabs(interface_temps[index] - emit_temps[index]));
+            }
+            std::cout << "Coupling iteration " << iter << ": interface temperatures changed by up to " << change
+                      << " K\n";
+            reset(true);
+            if (change <= COUPLING_TOLERANCE * scale || iter == MAX_COUPLING_ITERS) { break; }
+        }
+
+        emit_temps = interface_temps;
+        const auto [tallies, eff_energy] = runBallistic(static_cast<double>(num_phonons_));
+        // Each batch of the ballistic run gives an independent diffusion solution
+        for (std::size_t batch = 0; batch < batches; ++batch) {
+            std::ignore = solver.solve(absorbedPower(tallies.absorbed, eff_energy, batch), emit_temps, returned);
+            solver.record(batch, eff_energy);
+        }
+        interpreter_.setParams(t_eq_, eff_energy);
+        reportRescues();
+        storeResults(runId);
+        if (runId + 1 < num_runs_) { reset(true); }
+    }
+    simulator_.setInterfaces({}, {});
+}
+
+std::size_t Model::markDiffusiveSensors() {
+    std::unordered_set<std::size_t> diffusive;
+    for (const auto listed : diffusive_sensors_) {
+        const auto ID = keptSensorID(listed);
+        if (!sensor_index_.contains(ID)) {
+            throw std::runtime_error("Diffusive sensor " + std::to_string(ID) + " does not exist.\n");
+        }
+        diffusive.insert(ID);
+    }
+    if (diffusive_knudsen_ > 0.) {
+        // The smallest cell of each sensor has its largest Knudsen number
+        std::unordered_map<std::size_t, double> smallest_areas;
+        for (const auto& cell : cells_) {
+            const auto [area, inserted] = smallest_areas.try_emplace(cell.getSensorID(), cell.getArea());
+            if (!inserted) { area->second = std::min(area->second, cell.getArea()); }
+        }
+        for (const auto& sensor : sensors_) {
+            const auto area = smallest_areas.find(sensor.getID());
+            if (area == std::cend(smallest_areas)) { continue; }
+            const auto mean_free_path = sensor.getMaterial().meanFreePath(sensor.getSteadyTemp());
+            if (mean_free_path / std::sqrt(area->second) < diffusive_knudsen_) { diffusive.insert(sensor.getID()); }
+        }
+    }
+    for (auto& sensor : sensors_) { sensor.setDiffusive(diffusive.contains(sensor.getID())); }
+    return diffusive.size();
 }
 
 double Model::getTotalInitialEnergy() const noexcept {
     return std::transform_reduce(
         std::execution::seq, std::cbegin(cells_), std::cend(cells_), 0., std::plus{}, [&](const auto& cell) {
-            return cell.getInitEnergy(t_eq_) + cell.getEmitEnergy(t_eq_);
+            // Kinetic steady states only depend on the emitted energy
+            return (kinetic_ ? 0. : cell.getInitEnergy(t_eq_)) + cell.getEmitEnergy(t_eq_);
         });
 }
 
@@ -238,12 +1246,24 @@ double Model::avgTemp() const {
         });
 }
 
+void Model::reportRescues() {
+    const auto rescues = simulator_.getRescues();
+    std::cout << "Stuck phonons rescued: " << rescues - reported_rescues_ << '\n';
+    reported_rescues_ = rescues;
+}
+
 void Model::storeResults(std::size_t runId) noexcept {
     std::for_each(std::execution::par, std::cbegin(sensors_), std::cend(sensors_), [&](const auto& sensor) {
+        // Adjoint runs only estimate their own sensors
+        if (!adjoint_sensors_.empty()
+            && std::ranges::find(adjoint_sensors_, sensor.getID()) == std::cend(adjoint_sensors_)) {
+            return;
+        }
         auto measurement = interpreter_.scaleHeatParams(sensor);
         std::scoped_lock lg(*addMeasurementMutex_);// NOLINT
         outputManager_.addMeasurement(runId, std::move(measurement));
     });
+    if (!reflections_.empty()) { addMirroredResults(runId); }
     outputManager_.sortMeasurements(runId);
 }
 
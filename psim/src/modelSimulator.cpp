@@ -6,29 +6,63 @@
 #include "psim/utils.h"
 #include <algorithm>
 #include <execution>
+#include <iostream>
+#include <limits>
+#include <numbers>
 #include <numeric>
+#include <ranges>
+#include <tuple>
 
 using Point = Geometry::Point;
-using Line = Geometry::Line;
 using Polar = Material::Polar;
 
 namespace {
 
-constexpr double SCALING_FACTOR{ 1e9 };// Factor to scale the scattering time (ns per second)
 constexpr std::size_t PHONON_CUTOFF{ 5'000'000 };// Switch from individual phonons to builders at this point
 constexpr std::size_t BUILDER_MAX_PHONONS{ 100'000 };
-// Consider phonon velocity to be 0 in this direction if it is less than this value. Prevents some FP issues
-// Phonon would move at most 5 nm in this direction over a 50ns simulation, so this is safe to do in most cases
-// Should perhaps be scaled based on simulation settings (step_time_ and cell dimensions)
-constexpr double VELOCITY_EPS{ 0.01 };
-// Prevent phonons from endlessly bouncing in tight corners. Consider scaling this based on step_time_?
+// Last resort against phonons endlessly bouncing in tight corners. The exit edge walk in nextImpact should prevent
+// this from ever being reached - each rescue is counted and reported with the results.
 constexpr std::size_t MAX_COLLISIONS{ 100 };
+// Phonons are only split or rouletted when their weight is outside [LOW, HIGH] times the target weight
+constexpr double WEIGHT_WINDOW_LOW{ 0.5 };
+constexpr double WEIGHT_WINDOW_HIGH{ 2. };
+// Emission biases are kept within [1 / MAX_EMISSION_BIAS, MAX_EMISSION_BIAS] so every source is still sampled
+constexpr double MAX_EMISSION_BIAS{ 10. };
+// Prior number of pilot phonons given the average score of all sources - sources with few pilot phonons stay
+// close to the average
+constexpr double PILOT_PRIOR_PHONONS{ 10. };
+// Phonons only annihilate if their directions fall in the same of this many equal angular sectors. Opposite sign
+// phonons moving in opposite directions carry heat flux even though their energies cancel.
+constexpr double ANNIHILATION_SECTORS{ 8. };
+// Number of the material's frequency bins merged into one annihilation bin
+constexpr std::size_t ANNIHILATION_FREQ_BINS{ 50 };
+
+// Temperature of the emitting surface of the cell that absorbed a phonon at point
+double absorbingTemp(const Cell& cell, const Point& point) noexcept {
+    double temp = 0.;
+    double closest = std::numeric_limits<double>::max();
+    for (const auto& boundary : cell.getBoundaries()) {
+        for (const auto& es : boundary.getEmitSurfaces()) {// NOLINT
+            if (es.contains(point)) { return es.getTemp(); }
+            // Guards against round-off at the end points - the nearest surface by its midpoint is taken instead
+            const auto& [p1, p2] = es.getSurfaceLine().getPoints();
+            const auto distance = std::hypot((p1.x + p2.x) / 2. - point.x, (p1.y + p2.y) / 2. - point.y);
+            if (distance < closest) {
+                closest = distance;
+                temp = es.getTemp();
+            }
+        }
+    }
+    return temp;
+}
 
 }// namespace
 
 ModelSimulator::ModelSimulator(std::size_t measurement_steps, double simulation_time, bool phasor_sim)
     : step_time_{ simulation_time / static_cast<double>(measurement_steps) }
-    , phasor_sim_{ phasor_sim } {
+    , phasor_sim_{ phasor_sim }
+    , rescues_{ std::make_unique<std::atomic<std::size_t>>(0) }
+    , interface_returns_{ std::make_unique<std::atomic<std::size_t>>(0) } {
     // Set up timing vector - each entry is the time at which a measurement will take place
     step_times_.resize(measurement_steps);
     std::ranges::generate(step_times_, [&, n = 1]() mutable {// NOLINT
@@ -36,89 +70,185 @@ ModelSimulator::ModelSimulator(std::size_t measurement_steps, double simulation_
     });
 }
 
+ModelSimulator ModelSimulator::ensembleMember(std::size_t tally_offset) const {
+    ModelSimulator member{ step_times_.size(), step_times_.back(), phasor_sim_ };
+    member.source_bias_ = source_bias_;
+    member.importance_sampling_ = importance_sampling_;
+    member.annihilation_ = annihilation_;
+    member.kinetic_ = kinetic_;
+    member.error_batches_ = error_batches_;
+    member.step_adjustment_ = step_adjustment_;
+    member.tally_offset_ = tally_offset;
+    return member;
+}
+
 void ModelSimulator::runSimulation(double t_eq) {
-    (total_phonons_ < PHONON_CUTOFF) ? runPhononByPhonon(t_eq) : runUsingBuilders(t_eq);
+    // Emission pilots score whole phonon histories, so they are never annihilated
+    if (annihilation_ && !pilot_ && !kinetic_) {
+        runSynchronized(t_eq);
+    } else {
+        (total_phonons_ < PHONON_CUTOFF) ? runPhononByPhonon(t_eq) : runUsingBuilders(t_eq);
+    }
 }
 
 void ModelSimulator::initPhononBuilders(std::vector<Cell>& cells, double t_eq, double eff_energy) noexcept {// NOLINT
-    auto getPhonons = [&eff_energy](const double fractional_energy) {
+    // Sources are numbered cells first, then emitting surfaces in slot order. Biased sources build more (or fewer)
+    // phonons than their energy calls for and the phonons are weighted back in simulatePhonon.
+    auto getPhonons = [&](const double fractional_energy, std::size_t source) {
+        source_energy_[source] = fractional_energy;
+        const auto bias = source_bias_.empty() ? 1. : source_bias_[source];
         double temp_phonons = 0;
-        const auto frac_phonons = std::modf(fractional_energy / eff_energy, &temp_phonons);
+        const auto frac_phonons = std::modf(bias * fractional_energy / eff_energy, &temp_phonons);
         auto num_phonons = static_cast<std::size_t>(temp_phonons);// rounds down
         return (Utils::urand() < frac_phonons) ? ++num_phonons : num_phonons;// 'round' up or stay rounded down
     };
-    CellOriginBuilder cb{};// NOLINT
-    for (auto& cell : cells) {
-        const auto& mat = cell.getMaterial();
-        // Add initial phonon builders
-        const auto init_energy = cell.getInitEnergy(t_eq);
-        if (const auto init_phonons = getPhonons(init_energy); init_phonons > 0) {
-            total_phonons_ += init_phonons;
-            // Using max_phonons/2 since init_phonons generally have longer simulation times that emitted phonons
-            if (const auto phonons = cb.totalPhonons();
-                phonons + init_phonons > BUILDER_MAX_PHONONS / 2 && phonons != 0) {
-                phonon_builders_.emplace_back(std::move(cb));
-                cb = CellOriginBuilder{};
-            }
-            cb.addCellPhonons(&cell, init_phonons);
-        }
-        // Add emit surface phonon builders
+    auto cellIndex = [&cells](const Cell& cell) { return static_cast<std::size_t>(&cell - cells.data()); };
+    auto emitEnergy = [&](const EmitSurface& es) {
+        const auto temp = es.getTemp();
+        const auto energy_factor =
+            es.getCell()->getMaterial().emitEnergy(temp) * es.getEmitDuration() * es.getLength() / 4.;
+        return (t_eq == 0.) ? energy_factor : energy_factor * std::fabs(t_eq - temp);
+    };
+    // The emitting surfaces of each cell get a contiguous slot range - the prefix sum of the surface counts
+    std::vector<std::size_t> surface_offsets(cells.size() + 1, 0);
+    std::transform(std::execution::par,
+        std::cbegin(cells),
+        std::cend(cells),
+        std::next(std::begin(surface_offsets)),
+        [](const Cell& cell) {
+            const auto& boundaries = cell.getBoundaries();
+            return std::accumulate(std::cbegin(boundaries),
+                std::cend(boundaries),
+                std::size_t{ 0 },
+                [](std::size_t count, const auto& boundary) { return count + boundary.getEmitSurfaces().size(); });
+        });
+    std::inclusive_scan(
+        std::execution::par, std::cbegin(surface_offsets), std::cend(surface_offsets), std::begin(surface_offsets));
+
+    // Phonon counts of every cell and emitting surface, each rounded stochastically with the thread's generator
+    struct SurfacePhonons {
+        Cell* cell;
+        const EmitSurface* surface;
+        std::size_t phonons;
+    };
+    std::vector<SurfacePhonons> surface_phonons(surface_offsets.back());
+    cell_phonons_.resize(cells.size());
+    source_energy_.resize(cells.size() + surface_phonons.size());
+    std::for_each(std::execution::par, std::begin(cells), std::end(cells), [&](Cell& cell) {
+        const auto index = cellIndex(cell);
+        // The initial deviation of the cells has no bearing on a kinetic steady state
+        cell_phonons_[index] = getPhonons(kinetic_ ? 0. : cell.getInitEnergy(t_eq), index);
+        auto slot = surface_offsets[index];
         for (const auto& boundary : cell.getBoundaries()) {
             for (const auto& es : boundary.getEmitSurfaces()) {// NOLINT
-                const auto temp = es.getTemp();
-                const auto energy_factor = mat.emitEnergy(temp) * es.getEmitDuration() * es.getLength() / 4.;
-                const auto emit_energy = (t_eq == 0.) ? energy_factor : energy_factor * std::fabs(t_eq - temp);
-                auto emit_phonons = getPhonons(emit_energy);
-                total_phonons_ += emit_phonons;
-                while (emit_phonons > BUILDER_MAX_PHONONS) {
-                    (phasor_sim_)
-                        ? phonon_builders_.emplace_back(PhasorBuilder{ cell, es, BUILDER_MAX_PHONONS })
-                        : phonon_builders_.emplace_back(SurfaceOriginBuilder{ cell, es, BUILDER_MAX_PHONONS });
-                    emit_phonons -= BUILDER_MAX_PHONONS;
-                }
-                (phasor_sim_) ? phonon_builders_.emplace_back(PhasorBuilder{ cell, es, emit_phonons })
-                              : phonon_builders_.emplace_back(SurfaceOriginBuilder{ cell, es, emit_phonons });
+                // The surfaces of diffusive cells only set the temperature of the diffusion solution
+                const auto emit_energy = cell.isDiffusive() ? 0. : emitEnergy(es);
+                surface_phonons[slot] = { &cell, &es, getPhonons(emit_energy, cells.size() + slot) };
+                ++slot;
             }
         }
+    });
+    // Interfaces with diffusive cells are sources after the emitting surfaces
+    interface_source_ = source_energy_.size();
+    source_energy_.resize(interface_source_ + interfaces_.size());
+    for (std::size_t index = 0; index < interfaces_.size(); ++index) {
+        const auto& es = interfaces_[index];
+        surface_phonons.push_back({ es.getCell(), &es, getPhonons(emitEnergy(es), interface_source_ + index) });
+        interface_phonons_ += surface_phonons.back().phonons;
+    }
+    const auto init_phonons = std::reduce(std::execution::par, std::cbegin(cell_phonons_), std::cend(cell_phonons_));
+    const auto emit_phonons = std::transform_reduce(std::execution::par,
+        std::cbegin(surface_phonons),
+        std::cend(surface_phonons),
+        std::size_t{ 0 },
+        std::plus<>{},
+        [](const SurfacePhonons& sp) { return sp.phonons; });
+    total_phonons_ += init_phonons + emit_phonons;
+
+    // Cell builders cover contiguous ranges of cells. Using max_phonons/2 since init_phonons generally have longer
+    // simulation times that emitted phonons - the range ends are found on the prefix sum of the cell counts.
+    std::vector<std::size_t> cumulative(cells.size());
+    std::inclusive_scan(
+        std::execution::par, std::cbegin(cell_phonons_), std::cend(cell_phonons_), std::begin(cumulative));
+    std::vector<std::size_t> range_ends;
+    for (std::size_t first = 0; first < cells.size(); first = range_ends.back()) {
+        const auto before = (first == 0) ? 0 : cumulative[first - 1];
+        const auto last = std::upper_bound(std::cbegin(cumulative) + static_cast<std::ptrdiff_t>(first),
+            std::cend(cumulative),
+            before + BUILDER_MAX_PHONONS / 2);
+        const auto end = static_cast<std::size_t>(std::distance(std::cbegin(cumulative), last));
+        range_ends.push_back(std::max(first + 1, end));
+    }
+    const auto surface_builders = std::transform_reduce(std::execution::par,
+        std::cbegin(surface_phonons),
+        std::cend(surface_phonons),
+        std::size_t{ 0 },
+        std::plus<>{},
+        [](const SurfacePhonons& sp) { return (sp.phonons + BUILDER_MAX_PHONONS - 1) / BUILDER_MAX_PHONONS; });
+    phonon_builders_.reserve(phonon_builders_.size() + range_ends.size() + surface_builders);
+
+    const std::span<Cell> all_cells{ cells };
+    const std::span<const std::size_t> all_phonons{ cell_phonons_ };
+    std::size_t first = 0;
+    for (const auto end : range_ends) {
+        if (cumulative[end - 1] > ((first == 0) ? 0 : cumulative[first - 1])) {
+            phonon_builders_.emplace_back(CellOriginBuilder{
+                all_cells.subspan(first, end - first), all_phonons.subspan(first, end - first), first });
+        }
+        first = end;
+    }
+    for (std::size_t slot = 0; slot < surface_phonons.size(); ++slot) {
+        auto [cell, es, phonons] = surface_phonons[slot];
+        const auto source = cells.size() + slot;
+        while (phonons > 0) {
+            const auto built = std::min(phonons, BUILDER_MAX_PHONONS);
+            (phasor_sim_) ? phonon_builders_.emplace_back(PhasorBuilder{ *cell, *es, built, source })
+                          : phonon_builders_.emplace_back(SurfaceOriginBuilder{ *cell, *es, built, source });
+            phonons -= built;
+        }
+    }
+}
+
+void ModelSimulator::setInterfaces(std::span<const EmitSurface> interfaces, std::span<const Cell* const> neighbours) {
+    interfaces_ = interfaces;
+    interface_keys_.clear();
+    for (std::size_t index = 0; index < interfaces.size(); ++index) {
+        interface_keys_.push_back({ { interfaces[index].getCell(), neighbours[index] }, index });
+    }
+    std::ranges::sort(interface_keys_, {}, &InterfaceKey::cells);
+    num_interface_tallies_ = interfaces.size() * (step_times_.size() - step_adjustment_);
+    interface_absorbed_ = std::make_unique<std::atomic<double>[]>(num_interface_tallies_);// NOLINT
+    interface_phonons_ = 0;
+    interface_returns_->store(0);
+}
+
+ModelSimulator::InterfaceTallies ModelSimulator::takeInterfaceTallies() {
+    InterfaceTallies tallies{ std::vector<double>(num_interface_tallies_), 0. };
+    for (std::size_t index = 0; index < num_interface_tallies_; ++index) {
+        tallies.absorbed[index] = interface_absorbed_[index].exchange(0.);
+    }
+    if (interface_phonons_ > 0) {
+        tallies.returned =
+            static_cast<double>(interface_returns_->exchange(0)) / static_cast<double>(interface_phonons_);
     }
-    if (cb.hasPhonons()) { phonon_builders_.emplace_back(std::move(cb)); }
+    interface_phonons_ = 0;
+    return tallies;
 }
 
 std::optional<double> ModelSimulator::nextImpact(Phonon& p, double time) const noexcept {// NOLINT
-    // Get some necessary information
     const auto& [px, py] = p.getPosition();
     const auto& [vx, vy] = p.getVelVector();
     const Point start_point{ px, py };
     const Point end_point{ px + time * vx, py + time * vy };
-    const auto boundaryLines = p.getCellBoundaryLines();
-    if (start_point == end_point) { return std::nullopt; }
-    const Line phonon_path{ start_point, end_point };
-
-    auto getTime = [](double start_coord, double end_coord, double velocity, double max_time) {
-        return (velocity > VELOCITY_EPS || velocity < -VELOCITY_EPS) ? (end_coord - start_coord) / velocity : max_time;
-    };
-
-    // Find the nearest impact time and corresponding impact point
-    std::optional<Point> impact_point = std::nullopt;
-    for (const auto& line : boundaryLines) {
-        // If there is a point of intersection that is not the start point
-        if (const auto poi = line.getIntersection(phonon_path); poi && (*poi != start_point)) {
-            // If the time taken to hit this POI is <= previous shortest time -> store POI and time
-            const auto impact_time_x = getTime(start_point.x, (*poi).x, vx, time);
-            const auto impact_time_y = getTime(start_point.y, (*poi).y, vy, time);
-            const auto impact_time = (impact_time_x <= impact_time_y) ? impact_time_x : impact_time_y;
-            if (impact_time <= time) {
-                time = impact_time;
-                impact_point = poi;
-            }
-        }
-    }
-    if (impact_point) {
-        p.setPosition((*impact_point).x, (*impact_point).y);
-        p.handleSurfaceCollision(*impact_point, step_time_);
-        return std::make_optional(time);
-    }
-    return std::nullopt;
+    // Cells are convex, so the only surface the phonon can impact is the edge it leaves the cell through. The exit
+    // edge is found with exact orientation tests, so a phonon resting on an edge after an impact is never sent back
+    // into that edge (the cause of the zero length impact loops in corners).
+    const auto crossing = p.getCellPolygon().exitCrossing(start_point, end_point);
+    if (!crossing) { return std::nullopt; }
+    const auto& [edge, fraction, poi] = *crossing;
+    p.setPosition(poi.x, poi.y);
+    p.handleSurfaceCollision(edge, poi, step_time_);
+    return std::make_optional(fraction * time);
 }
 
 void ModelSimulator::scatter(Phonon& p, const Phonon::RelaxRates& relax_rates) noexcept {// NOLINT
@@ -137,10 +267,120 @@ void ModelSimulator::scatter(Phonon& p, const Phonon::RelaxRates& relax_rates) n
 }
 
 void ModelSimulator::simulatePhonon(Phonon&& p, std::size_t measurement_steps) const {// NOLINT
+    const double phonon_age = p.getLifetime();
+    // Kinetic phonons are timeless - step 0 keeps every steady-state emitting surface absorbing them
+    Track track{ std::move(p), phonon_age, kinetic_ ? 0 : static_cast<std::size_t>(phonon_age / step_time_) };
+    // Kinetic histories are dealt to the batches in turn, so each batch holds an equal share of every source's
+    // phonons (a random batch would add the spread of the batch sizes to the standard error). A history and its
+    // copies all go to the same batch so the batches stay independent.
+    thread_local std::size_t histories = 0;
+    const auto batch = kinetic_ ? histories++ % (measurement_steps - step_adjustment_) : 0;
+    // Time-stepped histories are dealt to the error batches in the same way
+    const auto set_offset =
+        (error_batches_ > 1) ? histories++ % error_batches_ * (measurement_steps - step_adjustment_) : 0;
+    auto follow = [&](Track& followed, std::vector<Track>& copies) {
+        if (kinetic_) { return traceKinetic(followed, batch, copies); }
+        // Phasor phonons never scatter, so without weight windows there is nothing to do between impacts
+        if (phasor_sim_ && !importance_sampling_) { return tracePhasor(followed, measurement_steps, set_offset); }
+        return trackPhonon(followed, measurement_steps, measurement_steps, copies, set_offset).target_samples;
+    };
+    // Copies split off the phonon wait here until the phonon ends
+    std::vector<Track> branches;
+    if (!launchPhonon(track, branches)) { return; }
+    const auto samples = follow(track, branches);
+    while (!branches.empty()) {
+        auto branch = std::move(branches.back());
+        branches.pop_back();
+        follow(branch, branches);
+    }
+    if (pilot_) {
+        auto& tally = pilot_->tallies[track.phonon.getSource()];
+        tally.phonons.fetch_add(1, std::memory_order_relaxed);
+        tally.score_sq.fetch_add(static_cast<double>(samples * samples), std::memory_order_relaxed);
+    }
+}
+
+void ModelSimulator::runEmissionPilot(double t_eq, std::vector<std::size_t> target_sensors) {
+    source_bias_.clear();
+    std::ranges::sort(target_sensors);
+    pilot_ = std::make_unique<EmissionPilot>(std::move(target_sensors), source_energy_.size());
+    runSimulation(t_eq);
+    const auto pilot = std::move(pilot_);// Scoring stops here
+    const auto& tallies = pilot->tallies;
+
+    // A source scores the square of the number of target samples its phonons record. The variance of the target
+    // results is lowest when each source builds phonons in proportion to its energy times the root mean score.
+    const auto [phonons, score_sq] = std::transform_reduce(std::cbegin(tallies),
+        std::cend(tallies),
+        std::pair{ 0., 0. },
+        [](const auto& lhs, const auto& rhs) { return std::pair{ lhs.first + rhs.first, lhs.second + rhs.second }; },
+        [](const SourceTally& tally) {
+            return std::pair{ static_cast<double>(tally.phonons.load()), tally.score_sq.load() };
+        });
+    if (score_sq == 0.) {
+        std::cout << "No pilot phonons reached the target sensors - emission is not biased\n";
+        return;
+    }
+    const auto mean_score_sq = score_sq / phonons;
+    std::vector<double> bias(tallies.size());
+    std::ranges::transform(tallies, std::begin(bias), [mean_score_sq](const SourceTally& tally) {
+        return std::sqrt((tally.score_sq.load() + PILOT_PRIOR_PHONONS * mean_score_sq)
+                         / (static_cast<double>(tally.phonons.load()) + PILOT_PRIOR_PHONONS));
+    });
+    // Normalize to the energy weighted mean so the total number of phonons is unchanged
+    const auto total_energy = std::reduce(std::cbegin(source_energy_), std::cend(source_energy_));
+    const auto mean_bias =
+        std::transform_reduce(std::cbegin(source_energy_), std::cend(source_energy_), std::cbegin(bias), 0.)
+        / total_energy;
+    for (auto& b : bias) { b = std::clamp(b / mean_bias, 1. / MAX_EMISSION_BIAS, MAX_EMISSION_BIAS); }
+    const auto clamped_mean =
+        std::transform_reduce(std::cbegin(source_energy_), std::cend(source_energy_), std::cbegin(bias), 0.)
+        / total_energy;
+    for (auto& b : bias) { b /= clamped_mean; }
+    auto emitting = std::views::iota(std::size_t{ 0 }, bias.size())
+                    | std::views::filter([this](std::size_t source) { return source_energy_[source] > 0.; })
+                    | std::views::transform([&bias](std::size_t source) { return bias[source]; });
+    const auto [least, most] = std::ranges::minmax(emitting);
+    std::cout << "Emission biases between " << least << " and " << most << '\n';
+    source_bias_ = std::move(bias);
+}
+
+bool ModelSimulator::launchPhonon(Track& track, std::vector<Track>& branches) const {
+    auto& p = track.phonon;
+    p.setLifeStep(track.step);// For transient simulations
+    if (!source_bias_.empty()) { p.setWeight(p.getWeight() / source_bias_[p.getSource()]); }
+    // Phonons are built with a weight of +-1, so they are first brought into the weight window of their sensor
+    return !importance_sampling_ || applyWeightWindow(p, track.age, track.step, branches);
+}
+
+bool ModelSimulator::applyWeightWindow(Phonon& p, double age, std::size_t step, std::vector<Track>& branches) {
+    const auto target = 1. / p.getCellImportance();
+    const auto weight = std::abs(p.getWeight());
+    if (weight < target * WEIGHT_WINDOW_LOW) {
+        if (Utils::urand() * target >= weight) { return false; }
+        p.setWeight(std::copysign(target, p.getWeight()));
+    } else if (weight > target * WEIGHT_WINDOW_HIGH) {
+        double copies = 0.;
+        if (Utils::urand() < std::modf(weight / target, &copies)) { copies += 1.; }
+        p.setWeight(p.getWeight() / copies);
+        for (std::size_t copy = 1; copy < static_cast<std::size_t>(copies); ++copy) {
+            branches.push_back({ p, age, step });
+        }
+    }
+    return true;
+}
+
+ModelSimulator::TrackResult ModelSimulator::trackPhonon(Track& track,// NOLINT
+    std::size_t measurement_steps,
+    std::size_t pause_step,
+    std::vector<Track>& branches,
+    std::size_t set_offset) const {
+    auto& p = track.phonon;
+    auto& phonon_age = track.age;
+    auto& step = track.step;
     bool phonon_alive = true;
-    double phonon_age = p.getLifetime();
-    auto step = static_cast<std::size_t>(phonon_age / step_time_);
-    p.setLifeStep(step);// For transient simulations
+    bool pause = false;
+    std::size_t target_samples = 0;
     Phonon::RelaxRates relax_rates{};
     double time_to_scatter = 0.;
     double time_to_measurement = 0.;
@@ -182,7 +422,11 @@ void ModelSimulator::simulatePhonon(Phonon&& p, std::size_t measurement_steps) c
             if (time_to_measurement == 0.) {// Take a measurement
                 if (++step < measurement_steps) {// Simulation time has not been exceeded
                     p.setLifeStep(step);
-                    if (step >= step_adjustment_) { p.updateCellHeatParams(step - step_adjustment_); }
+                    if (step >= step_adjustment_) {
+                        p.updateCellHeatParams(step - step_adjustment_ + tally_offset_ + set_offset);
+                        if (pilot_ && pilot_->isTarget(p.getCellSensorID())) { ++target_samples; }
+                    }
+                    pause = (step == pause_step);
                 } else {// Exceeds simulation time
                     phonon_alive = false;
                 }
@@ -194,6 +438,222 @@ void ModelSimulator::simulatePhonon(Phonon&& p, std::size_t measurement_steps) c
         } else {// Phonon made impact with an emitting surface (left system)
             phonon_alive = false;
         }
+        if (importance_sampling_ && phonon_alive && p.getCellSensorID() != sensor_id) {
+            phonon_alive = applyWeightWindow(p, phonon_age, step, branches);
+        }
+        if (pause && phonon_alive) { return { true, target_samples }; }
+    }
+    return { false, target_samples };
+}
+
+std::size_t ModelSimulator::traceKinetic(Track& track, std::size_t batch, std::vector<Track>& branches) const {
+    auto& p = track.phonon;
+    // Each phonon stands for the energy its source emits over the simulation time divided among its phonons, so a
+    // flight counts for its duration over the simulation time. Only one batch in batches holds the phonon.
+    const auto occupancy_rate = static_cast<double>(step_times_.size() - step_adjustment_) / step_times_.back();
+    std::size_t target_samples = 0;
+    std::size_t collisions = 0;
+
+    auto get_scatter_info = [](const Phonon& phonon) {// NOLINT
+        const auto relaxation_rates = phonon.getRelaxRates(0);
+        return std::make_pair(relaxation_rates,
+            SCALING_FACTOR * -log(Utils::urand())
+                / std::accumulate(std::cbegin(relaxation_rates), std::cend(relaxation_rates), 0.));
+    };
+    auto [relax_rates, time_to_scatter] = get_scatter_info(p);
+
+    while (true) {
+        const auto sensor_id = p.getCellSensorID();
+        // Impacts change the direction and cell of the phonon - the flight is recorded as it started
+        const Phonon flight = p;
+        const auto impact_time = nextImpact(p, time_to_scatter);
+        const auto flight_time = impact_time.value_or(time_to_scatter);
+        if (flight_time > 0.) {
+            flight.updateCellHeatParams(batch + tally_offset_, flight_time * occupancy_rate);
+            if (pilot_ && pilot_->isTarget(sensor_id)) { ++target_samples; }
+        }
+        if (!impact_time) {// Scatter at the end of the flight
+            p.drift(time_to_scatter);
+            scatter(p, relax_rates);
+            std::tie(relax_rates, time_to_scatter) = get_scatter_info(p);
+            collisions = 0;
+            continue;
+        }
+        if (p.outsideCell()) { return target_samples; }// Absorbed by an emitting surface
+        if (p.getCell()->isDiffusive()) {
+            absorbAtInterface(flight.getCell(), p, batch);
+            return target_samples;
+        }
+        time_to_scatter -= *impact_time;
+        collisions = (flight_time > 0.) ? 0 : collisions + 1;
+        if (collisions > MAX_COLLISIONS) {
+            rescues_->fetch_add(1, std::memory_order_relaxed);
+            p.setRandPoint(Utils::urand(), Utils::urand());
+            time_to_scatter = 0.;
+        }
+        if (p.getCellSensorID() != sensor_id) {// The scattering rates depend on the sensor
+            std::tie(relax_rates, time_to_scatter) = get_scatter_info(p);
+            if (importance_sampling_ && !applyWeightWindow(p, track.age, track.step, branches)) {
+                return target_samples;
+            }
+        }
+    }
+}
+
+std::size_t ModelSimulator::tracePhasor(Track& track, std::size_t measurement_steps, std::size_t set_offset) const {
+    auto& p = track.phonon;
+    auto& step = track.step;
+    std::size_t target_samples = 0;
+    std::size_t collisions = 0;
+    if (measurement_steps < 2) { return target_samples; }// Only the measurement at the end, which records nothing
+    // The measurement at step_times_[s] records step s + 1 - the last one recorded is measurement_steps - 1
+    const auto last_time = step_times_[measurement_steps - 2];
+    const auto first_time = std::cbegin(step_times_);
+    const auto end_time = first_time + static_cast<std::ptrdiff_t>(measurement_steps - 1);
+    while (step + 1 < measurement_steps) {
+        const auto remaining = std::max(last_time - track.age, 0.);
+        const auto& [px, py] = p.getPosition();
+        const auto& [vx, vy] = p.getVelVector();
+        const auto crossing = p.getCellPolygon().exitCrossing({ px, py }, { px + remaining * vx, py + remaining * vy });
+        const auto flight_end = crossing ? track.age + crossing->fraction * remaining : last_time;
+        // Every measurement during the flight finds the phonon in the cell it started in
+        const auto first_step = std::max(step + 1, step_adjustment_);
+        step = static_cast<std::size_t>(
+            std::upper_bound(first_time + static_cast<std::ptrdiff_t>(step), end_time, flight_end) - first_time);
+        if (first_step <= step) {
+            const auto offset = tally_offset_ + set_offset;
+            p.updateCellHeatSteps(first_step - step_adjustment_ + offset, step + 1 - step_adjustment_ + offset);
+            if (pilot_ && pilot_->isTarget(p.getCellSensorID())) { target_samples += step + 1 - first_step; }
+        }
+        if (!crossing) { break; }
+        const auto& [edge, fraction, poi] = *crossing;
+        track.age = flight_end;
+        collisions = (fraction > 0.) ? 0 : collisions + 1;
+        p.setPosition(poi.x, poi.y);
+        p.setLifeStep(step);// Emitting surfaces absorb the phonon depending on the time of the impact
+        p.handleSurfaceCollision(edge, poi, step_time_);
+        if (p.outsideCell()) { break; }// Absorbed by an emitting surface
+        if (collisions > MAX_COLLISIONS) {
+            rescues_->fetch_add(1, std::memory_order_relaxed);
+            p.setRandPoint(Utils::urand(), Utils::urand());
+            collisions = 0;
+        }
+    }
+    return target_samples;
+}
+
+void ModelSimulator::absorbAtInterface(const Cell* from, const Phonon& p, std::size_t batch) const {
+    const auto key = std::pair<const Cell*, const Cell*>{ from, p.getCell() };
+    const auto found = std::ranges::lower_bound(interface_keys_, key, {}, &InterfaceKey::cells);
+    if (found == std::cend(interface_keys_) || found->cells != key) { return; }// Cannot happen with valid interfaces
+    const auto batches = step_times_.size() - step_adjustment_;
+    interface_absorbed_[found->interface * batches + batch].fetch_add(p.getWeight(), std::memory_order_relaxed);
+    if (p.getSource() >= interface_source_) { interface_returns_->fetch_add(1, std::memory_order_relaxed); }
+}
+
+void ModelSimulator::runAdjoint(const std::vector<AdjointProbe>& probes,
+    std::size_t particles,
+    double t_eq,
+    bool transient) const {
+    const auto slots = step_times_.size() - step_adjustment_;
+    // Particles start in each cell in proportion to its area
+    std::vector<std::vector<double>> cumulative_areas(probes.size());
+    for (std::size_t probe = 0; probe < probes.size(); ++probe) {
+        const auto& cells = probes[probe].cells;
+        cumulative_areas[probe].resize(cells.size());
+        std::transform_inclusive_scan(std::cbegin(cells),
+            std::cend(cells),
+            std::begin(cumulative_areas[probe]),
+            std::plus{},
+            [](const Cell* cell) { return cell->getArea(); });
+    }
+    std::vector<std::size_t> histories(probes.size() * particles);
+    std::iota(std::begin(histories), std::end(histories), std::size_t{ 0 });
+    std::for_each(std::execution::par, std::cbegin(histories), std::cend(histories), [&](std::size_t history) {
+        const auto& [cells, energy_per_kelvin] = probes[history / particles];
+        const auto& areas = cumulative_areas[history / particles];
+        const auto picked = std::ranges::upper_bound(areas, Utils::urand() * areas.back());
+        Cell* cell = cells[std::min(static_cast<std::size_t>(std::distance(std::cbegin(areas), picked)),
+            cells.size() - 1)];
+        Phonon p{ 1, 0., cell };
+        cell->initialUpdate(p);
+        const auto [px, py] = cell->getRandPoint(Utils::urand(), Utils::urand());
+        p.setPosition(px, py);
+        p.setRandDirection();
+        // The start state carries the flux - the forward phonon moves against the backward particle
+        Phonon start = p;
+        const auto [dx, dy] = start.getDirection();
+        start.setDirection(-dx, -dy);
+        std::vector<double> scores(transient ? slots : 1, 0.);
+        traceAdjoint(p, t_eq, scores);
+        if (transient) {
+            const auto occupancy = energy_per_kelvin / static_cast<double>(particles);
+            for (std::size_t slot = 0; slot < slots; ++slot) {
+                Phonon scored = start;
+                scored.setWeight(scores[slot]);
+                scored.updateCellHeatParams(slot, occupancy);
+            }
+        } else {// Particles are dealt to the batches in turn like kinetic histories
+            const auto index = history % particles;
+            const auto batch = index % slots;
+            const auto batch_particles = particles / slots + ((batch < particles % slots) ? 1 : 0);
+            Phonon scored = start;
+            scored.setWeight(scores.front());
+            scored.updateCellHeatParams(batch, energy_per_kelvin / static_cast<double>(batch_particles));
+        }
+    });
+}
+
+void ModelSimulator::traceAdjoint(Phonon& p, double t_eq, std::span<double> scores) const {
+    const bool timed = scores.size() > 1;
+    std::size_t slot = 0;
+    if (timed) { scores[slot++] = p.getCell()->getInitTemp() - t_eq; }// The first slot is the initial condition
+    std::size_t collisions = 0;
+    double time_to_measurement = timed ? step_times_.front() : std::numeric_limits<double>::infinity();
+
+    auto get_scatter_info = [](const Phonon& phonon) {// NOLINT
+        const auto relaxation_rates = phonon.getRelaxRates(0);
+        return std::make_pair(relaxation_rates,
+            SCALING_FACTOR * -log(Utils::urand())
+                / std::accumulate(std::cbegin(relaxation_rates), std::cend(relaxation_rates), 0.));
+    };
+    auto [relax_rates, time_to_scatter] = get_scatter_info(p);
+
+    while (true) {
+        const auto drift_time = std::min(time_to_scatter, time_to_measurement);
+        const auto* cell = p.getCell();
+        const auto sensor_id = p.getCellSensorID();
+        const auto impact_time = nextImpact(p, drift_time);
+        if (impact_time && p.outsideCell()) {// Every later measurement sees the absorbing surface
+            const auto [px, py] = p.getPosition();
+            std::fill(std::begin(scores) + static_cast<std::ptrdiff_t>(slot),
+                std::end(scores),
+                absorbingTemp(*cell, { px, py }) - t_eq);
+            return;
+        }
+        const auto flight_time = impact_time.value_or(drift_time);
+        time_to_scatter -= flight_time;
+        time_to_measurement -= flight_time;
+        if (!impact_time) {
+            p.drift(drift_time);
+            if (time_to_measurement == 0.) {
+                scores[slot] = p.getCell()->getInitTemp() - t_eq;
+                if (++slot == scores.size()) { return; }
+                time_to_measurement = step_times_[slot - 1] - step_times_[slot - 2];
+            } else {
+                scatter(p, relax_rates);
+                std::tie(relax_rates, time_to_scatter) = get_scatter_info(p);
+            }
+            collisions = 0;
+            continue;
+        }
+        collisions = (flight_time > 0.) ? 0 : collisions + 1;
+        if (collisions > MAX_COLLISIONS) {
+            rescues_->fetch_add(1, std::memory_order_relaxed);
+            p.setRandPoint(Utils::urand(), Utils::urand());
+            time_to_scatter = 0.;
+        }
+        if (p.getCellSensorID() != sensor_id) { std::tie(relax_rates, time_to_scatter) = get_scatter_info(p); }
     }
 }
 
@@ -213,6 +673,7 @@ std::optional<double>
         drifted_time += *impact_time;
         // If phonon is stuck, move it to a random location in the cell - primarily used to handle FP issues
         if (++collision_counter > MAX_COLLISIONS) {
+            rescues_->fetch_add(1, std::memory_order_relaxed);
             p.setRandPoint(Utils::urand(), Utils::urand());
             return std::make_optional<double>(drift_time);// calling function will not further drift the phonon
         }
@@ -252,3 +713,85 @@ void ModelSimulator::runUsingBuilders(double t_eq) {
                 builderObj);
         });
 }
+
+void ModelSimulator::runSynchronized(double t_eq) {
+    const auto measurement_steps = step_times_.size();
+    // Phonons wait in the bucket of the step they are born in
+    std::vector<std::vector<Track>> born(measurement_steps);
+    for (BuilderObj& builderObj : phonon_builders_) {
+        std::visit(
+            [&](auto& builder) {
+                while (builder.hasPhonons()) {
+                    auto p = builder(t_eq);
+                    const auto age = p.getLifetime();
+                    const auto step = static_cast<std::size_t>(age / step_time_);
+                    if (step < measurement_steps) { born[step].push_back({ std::move(p), age, step }); }
+                }
+            },
+            builderObj);
+    }
+    std::vector<Track> live;
+    for (std::size_t step = 0; step < measurement_steps; ++step) {
+        std::vector<Track> branches;
+        for (auto& track : born[step]) {
+            if (launchPhonon(track, branches)) { live.push_back(std::move(track)); }
+        }
+        std::vector<Track>().swap(born[step]);
+        std::ranges::move(branches, std::back_inserter(live));
+        // Copies split off each phonon during the step are tracked to the end of the step with it
+        std::vector<std::vector<Track>> splits(importance_sampling_ ? live.size() : 0);
+        std::for_each(std::execution::par, std::begin(live), std::end(live), [&](Track& track) {
+            std::vector<Track> pending;
+            if (!trackPhonon(track, measurement_steps, step + 1, pending).alive) { track.phonon.setCell(nullptr); }
+            while (!pending.empty()) {
+                auto branch = std::move(pending.back());
+                pending.pop_back();
+                if (trackPhonon(branch, measurement_steps, step + 1, pending).alive) {
+                    splits[static_cast<std::size_t>(&track - live.data())].push_back(std::move(branch));
+                }
+            }
+        });
+        std::erase_if(live, [](const Track& track) { return track.phonon.outsideCell(); });
+        for (auto& kept : splits) { std::ranges::move(kept, std::back_inserter(live)); }
+        annihilate(live);
+    }
+}
+
+void ModelSimulator::annihilate(std::vector<Track>& phonons) {
+    auto key = [](const Track& track) {
+        const auto& p = track.phonon;
+        const auto [dx, dy] = p.getDirection();
+        const auto sector =
+            std::floor((std::atan2(dy, dx) + std::numbers::pi) * ANNIHILATION_SECTORS / (2. * std::numbers::pi));
+        return std::tuple{ p.getCell(), p.getPolar(), p.getFreqIndex() / ANNIHILATION_FREQ_BINS, sector };
+    };
+    std::sort(std::execution::par,
+        std::begin(phonons),
+        std::end(phonons),
+        [&key](const Track& lhs, const Track& rhs) { return key(lhs) < key(rhs); });
+    for (auto first = std::begin(phonons); first != std::end(phonons);) {
+        const auto group = key(*first);
+        const auto last =
+            std::find_if(first, std::end(phonons), [&](const Track& track) { return key(track) != group; });
+        double positive = 0.;
+        double negative = 0.;
+        for (auto track = first; track != last; ++track) {
+            const auto weight = track->phonon.getWeight();
+            if (weight > 0.) {
+                positive += weight;
+            } else {
+                negative -= weight;
+            }
+        }
+        if (positive > 0. && negative > 0.) {
+            const auto majority_sign = (positive > negative) ? 1. : -1.;
+            const auto survival = std::fabs(positive - negative) / std::max(positive, negative);
+            for (auto track = first; track != last; ++track) {
+                auto& p = track->phonon;
+                if (p.getWeight() * majority_sign < 0. || Utils::urand() >= survival) { p.setCell(nullptr); }
+            }
+        }
+        first = last;
+    }
+    std::erase_if(phonons, [](const Track& track) { return track.phonon.outsideCell(); });
+}
@@ -0,0 +1,408 @@
+#include "psim/modelSnapshot.h"
+#include "psim/model.h"
+#include "psim/utils.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using Point = Geometry::Point;
+using Line = Geometry::Line;
+
+namespace {
+
+constexpr std::array<char, 8> MAGIC{ 'P', 'S', 'I', 'M', 'S', 'N', 'A', 'P' };
+// Increment whenever the layout of the records below changes
+constexpr std::uint32_t VERSION{ 15 };
+
+struct Header {
+    std::array<char, 8> magic;
+    std::uint32_t version;
+    std::uint32_t sim_type;
+    std::uint64_t num_runs;
+    std::uint64_t measurement_steps;
+    std::uint64_t num_phonons;
+    std::uint64_t step_interval;
+    double simulation_time;
+    double t_eq;
+    std::uint64_t phasor_sim;
+    std::uint64_t importance_sampling;
+    std::uint64_t emission_bias;
+    std::uint64_t annihilation;
+    std::uint64_t kinetic;
+    std::uint64_t num_materials;
+    std::uint64_t num_sensors;
+    std::uint64_t num_cells;
+    std::uint64_t num_links;
+    std::uint64_t num_emit_surfaces;
+    std::uint64_t num_periodic_surfaces;
+    std::uint64_t num_reflections;
+    std::uint64_t num_target_sensors;// Target sensor IDs follow the reflections
+    std::uint64_t num_adjoint_sensors;// Adjoint sensor IDs follow the target sensor IDs
+    std::uint64_t num_diffusive_sensors;// Diffusive sensor IDs follow the adjoint sensor IDs
+    double diffusive_knudsen;
+    std::uint64_t ensemble;
+    double target_temp_error;
+    double target_flux_error;
+    double time_budget;
+    std::uint64_t error_batches;
+};
+
+// One side of a periodic surface pair - both sides are stored as a cell may be paired with itself
+struct PeriodicRecord {
+    std::uint64_t cell;
+    std::uint64_t other;
+    std::array<Point, 2> points;
+    Geometry::Vector2D offset;
+};
+
+// Each material record is preceded by the length of the material name and the name itself
+struct MaterialRecord {
+    std::uint64_t id;
+    std::uint64_t full_simulation;
+    std::uint64_t gray;
+    DispersionData d_data;
+    RelaxationData r_data;
+};
+
+struct SensorRecord {
+    std::uint64_t id;
+    std::uint64_t material;// Position of the material in the snapshot
+    double t_init;
+};
+
+// Each cell record is preceded by the number of vertices of the cell and the vertex records
+struct VertexRecord {
+    Point point;
+    double specularity;// Of the edge starting at this vertex - mirror edges differ from the rest of the cell
+};
+
+struct CellRecord {
+    std::uint64_t sensor_id;
+};
+
+// A transition surface pair between two cells - stored once per pair
+struct LinkRecord {
+    std::uint64_t cell;
+    std::uint64_t other;
+    std::array<Point, 2> points;
+};
+
+// A symmetry removed from the model - followed by num_sensors (removed sensor ID, mirror image sensor ID) pairs and
+// num_symmetric IDs of sensors that are their own mirror image
+struct ReflectionRecord {
+    std::array<Point, 2> axis;
+    std::uint64_t num_sensors;
+    std::uint64_t num_symmetric;
+};
+
+struct EmitRecord {
+    std::uint64_t cell;
+    std::array<Point, 2> points;
+    double temp;
+    double duration;
+    double start_time;
+};
+
+template<typename T> void write(std::ofstream& out, const T& record) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.write(reinterpret_cast<const char*>(&record), sizeof(T));// NOLINT
+}
+
+// Read-only view of a snapshot file. On POSIX systems the file is memory mapped, elsewhere it is read into memory.
+class MappedFile {
+public:
+    explicit MappedFile(const fs::path& filepath) {
+#ifdef _WIN32
+        std::ifstream in{ filepath, std::ios::binary };
+        if (!in.is_open()) { throw std::runtime_error("Unable to open snapshot " + filepath.string() + '\n'); }
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+#else
+        const int fd = ::open(filepath.c_str(), O_RDONLY);// NOLINT
+        if (fd < 0) { throw std::runtime_error("Unable to open snapshot " + filepath.string() + '\n'); }
+        struct stat info {};
+        if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+            size_ = static_cast<std::size_t>(info.st_size);
+            void* mapped = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) { data_ = static_cast<const char*>(mapped); }// NOLINT
+        }
+        ::close(fd);
+        if (data_ == nullptr) { throw std::runtime_error("Unable to map snapshot " + filepath.string() + '\n'); }
+#endif
+    }
+    ~MappedFile() {
+#ifndef _WIN32
+        if (data_ != nullptr) { ::munmap(const_cast<char*>(data_), size_); }// NOLINT
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&&) = delete;
+
+    template<typename T> T read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T record;
+        std::memcpy(&record, take(sizeof(T)), sizeof(T));
+        return record;
+    }
+    std::string readString(std::size_t length) {
+        return { take(length), length };
+    }
+    [[nodiscard]] std::size_t remaining() const noexcept {
+        return size_ - offset_;
+    }
+
+private:
+    const char* data_{ nullptr };
+    std::size_t size_{ 0 };
+    std::size_t offset_{ 0 };
+#ifdef _WIN32
+    std::vector<char> buffer_;
+#endif
+
+    const char* take(std::size_t bytes) {
+        if (size_ - offset_ < bytes) { throw std::runtime_error(std::string("Snapshot is truncated.\n")); }
+        const char* start = data_ + offset_;// NOLINT
+        offset_ += bytes;
+        return start;
+    }
+};
+
+}// namespace
+
+void ModelSnapshot::save(const Model& model, const fs::path& filepath) {
+    const auto& cells = model.cells_;
+    auto cellIndex = [&cells](const Cell* cell) { return static_cast<std::uint64_t>(cell - cells.data()); };
+
+    std::vector<LinkRecord> links;
+    std::vector<EmitRecord> emits;
+    std::vector<PeriodicRecord> periodics;
+    for (std::size_t index = 0; index < cells.size(); ++index) {
+        for (const auto& boundary : cells[index].getBoundaries()) {
+            for (const auto& ts : boundary.getTransitionSurfaces()) {// NOLINT
+                // Both cells hold a transition surface to each other but linking one recreates both
+                if (const auto other = cellIndex(ts.getCell()); other > index) {
+                    const auto& line = ts.getSurfaceLine();
+                    links.push_back({ index, other, { line.p1, line.p2 } });
+                }
+            }
+            for (const auto& es : boundary.getEmitSurfaces()) {// NOLINT
+                const auto& line = es.getSurfaceLine();
+                emits.push_back(
+                    { index, { line.p1, line.p2 }, es.getTemp(), es.getEmitDuration(), es.getStartTime() });
+            }
+            for (const auto& ps : boundary.getPeriodicSurfaces()) {// NOLINT
+                const auto& line = ps.getSurfaceLine();
+                periodics.push_back({ index, cellIndex(ps.getCell()), { line.p1, line.p2 }, ps.getOffset() });
+            }
+        }
+    }
+
+    std::vector<std::pair<const std::string*, const Material*>> materials;
+    for (const auto& [name, material] : model.materials_) { materials.emplace_back(&name, &material); }
+    std::ranges::sort(materials, [](const auto& lhs, const auto& rhs) { return lhs.second->id() < rhs.second->id(); });
+
+    std::ofstream out{ filepath, std::ios::binary | std::ios::trunc };
+    if (!out.is_open()) { throw std::runtime_error("Unable to write snapshot " + filepath.string() + '\n'); }
+    write(out,
+        Header{ MAGIC,
+            VERSION,
+            static_cast<std::uint32_t>(Utils::toInteger(model.sim_type_)),
+            model.num_runs_,
+            model.measurement_steps_,
+            model.num_phonons_,
+            model.step_interval_,
+            model.simulation_time_,
+            model.t_eq_,
+            static_cast<std::uint64_t>(model.phasor_sim_),
+            static_cast<std::uint64_t>(model.importance_sampling_),
+            static_cast<std::uint64_t>(model.emission_bias_),
+            static_cast<std::uint64_t>(model.annihilation_),
+            static_cast<std::uint64_t>(model.kinetic_),
+            materials.size(),
+            model.sensors_.size(),
+            cells.size(),
+            links.size(),
+            emits.size(),
+            periodics.size(),
+            model.reflections_.size(),
+            model.target_sensors_.size(),
+            model.adjoint_sensors_.size(),
+            model.diffusive_sensors_.size(),
+            model.diffusive_knudsen_,
+            static_cast<std::uint64_t>(model.ensemble_),
+            model.target_temp_error_,
+            model.target_flux_error_,
+            model.time_budget_,
+            model.error_batches_ });
+    for (const auto& [name, material] : materials) {
+        write(out, std::uint64_t{ name->size() });
+        out.write(name->data(), static_cast<std::streamsize>(name->size()));
+        write(out,
+            MaterialRecord{ material->id(),
+                static_cast<std::uint64_t>(material->isFullSimulation()),
+                static_cast<std::uint64_t>(material->isGray()),
+                material->dispersionData(),
+                material->relaxationData() });
+    }
+    for (const auto& sensor : model.sensors_) {
+        const auto material = std::ranges::find_if(
+            materials, [&sensor](const auto& entry) { return entry.second == &sensor.getMaterial(); });
+        write(out,
+            SensorRecord{ sensor.getID(),
+                static_cast<std::uint64_t>(std::distance(std::begin(materials), material)),
+                sensor.getStartTemp() });
+    }
+    for (const auto& cell : cells) {
+        const auto& points = cell.getPolygon().points;
+        write(out, std::uint64_t{ points.size() });
+        for (std::size_t i = 0; i < points.size(); ++i) {
+            write(out, VertexRecord{ points[i], cell.getBoundaries()[i].getSpecularity() });
+        }
+        write(out, CellRecord{ cell.getSensorID() });
+    }
+    for (const auto& link : links) { write(out, link); }
+    for (const auto& emit : emits) { write(out, emit); }
+    for (const auto& periodic : periodics) { write(out, periodic); }
+    for (const auto& [axis, sensors, symmetric] : model.reflections_) {
+        write(out, ReflectionRecord{ { axis.p1, axis.p2 }, sensors.size(), symmetric.size() });
+        for (const auto& [removed_id, image_id] : sensors) {
+            write(out, std::array<std::uint64_t, 2>{ removed_id, image_id });
+        }
+        for (const auto ID : symmetric) { write(out, std::uint64_t{ ID }); }
+    }
+    for (const auto ID : model.target_sensors_) { write(out, std::uint64_t{ ID }); }
+    for (const auto ID : model.adjoint_sensors_) { write(out, std::uint64_t{ ID }); }
+    for (const auto ID : model.diffusive_sensors_) { write(out, std::uint64_t{ ID }); }
+    if (!out) { throw std::runtime_error("Error writing snapshot " + filepath.string() + '\n'); }
+}
+
+std::optional<Model> ModelSnapshot::load(const fs::path& filepath) {
+    try {
+        MappedFile file{ filepath };
+        const auto header = file.read<Header>();
+        if (header.magic != MAGIC || header.version != VERSION) {
+            throw std::runtime_error("File at " + filepath.string() + " is not a compatible snapshot.\n");
+        }
+        // Every cell and sensor takes at least its minimum record size, so larger counts cannot be read
+        constexpr auto min_cell_bytes = sizeof(std::uint64_t) + 3 * sizeof(VertexRecord) + sizeof(CellRecord);
+        if (header.num_cells > file.remaining() / min_cell_bytes
+            || header.num_sensors > file.remaining() / sizeof(SensorRecord)) {
+            throw std::runtime_error(std::string("Snapshot is truncated.\n"));
+        }
+        const auto type = static_cast<SimulationType>(header.sim_type);
+        Model model{ ModelParams{ header.num_runs,
+            header.num_cells,
+            header.num_sensors,
+            header.measurement_steps,
+            header.num_phonons,
+            header.simulation_time,
+            header.t_eq,
+            header.phasor_sim != 0,
+            header.importance_sampling != 0,
+            header.emission_bias != 0,
+            {},
+            header.annihilation != 0,
+            header.kinetic != 0 } };
+        model.setSimulationType(type, header.step_interval);
+
+        std::vector<std::string> material_names;
+        for (std::uint64_t i = 0; i < header.num_materials; ++i) {
+            material_names.push_back(file.readString(file.read<std::uint64_t>()));
+            const auto record = file.read<MaterialRecord>();
+            auto material = Material(record.id, record.d_data, record.r_data);
+            if (record.full_simulation != 0) { material.setFullSimulation(); }
+            if (record.gray != 0) { material.setGray(); }
+            model.addMaterial(material_names.back(), material);
+        }
+        for (std::uint64_t i = 0; i < header.num_sensors; ++i) {
+            const auto record = file.read<SensorRecord>();
+            model.addSensor(record.id, material_names.at(record.material), record.t_init, type);
+        }
+        // The cells were validated when the snapshot was created
+        for (std::uint64_t i = 0; i < header.num_cells; ++i) {
+            const auto num_vertices = file.read<std::uint64_t>();
+            // Checked before allocating so a corrupt count cannot request an arbitrarily large vector
+            if (num_vertices < 3) {
+                throw std::runtime_error("File at " + filepath.string() + " is not a compatible snapshot.\n");
+            }
+            if (num_vertices > file.remaining() / sizeof(VertexRecord)) {
+                throw std::runtime_error(std::string("Snapshot is truncated.\n"));
+            }
+            std::vector<VertexRecord> vertices(num_vertices);
+            std::ranges::generate(vertices, [&file]() { return file.read<VertexRecord>(); });
+            std::vector<Point> points;
+            std::ranges::transform(vertices, std::back_inserter(points), &VertexRecord::point);
+            const auto [sensor_id] = file.read<CellRecord>();
+            auto& cell = model.cells_.emplace_back(Geometry::Polygon{ points },
+                model.getSensor(sensor_id),
+                vertices.front().specularity,
+                model.arena_.get());
+            for (std::size_t edge = 1; edge < vertices.size(); ++edge) {
+                cell.setSpecularity(edge, vertices[edge].specularity);
+            }
+            model.cell_index_.insert(model.cells_.size() - 1, cell.getBoundingBox());
+        }
+        for (std::uint64_t i = 0; i < header.num_links; ++i) {
+            const auto [cell, other, points] = file.read<LinkRecord>();
+            model.cells_.at(cell).linkTransitionSurface(Line{ points[0], points[1] }, model.cells_.at(other));
+        }
+        for (std::uint64_t i = 0; i < header.num_emit_surfaces; ++i) {
+            const auto [cell, points, temp, duration, start_time] = file.read<EmitRecord>();
+            if (!model.cells_.at(cell).setEmitSurface(Line{ points[0], points[1] }, temp, duration, start_time)) {
+                throw std::runtime_error(std::string("Unable to add emitting surface.\n"));
+            }
+        }
+        for (std::uint64_t i = 0; i < header.num_periodic_surfaces; ++i) {
+            const auto [cell, other, points, offset] = file.read<PeriodicRecord>();
+            if (!model.cells_.at(cell).setPeriodicSurface(Line{ points[0], points[1] }, model.cells_.at(other), offset)) {
+                throw std::runtime_error(std::string("Unable to add periodic surface.\n"));
+            }
+        }
+        for (std::uint64_t i = 0; i < header.num_reflections; ++i) {
+            const auto [axis, num_sensors, num_symmetric] = file.read<ReflectionRecord>();
+            Model::Reflection reflection{ Line{ axis[0], axis[1] }, {}, {} };
+            for (std::uint64_t j = 0; j < num_sensors; ++j) {
+                const auto [removed_id, image_id] = file.read<std::array<std::uint64_t, 2>>();
+                reflection.sensors.emplace_back(removed_id, image_id);
+            }
+            for (std::uint64_t j = 0; j < num_symmetric; ++j) {
+                reflection.symmetric.push_back(file.read<std::uint64_t>());
+            }
+            model.reflections_.push_back(std::move(reflection));
+        }
+        for (std::uint64_t i = 0; i < header.num_target_sensors; ++i) {
+            model.target_sensors_.push_back(file.read<std::uint64_t>());
+        }
+        for (std::uint64_t i = 0; i < header.num_adjoint_sensors; ++i) {
+            model.adjoint_sensors_.push_back(file.read<std::uint64_t>());
+        }
+        for (std::uint64_t i = 0; i < header.num_diffusive_sensors; ++i) {
+            model.diffusive_sensors_.push_back(file.read<std::uint64_t>());
+        }
+        model.diffusive_knudsen_ = header.diffusive_knudsen;
+        model.ensemble_ = header.ensemble != 0;
+        model.target_temp_error_ = header.target_temp_error;
+        model.target_flux_error_ = header.target_flux_error;
+        model.time_budget_ = header.time_budget;
+        model.error_batches_ = header.error_batches;
+        return model;
+    } catch (const std::exception& e) { std::cerr << e.what() << '\n'; }
+    return std::nullopt;
+}
@@ -1,5 +1,6 @@
 #include "psim/outputManager.h"
 #include "psim/sensor.h"
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <execution>
@@ -13,7 +14,8 @@
 void OutputManager::exportResults(const fs::path& filepath,
     double time,
     std::size_t num_runs,
-    SimulationType type) const {
+    SimulationType type,
+    std::size_t rescues) const {
     // Declare variables to hold configuration and function pointer
     std::string appendString;
     std::string typeString;
@@ -32,7 +34,7 @@ void OutputManager::exportResults(const fs::path& filepath,
 
     std::ofstream output{ adjustPath(filepath, appendString).string(), std::ios_base::trunc };
     output << typeString << " Results from " << filepath.filename() << " @ " << getCurrentDateTime() << " - Time Taken "
-           << time << "[s] over " << num_runs << " runs\n";
+           << time << "[s] over " << num_runs << " runs - " << rescues << " stuck phonons rescued\n";
 
     exportFunc(output);
 }
@@ -52,6 +54,14 @@ std::vector<SensorMeasurements> OutputManager::calculateAverages() const {
             averagedMeasurements[i].std_x_flux += sensors[i].std_x_flux;
             averagedMeasurements[i].y_flux += sensors[i].y_flux;
             averagedMeasurements[i].std_y_flux += sensors[i].std_y_flux;
+            // The step by step results are needed by the periodic and transient exports
+            auto& final_temps = averagedMeasurements[i].final_temps;
+            auto& final_fluxes = averagedMeasurements[i].final_fluxes;
+            final_temps.resize(sensors[i].final_temps.size(), 0.);
+            final_fluxes.resize(sensors[i].final_fluxes.size(), { 0., 0. });
+            std::ranges::transform(final_temps, sensors[i].final_temps, std::begin(final_temps), std::plus{});
+            std::ranges::transform(final_fluxes, sensors[i].final_fluxes, std::begin(final_fluxes),
+                [](const auto& sum, const auto& flux) { return std::array{ sum[0] + flux[0], sum[1] + flux[1] }; });
         }
     }
 
@@ -64,6 +74,11 @@ std::vector<SensorMeasurements> OutputManager::calculateAverages() const {
         measurement.std_x_flux /= numRuns;
         measurement.y_flux /= numRuns;
         measurement.std_y_flux /= numRuns;
+        for (auto& temp : measurement.final_temps) { temp /= numRuns; }
+        for (auto& flux : measurement.final_fluxes) {
+            flux[0] /= numRuns;
+            flux[1] /= numRuns;
+        }
     }
 
     return averagedMeasurements;
@@ -3,7 +3,7 @@
 #include "psim/utils.h"
 
 Phonon::Phonon(signed char sign, double lifetime, Cell* cell)// NOLINT
-    : sign_{ sign }
+    : weight_{ static_cast<double>(sign) }
     , lifetime_{ lifetime }
     , cell_{ cell } {
 }
@@ -38,6 +38,13 @@ std::size_t Phonon::getCellSensorID() const {
     return cell_->getSensorID();
 }
 
+double Phonon::getCellImportance() const {
+    if (cell_ == nullptr) {
+        throw std::runtime_error(std::string("Cannot get the importance if the phonon it is not in a cell.\n"));
+    }
+    return cell_->getImportance();
+}
+
 std::size_t Phonon::getCellMaterialID() const {
     if (cell_ == nullptr) {
         throw std::runtime_error(std::string("Cannot get the materialID if the phonon it is not in a cell.\n"));
@@ -56,22 +63,23 @@ Phonon::RelaxRates Phonon::getRelaxRates(std::size_t step) const {
     if (cell_ == nullptr) {
         throw std::runtime_error(std::string("Cannot get the scattering rates if the phonon it is not in a cell.\n"));
     }
-    return cell_->getMaterial().relaxRates(cell_->getSteadyTemp(step), freq_, polar_);
+    const auto& material = cell_->getMaterial();
+    const auto temp = cell_->getSteadyTemp(step);
+    return material.isGray() ? material.grayRelaxRates(temp) : material.relaxRates(temp, freq_, polar_);
 }
 
-std::array<Geometry::Line, 3> Phonon::getCellBoundaryLines() const {
+const Geometry::Polygon& Phonon::getCellPolygon() const {
     if (cell_ == nullptr) {
-        throw std::runtime_error(
-            std::string("Cannot get the cell boundary lines if the phonon it is not in a cell.\n"));
+        throw std::runtime_error(std::string("Cannot get the cell polygon if the phonon it is not in a cell.\n"));
     }
-    return cell_->getBoundaryLines();
+    return cell_->getPolygon();
 }
 
-void Phonon::handleSurfaceCollision(const Geometry::Point& poi, double step_time) {
+void Phonon::handleSurfaceCollision(std::size_t boundary, const Geometry::Point& poi, double step_time) {
     if (cell_ == nullptr) {
         throw std::runtime_error(std::string("Cannot handle surface collisions if the phonon it is not in a cell.\n"));
     }
-    cell_->handleSurfaceCollision(*this, poi, step_time);
+    cell_->handleSurfaceCollision(*this, boundary, poi, step_time);
 }
 
 void Phonon::scatterUpdate() {
@@ -79,11 +87,18 @@ void Phonon::scatterUpdate() {
     cell_->scatterUpdate(*this);
 }
 
-void Phonon::updateCellHeatParams(std::size_t step) const {
+void Phonon::updateCellHeatParams(std::size_t step, double occupancy) const {
+    if (cell_ == nullptr) {
+        throw std::runtime_error(std::string("Cannot update cell heat params if the phonon is not in a cell.\n"));
+    }
+    cell_->updateHeatParams(*this, step, occupancy);
+}
+
+void Phonon::updateCellHeatSteps(std::size_t first_step, std::size_t last_step) const {
     if (cell_ == nullptr) {
         throw std::runtime_error(std::string("Cannot update cell heat params if the phonon is not in a cell.\n"));
     }
-    cell_->updateHeatParams(*this, step);
+    cell_->updateHeatSteps(*this, first_step, last_step);
 }
 
 void Phonon::setRandPoint(double r1, double r2) {// NOLINT
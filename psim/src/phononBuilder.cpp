@@ -2,28 +2,41 @@
 #include "psim/cell.h"
 #include "psim/phonon.h"
 #include "psim/utils.h"
+#include <numeric>
+
+CellOriginBuilder::CellOriginBuilder(std::span<Cell> cells,
+    std::span<const std::size_t> num_phonons,
+    std::size_t first_source) noexcept
+    : cells_{ cells }
+    , num_phonons_{ num_phonons }
+    , first_source_{ first_source } {
+    total_phonons_ = std::accumulate(std::cbegin(num_phonons_), std::cend(num_phonons_), std::size_t{ 0 });
+}
 
 Phonon CellOriginBuilder::operator()(double t_eq) noexcept {
-    auto& [cell, phonons] = cells_.top();
+    while (built_ == num_phonons_[cell_]) {
+        ++cell_;
+        built_ = 0;
+    }
+    ++built_;
+    --total_phonons_;
+    Cell* cell = &cells_[cell_];
     const signed char sign = (cell->getInitTemp() > t_eq) ? 1 : -1;
     Phonon p{ sign, 0., cell };// NOLINT
+    p.setSource(first_source_ + cell_);
     cell->initialUpdate(p);// Use the base_table_ in the cell's sensor
     const auto& [px, py] = cell->getRandPoint(Utils::urand(), Utils::urand());
     p.setPosition(px, py);
     p.setRandDirection();
-    if (--phonons == 0) { cells_.pop(); }
     return p;
 }
 
-void CellOriginBuilder::addCellPhonons(Cell* cell, std::size_t num_phonons) noexcept {
-    if (num_phonons > 0) {
-        total_phonons_ += num_phonons;
-        cells_.emplace(cell, num_phonons);
-    }
-}
-
-SurfaceOriginBuilder::SurfaceOriginBuilder(Cell& cell, const EmitSurface& surface, std::size_t num_phonons)
+SurfaceOriginBuilder::SurfaceOriginBuilder(Cell& cell,
+    const EmitSurface& surface,
+    std::size_t num_phonons,
+    std::size_t source)
     : cell_{ cell }
+    , source_{ source }
     , surface_{ surface } {
     total_phonons_ += num_phonons;
 }
@@ -32,7 +45,8 @@ Phonon SurfaceOriginBuilder::operator()(double t_eq) noexcept {
     --total_phonons_;
     const signed char sign = (surface_.getTemp() > t_eq) ? 1 : -1;
     Phonon p{ sign, surface_.getPhononTime(), &cell_ };// NOLINT
-    cell_.initialUpdate(p, surface_.getTable());// Phonon Freq, Velocity & Polarization set here
+    p.setSource(source_);
+    cell_.initialUpdate(p, surface_.getTable(), surface_.getTemp());// Phonon Freq, Velocity & Polarization set here
     const auto& [px, py] = surface_.getRandPoint(Utils::urand());// Use the surface's emitting table
     p.setPosition(px, py);
     surface_.redirectPhonon(p);// Phonon direction is set in a biased manner based on the surface orientation in space
@@ -6,6 +6,7 @@ Sensor::Sensor(std::size_t ID,// NOLINT
     std::size_t num_measurements,
     double t_init)
     : ID_{ ID }
+    , num_measurements_{ num_measurements }
     , updateMutex_{ std::make_unique<std::mutex>() } {
     switch (type) {
     case SimulationType::SteadyState:
@@ -24,8 +25,8 @@ Sensor::Sensor(std::size_t ID,// NOLINT
     inc_flux_.resize(num_measurements);
 }
 
-void Sensor::initialUpdate(Phonon& p, const Material::Table& table) const noexcept {// NOLINT
-    controller_->initialUpdate(p, table);
+void Sensor::initialUpdate(Phonon& p, const Material::Table& table, double temp) const noexcept {// NOLINT
+    controller_->initialUpdate(p, table, temp);
 }
 
 void Sensor::initialUpdate(Phonon& p) const noexcept {// NOLINT
@@ -40,15 +41,42 @@ bool Sensor::resetRequired(double t_final, std::vector<double>&& final_temps) co
     return controller_->resetRequired(t_final, std::move(final_temps));
 }
 
-void Sensor::updateHeatParams(const Phonon& p, std::size_t step) noexcept {// NOLINT
-    const auto sign = p.getSign();
+void Sensor::updateHeatParams(const Phonon& p, std::size_t step, double occupancy) noexcept {// NOLINT
+    const auto weight = p.getWeight() * occupancy;
     const auto [vx, vy] = p.getVelVector();
     std::scoped_lock lg(*updateMutex_);// NOLINT
-    inc_energy_[step] += sign;
+    inc_energy_[step] += weight;
+    ++samples_;
     // Track net velocities in each cell for flux calculations
     auto& v = inc_flux_[step];// NOLINT
-    v[0] += vx * sign;
-    v[1] += vy * sign;
+    v[0] += vx * weight;
+    v[1] += vy * weight;
+}
+
+void Sensor::updateHeatSteps(const Phonon& p, std::size_t first_step, std::size_t last_step) noexcept {
+    const auto weight = p.getWeight();
+    const auto [vx, vy] = p.getVelVector();
+    std::scoped_lock lg(*updateMutex_);// NOLINT
+    for (auto step = first_step; step < last_step; ++step) {
+        inc_energy_[step] += weight;
+        inc_flux_[step][0] += vx * weight;
+        inc_flux_[step][1] += vy * weight;
+    }
+    samples_ += last_step - first_step;
+}
+
+void Sensor::addHeatParams(std::size_t step, double energy, const std::array<double, 2>& flux) noexcept {
+    std::scoped_lock lg(*updateMutex_);// NOLINT
+    inc_energy_[step] += energy;
+    inc_flux_[step][0] += flux[0];
+    inc_flux_[step][1] += flux[1];
+}
+
+void Sensor::setTallySets(std::size_t sets) {
+    inc_energy_.assign(sets * num_measurements_, 0.);
+    inc_flux_.assign(sets * num_measurements_, { 0., 0. });
+    active_set_ = 0;
+    samples_ = 0;
 }
 
 void Sensor::reset(bool full_reset) noexcept {
@@ -56,5 +84,6 @@ void Sensor::reset(bool full_reset) noexcept {
     // Reset incoming flux values to 0.
     for (auto& flux_array : inc_flux_) { std::ranges::fill(flux_array, 0.); }
     // Reset incoming energies to 0.
-    std::ranges::fill(inc_energy_, 0);
+    std::ranges::fill(inc_energy_, 0.);
+    samples_ = 0;
 }
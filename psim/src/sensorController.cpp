@@ -25,12 +25,20 @@ double SensorController::getHeatCapacityAtFreq(std::size_t freq_index) const noe
                              : (*base_table_)[freq_index].first - (*base_table_)[freq_index - 1].first;
 }
 
-void SensorController::initialUpdate(Phonon& p, const Material::Table& table) const noexcept {// NOLINT
+void SensorController::initialUpdate(Phonon& p, const Material::Table& table, double temp) const noexcept {// NOLINT
+    if (material_.isGray()) {
+        grayUpdate(p, temp);
+        return;
+    }
     const auto& [index, polar] = Material::freqIndex(table);
     p.scatterUpdate(index, material_.getFreq(index), material_.getVel(index, polar), polar);
 }
 
 void SensorController::initialUpdate(Phonon& p) const noexcept {// NOLINT
+    if (material_.isGray()) {
+        grayUpdate(p, t_steady_);
+        return;
+    }
     const auto& [index, polar] = Material::freqIndex(*base_table_);
     p.scatterUpdate(index, material_.getFreq(index), material_.getVel(index, polar), polar);
 }
@@ -50,10 +58,18 @@ void SensorController::updateTables() {
 }
 
 void SensorController::scatterUpdate(Phonon& p) const noexcept {// NOLINT
+    if (material_.isGray()) {
+        grayUpdate(p, t_steady_);
+        return;
+    }
     const auto& [index, polar] = Material::freqIndex(*scatter_table_);
     p.scatterUpdate(index, material_.getFreq(index), material_.getVel(index, polar), polar);
 }
 
+void SensorController::grayUpdate(Phonon& p, double temp) const noexcept {// NOLINT
+    p.scatterUpdate(0, 0., material_.grayVelocity(temp), Material::Polar::LA);
+}
+
 bool SensorController::resetRequired(double t_final, [[maybe_unused]] std::vector<double>&& temps) noexcept {
     const auto t_diff = std::fabs(t_final - t_steady_);
     const bool temp_stable = t_diff / t_steady_ <= RESET_THRESHOLD;
@@ -83,6 +99,10 @@ double TransientController::getSteadyTemp(std::size_t step) const noexcept {
 
 void TransientController::scatterUpdate(Phonon& p) const noexcept {// NOLINT
     // Get the scatter at the correct measurement step
+    if (material_.isGray()) {
+        grayUpdate(p, getSteadyTemp(p.getLifeStep()));
+        return;
+    }
     const auto& [index, polar] = Material::freqIndex(*scatter_tables_[p.getLifeStep()]);
     p.scatterUpdate(index, material_.getFreq(index), material_.getVel(index, polar), polar);
 }
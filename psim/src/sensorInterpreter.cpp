@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <cmath>
 #include <execution>
+#include <numeric>
 
 namespace {
 
@@ -18,11 +19,11 @@ void SensorInterpreter::setParams(double t_eq, double eff_energy) noexcept {// N
 
 SensorMeasurements SensorInterpreter::scaleHeatParams(const Sensor& sensor) const noexcept {
     SensorMeasurements sm;// NOLINT
-    const auto& fluxes = sensor.getFluxes();
+    const auto fluxes = totalFluxes(sensor);
     const auto num_measurements = fluxes.size();
     sm.id = sensor.getID();
     sm.final_temps = findTemperature(sensor);
-    sm.final_temps.front() = sensor.getInitTemp();
+    if (!batched_) { sm.final_temps.front() = sensor.getInitTemp(); }
     sm.final_fluxes.resize(num_measurements);
     const auto f_factor = eff_energy_ / sensor.getArea();
 
@@ -32,17 +33,32 @@ SensorMeasurements SensorInterpreter::scaleHeatParams(const Sensor& sensor) cons
     });
 
     // Store steady state results in Sensor object - may want to consider moving this back to the output manager class
-    auto avgAndStdError = [](const std::vector<double>& data) {
+    // Consecutive steps of a time-stepped run share most of their phonons, so the standard error of the mean is
+    // scaled up by the integrated autocorrelation time, summed until the first lag without positive correlation.
+    // Batched measurements are independent.
+    auto avgAndStdError = [this](const std::vector<double>& data) {
         const auto size = static_cast<double>(data.size());
         const auto avg = std::reduce(std::execution::seq, std::cbegin(data), std::cend(data), 0.) / size;
-        const auto std_dev = std::sqrt(std::transform_reduce(std::execution::seq,
-                                           std::cbegin(data),
-                                           std::cend(data),
-                                           0.,
-                                           std::plus{},
-                                           [&avg](const auto& val) { return (avg - val) * (avg - val); })
-                                       / size);
-        return std::pair(avg, std_dev / std::sqrt(size));
+        auto covariance = [&](std::size_t lag) {
+            return std::transform_reduce(std::execution::seq,
+                       std::cbegin(data),
+                       std::cend(data) - static_cast<std::ptrdiff_t>(lag),
+                       std::cbegin(data) + static_cast<std::ptrdiff_t>(lag),
+                       0.,
+                       std::plus{},
+                       [&avg](const auto& lhs, const auto& rhs) { return (lhs - avg) * (rhs - avg); })
+                   / size;
+        };
+        const auto variance = covariance(0);
+        double correlation_time = 1.;
+        if (!batched_ && variance > 0.) {
+            for (std::size_t lag = 1; lag < data.size(); ++lag) {
+                const auto correlation = covariance(lag) / variance;
+                if (correlation <= 0.) { break; }
+                correlation_time += 2. * correlation;
+            }
+        }
+        return std::pair(avg, std::sqrt(variance * correlation_time / size));
     };
 
     std::vector<double> t_data;
@@ -62,6 +78,38 @@ SensorMeasurements SensorInterpreter::scaleHeatParams(const Sensor& sensor) cons
     std::tie(sm.t_steady, sm.std_t_steady) = avgAndStdError(t_data);
     std::tie(sm.x_flux, sm.std_x_flux) = avgAndStdError(fx_data);
     std::tie(sm.y_flux, sm.std_y_flux) = avgAndStdError(fy_data);
+    if (error_batches_ > 1) {
+        // Each batch holds 1 / error_batches_ of the phonons - its results are those of the whole run with a
+        // correspondingly larger phonon energy
+        const auto batches = static_cast<double>(error_batches_);
+        std::vector<std::array<double, 3>> means(error_batches_);// Temperature and fluxes of each batch
+        for (std::size_t set = 0; set < error_batches_; ++set) {
+            auto temps = toTemperatures(sensor, sensor.getEnergies(set), eff_energy_ * batches);
+            if (!batched_) { temps.front() = sensor.getInitTemp(); }
+            const auto batch_fluxes = sensor.getFluxes(set);
+            means[set][0] = std::reduce(std::cbegin(temps), std::cend(temps), 0.);
+            for (const auto& [vx, vy] : batch_fluxes) {
+                means[set][1] += vx * f_factor * batches;
+                means[set][2] += vy * f_factor * batches;
+            }
+            for (auto& mean : means[set]) { mean /= static_cast<double>(num_measurements); }
+        }
+        auto batchError = [&](std::size_t quantity) {
+            const auto avg =
+                std::transform_reduce(std::cbegin(means), std::cend(means), 0., std::plus{}, [&](const auto& mean) {
+                    return mean[quantity];
+                })
+                / batches;
+            const auto sum_sq =
+                std::transform_reduce(std::cbegin(means), std::cend(means), 0., std::plus{}, [&](const auto& mean) {
+                    return (mean[quantity] - avg) * (mean[quantity] - avg);
+                });
+            return std::sqrt(sum_sq / (batches * (batches - 1.)));
+        };
+        sm.std_t_steady = batchError(0);
+        sm.std_x_flux = batchError(1);
+        sm.std_y_flux = batchError(2);
+    }
     return sm;
 }
 
@@ -78,10 +126,36 @@ std::vector<double> SensorInterpreter::getFinalTemps(const Sensor& sensor) const
 }
 
 std::vector<double> SensorInterpreter::findTemperature(const Sensor& sensor, std::size_t start_step) const noexcept {
-    const auto& energies = sensor.getEnergies();
-    const auto start = std::cbegin(energies) + static_cast<int>(start_step);
-    const auto end = std::cend(energies);
-    std::vector<double> temps(static_cast<std::size_t>(std::distance(start, end)));
+    const auto energies = totalEnergies(sensor);
+    return toTemperatures(sensor, std::span{ energies }.subspan(start_step), eff_energy_);
+}
+
+std::vector<double> SensorInterpreter::totalEnergies(const Sensor& sensor) const noexcept {
+    const auto first = sensor.getEnergies();
+    std::vector<double> total(std::cbegin(first), std::cend(first));
+    for (std::size_t set = 1; set < error_batches_; ++set) {
+        std::ranges::transform(total, sensor.getEnergies(set), std::begin(total), std::plus{});
+    }
+    return total;
+}
+
+std::vector<std::array<double, 2>> SensorInterpreter::totalFluxes(const Sensor& sensor) const noexcept {
+    const auto first = sensor.getFluxes();
+    std::vector<std::array<double, 2>> total(std::cbegin(first), std::cend(first));
+    for (std::size_t set = 1; set < error_batches_; ++set) {
+        std::ranges::transform(total, sensor.getFluxes(set), std::begin(total), [](const auto& sum, const auto& flux) {
+            return std::array{ sum[0] + flux[0], sum[1] + flux[1] };
+        });
+    }
+    return total;
+}
+
+std::vector<double> SensorInterpreter::toTemperatures(const Sensor& sensor,
+    std::span<const double> tallies,
+    double eff_energy) const noexcept {
+    const auto start = std::cbegin(tallies);
+    const auto end = std::cend(tallies);
+    std::vector<double> temps(tallies.size());
     const auto& material = sensor.getMaterial();
     const auto area = sensor.getArea();
 
@@ -100,7 +174,7 @@ std::vector<double> SensorInterpreter::findTemperature(const Sensor& sensor, std
         std::execution::seq, start, end, std::begin(temps), [&, index = 0](const auto& energy_units) mutable {
             // Multiply the number of energy units by the phonon effective energy to get the total energy at each
             // measurement step
-            const double energy = eff_energy_ * energy_units;
+            const double energy = eff_energy * energy_units;
             if (t_eq_ != 0.) {// Do approximation to find the temperature
                 // If it is a steady-state simulation, the index will be disregarded when finding the heat capacity
                 return energy / (area * sensor.getHeatCapacity(static_cast<std::size_t>(index++))) + t_eq_;
@@ -0,0 +1,106 @@
+#include "psim/spatialIndex.h"
+#include "psim/utils.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// The bucket size is this multiple of the mean largest dimension of the inserted boxes
+constexpr double BUCKET_SCALE{ 2. };
+// Buckets are made larger if the grid over every box would have more than this many buckets per entry
+constexpr double MAX_BUCKETS_PER_ENTRY{ 4. };
+// The grid is sized again whenever the number of entries doubles from this number on
+constexpr std::size_t FIRST_REBUILD{ 16 };
+// Bucket coordinates are clamped to this magnitude so that they (and the loops over them) cannot overflow
+constexpr double MAX_BUCKET_COORD{ 1 << 30 };
+
+}// namespace
+
+void SpatialIndex::insert(std::size_t id, const BoundingBox& box) {
+    const auto& [bl, tr] = box;
+    if (boxes_.size() <= id) {
+        boxes_.resize(id + 1);
+        present_.resize(id + 1, false);
+    }
+    boxes_[id] = box;
+    if (!present_[id]) {
+        present_[id] = true;
+        ++entries_;
+    }
+    if (entries_ == 1) {
+        bounds_ = box;
+    } else {
+        auto& [bounds_bl, bounds_tr] = bounds_;
+        bounds_bl = { std::min(bounds_bl.x, bl.x), std::min(bounds_bl.y, bl.y) };
+        bounds_tr = { std::max(bounds_tr.x, tr.x), std::max(bounds_tr.y, tr.y) };
+    }
+    if (entries_ >= next_rebuild_) {
+        rebuild();
+    } else {
+        addToBuckets(id);
+    }
+}
+
+void SpatialIndex::rebuild() {
+    double total_size = 0.;
+    for (std::size_t id = 0; id < boxes_.size(); ++id) {
+        if (!present_[id]) { continue; }
+        const auto& [bl, tr] = boxes_[id];
+        total_size += std::max(tr.x - bl.x, tr.y - bl.y);
+    }
+    const auto entries = static_cast<double>(entries_);
+    const auto& [bounds_bl, bounds_tr] = bounds_;
+    const auto extent = std::max(bounds_tr.x - bounds_bl.x, bounds_tr.y - bounds_bl.y);
+    bucket_size_ = std::max(
+        { total_size / entries * BUCKET_SCALE, extent / std::sqrt(MAX_BUCKETS_PER_ENTRY * entries), GEOEPS });
+    buckets_.clear();
+    for (std::size_t id = 0; id < boxes_.size(); ++id) {
+        if (present_[id]) { addToBuckets(id); }
+    }
+    next_rebuild_ = std::max(FIRST_REBUILD, 2 * entries_);
+}
+
+void SpatialIndex::addToBuckets(std::size_t id) {
+    const auto& [bl, tr] = boxes_[id];
+    for (auto x = bucketCoord(bl.x - GEOEPS); x <= bucketCoord(tr.x + GEOEPS); ++x) {// NOLINT
+        for (auto y = bucketCoord(bl.y - GEOEPS); y <= bucketCoord(tr.y + GEOEPS); ++y) {// NOLINT
+            buckets_[bucketKey(x, y)].push_back(id);
+        }
+    }
+}
+
+std::vector<std::size_t> SpatialIndex::query(const BoundingBox& box) const {
+    std::vector<std::size_t> ids;
+    if (buckets_.empty()) { return ids; }
+    const auto& [bl, tr] = box;
+    auto touches = [&bl = bl, &tr = tr](const BoundingBox& other) {
+        const auto& [o_bl, o_tr] = other;
+        return o_bl.x <= tr.x + GEOEPS && o_tr.x >= bl.x - GEOEPS && o_bl.y <= tr.y + GEOEPS
+               && o_tr.y >= bl.y - GEOEPS;
+    };
+    // Only the buckets covering the entries can hold any, however far the query box reaches
+    const auto& [bounds_bl, bounds_tr] = bounds_;
+    const auto x_end = bucketCoord(std::min(tr.x, bounds_tr.x) + GEOEPS);
+    const auto y_end = bucketCoord(std::min(tr.y, bounds_tr.y) + GEOEPS);
+    for (auto x = bucketCoord(std::max(bl.x, bounds_bl.x) - GEOEPS); x <= x_end; ++x) {// NOLINT
+        for (auto y = bucketCoord(std::max(bl.y, bounds_bl.y) - GEOEPS); y <= y_end; ++y) {// NOLINT
+            if (const auto bucket = buckets_.find(bucketKey(x, y)); bucket != std::cend(buckets_)) {
+                std::ranges::copy_if(
+                    bucket->second, std::back_inserter(ids), [&](auto id) { return touches(boxes_[id]); });
+            }
+        }
+    }
+    std::ranges::sort(ids);
+    const auto [first, last] = std::ranges::unique(ids);
+    ids.erase(first, last);
+    return ids;
+}
+
+std::int32_t SpatialIndex::bucketCoord(double coord) const noexcept {
+    return static_cast<std::int32_t>(std::clamp(std::floor(coord / bucket_size_), -MAX_BUCKET_COORD, MAX_BUCKET_COORD));
+}
+
+std::uint64_t SpatialIndex::bucketKey(std::int32_t x, std::int32_t y) noexcept {// NOLINT
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32U)// NOLINT
+           | static_cast<std::uint32_t>(y);
+}
@@ -10,7 +10,7 @@ using Utils::urand;
 
 Surface::Surface(Line surface_line, Cell& cell, double specularity, int norm_sign)// NOLINT
     : surface_line_{ std::move(surface_line) }
-    , cell_{ cell }
+    , cell_{ &cell }
     , normal_{ surface_line_.normal(norm_sign) }
     , specularity_{ specularity } {
 }
@@ -70,10 +70,10 @@ double EmitSurface::getPhononTime() const noexcept {
 
 void TransitionSurface::handlePhonon(Phonon& p) const noexcept {// NOLINT
     // Material is the same between sensor areas
-    if (p.getCellMaterialID() == cell_.getMaterialID()) {
-        p.setCell(&cell_);
+    if (p.getCellMaterialID() == cell_->getMaterialID()) {
+        p.setCell(cell_);
     } else {// Phonon is passing from one material to another
-        const auto& material = cell_.getMaterial();
+        const auto& material = cell_->getMaterial();
         // Find maximum frequency allowable in the new material
         const auto max_freq = [&p, &material]() {
             switch (p.getPolar()) {
@@ -90,7 +90,7 @@ void TransitionSurface::handlePhonon(Phonon& p) const noexcept {// NOLINT
         /*
         auto isTransmitted = [this](const Phonon& p){
             const auto freq_index = p.getFreqIndex();
-            const auto c1 = cell_.getHeatCapacityAtFreq(freq_index);
+            const auto c1 = cell_->getHeatCapacityAtFreq(freq_index);
             const auto c2 = p.getCellHeatCapacityAtFreq(freq_index);
             return false;
         };
@@ -103,7 +103,18 @@ void TransitionSurface::handlePhonon(Phonon& p) const noexcept {// NOLINT
             // TODO: if phonon cell can pass into new material -> work to do
             // Material interface - hard part
 
-            p.setCell(&cell_);
+            p.setCell(cell_);
         }
     }
 }
+
+PeriodicSurface::PeriodicSurface(Line surface_line, Cell& cell, int norm_sign, Vector2D offset)// NOLINT
+    : Surface{ std::move(surface_line), cell, 0., norm_sign }
+    , offset_{ offset } {
+}
+
+void PeriodicSurface::handlePhonon(Phonon& p) const noexcept {// NOLINT
+    const auto [px, py] = p.getPosition();
+    p.setPosition(px + offset_.x, py + offset_.y);
+    p.setCell(cell_);
+}
@@ -143,24 +143,170 @@ class Triangle:
         )
 
 
+class Polygon:
+    """A convex polygon given by its points in order around its perimeter."""
+
+    def __init__(self, points: List[Point]):
+        self.points = points
+
+    def triangles(self) -> List[Triangle]:
+        """Fan triangulation of the polygon - used for plotting."""
+        p0 = self.points[0]
+        return [
+            Triangle(p0, self.points[i], self.points[i + 1])
+            for i in range(1, len(self.points) - 1)
+        ]
+
+    def __eq__(self, other):
+        return True if set(self.points) == set(other.points) else False
+
+    def __hash__(self):
+        return hash(frozenset(self.points))
+
+    @classmethod
+    def from_json(cls, data):
+        return Polygon(list(map(Point.from_json, data)))
+
+
+def isConvex(points: List[tuple]) -> bool:
+    """True if the points form a convex polygon when joined in order."""
+    turns = []
+    for i in range(len(points)):
+        (ax, ay), (bx, by), (cx, cy) = (
+            points[i],
+            points[(i + 1) % len(points)],
+            points[(i + 2) % len(points)],
+        )
+        turns.append((bx - ax) * (cy - by) - (by - ay) * (cx - bx))
+    return all(t > 0 for t in turns) or all(t < 0 for t in turns)
+
+
 class Cell:
-    def __init__(self, triangle: Triangle, sensorID: int, specularity: float):
-        self.triangle = triangle
+    """A cell is either a triangle or a convex polygon. Polygons are
+    serialized as a list of points under the "polygon" key."""
+
+    def __init__(self, shape, sensorID: int, specularity: float):
+        if isinstance(shape, Polygon):
+            self.polygon = shape.points
+        else:
+            self.triangle = shape
         self.sensorID = sensorID
         self.specularity = specularity
 
+    def shape(self):
+        return Polygon(self.polygon) if hasattr(self, "polygon") else self.triangle
+
+    def triangles(self) -> List[Triangle]:
+        shape = self.shape()
+        return shape.triangles() if isinstance(shape, Polygon) else [shape]
+
     def __eq__(self, other):
-        return True if self.triangle == other.triangle else False
+        return True if self.shape() == other.shape() else False
 
     def __hash__(self):
-        return hash(self.triangle)
+        return hash(self.shape())
 
     @classmethod
     def from_json(cls, data):
-        triangle = Triangle.from_json(data["triangle"])
+        if "polygon" in data:
+            shape = Polygon.from_json(data["polygon"])
+        else:
+            shape = Triangle.from_json(data["triangle"])
         sensorID = data["sensorID"]
         specularity = data["specularity"]
-        return cls(triangle, sensorID, specularity)
+        return cls(shape, sensorID, specularity)
+
+
+class GeometryTemplate:
+    """A group of cells defined once in local coordinates and placed any
+    number of times with ModelBuilder.addInstance. The sensorID of a template
+    cell is a local sensor index that each instance maps to a model sensor."""
+
+    def __init__(self, name: str):
+        self.name = name
+        self.cells = []
+
+    def addTriangleCell(
+        self, p1: tuple, p2: tuple, p3: tuple, sensor: int, specularity: float
+    ):
+        if p1 == p2 or p2 == p3 or p3 == p1:
+            raise ValueError("Cell points must all be different.")
+        self.__addCell(
+            Triangle(Point(p1[0], p1[1]), Point(p2[0], p2[1]), Point(p3[0], p3[1])),
+            sensor,
+            specularity,
+        )
+
+    def addConvexPolygonCell(
+        self, points: List[tuple], sensor: int, specularity: float
+    ):
+        if len(points) < 3 or len(set(points)) != len(points):
+            raise ValueError("A polygon needs at least 3 different points.")
+        if not isConvex(points):
+            raise ValueError("Polygon cells must be convex.")
+        self.__addCell(
+            Polygon([Point(p[0], p[1]) for p in points]), sensor, specularity
+        )
+
+    def addRectangularCell(
+        self, p1: tuple, p2: tuple, sensor: int, specularity: float
+    ):
+        self.addConvexPolygonCell(
+            [p1, (p2[0], p1[1]), p2, (p1[0], p2[1])], sensor, specularity
+        )
+
+    def numSensors(self) -> int:
+        return max((cell.sensorID for cell in self.cells), default=-1) + 1
+
+    def __addCell(self, shape, sensor: int, specularity: float):
+        if specularity > 1.0 or specularity < 0.0:
+            raise ValueError("Specularity must be in the range [0,1].")
+        if sensor < 0:
+            raise ValueError("Local sensor indices cannot be negative.")
+        self.cells.append(Cell(shape, sensor, specularity))
+
+    @classmethod
+    def from_json(cls, data):
+        geometry = cls(data["name"])
+        geometry.cells = list(map(Cell.from_json, data["cells"]))
+        return geometry
+
+
+class Instance:
+    """A template placed in the model - rotated counterclockwise by rotation
+    degrees about the template origin and then moved by offset. sensors[i] is
+    the model sensor used for the template's local sensor i."""
+
+    def __init__(self, template: str, offset: Point, rotation: float, sensors: List[int]):
+        self.template = template
+        self.offset = offset
+        self.rotation = rotation
+        self.sensors = sensors
+
+    def transform(self, point: Point) -> Point:
+        quarter_turns = round(self.rotation / 90)
+        if quarter_turns * 90 == self.rotation:  # Exact, as in the C++ code
+            c, s = [(1, 0), (0, 1), (-1, 0), (0, -1)][quarter_turns % 4]
+        else:
+            c = math.cos(math.radians(self.rotation))
+            s = math.sin(math.radians(self.rotation))
+        return Point(
+            c * point.x - s * point.y + self.offset.x,
+            s * point.x + c * point.y + self.offset.y,
+        )
+
+    def place(self, cell: Cell) -> Cell:
+        shape = cell.shape()
+        if isinstance(shape, Polygon):
+            placed = Polygon([self.transform(p) for p in shape.points])
+        else:
+            placed = Triangle(*(self.transform(p) for p in (shape.p1, shape.p2, shape.p3)))
+        return Cell(placed, self.sensors[cell.sensorID], cell.specularity)
+
+    @classmethod
+    def from_json(cls, data):
+        offset = Point.from_json(data.get("offset", {"x": 0.0, "y": 0.0}))
+        return cls(data["template"], offset, data.get("rotation", 0.0), data["sensors"])
 
 
 class EmitSurface:
@@ -184,6 +330,93 @@ class EmitSurface:
         return cls(p1, p2, data["temp"], data["duration"], data["start_time"])
 
 
+class PeriodicSurface:
+    """Pairs the boundary segment p1-p2 with its translated copy q1-q2 (p1 maps
+    to q1). Phonons leaving through one segment re-enter through the other."""
+
+    def __init__(self, p1: Point, p2: Point, q1: Point, q2: Point):
+        self.p1 = p1
+        self.p2 = p2
+        self.q1 = q1
+        self.q2 = q2
+
+    def __hash__(self):
+        return hash((self.p1, self.p2, self.q1, self.q2))
+
+    @classmethod
+    def from_json(cls, data):
+        points = [Point.from_json(data[key]) for key in ("p1", "p2", "q1", "q2")]
+        return cls(*points)
+
+
+class Domain:
+    """A polygon with optional holes that psim meshes itself, with elements of
+    roughly the given size. Elements use the fixed sensor if one is given.
+    Otherwise psim generates a sensor for each bin of an nx by ny sensor_grid
+    over the domain's bounding box (a single sensor by default).
+    """
+
+    def __init__(
+        self,
+        boundary: List[Point],
+        size: float,
+        material: str,
+        t_init: float,
+        holes: List[List[Point]] = None,
+        specularity: float = 1.0,
+        sensor: int = None,
+        sensor_grid: dict = None,
+        emit_surfaces: List[EmitSurface] = None,
+    ):
+        self.boundary = boundary
+        self.holes = holes or []
+        self.size = size
+        self.material = material
+        self.t_init = t_init
+        self.specularity = specularity
+        # Optional entries are left out of the JSON when unset
+        if sensor is not None:
+            self.sensor = sensor
+        if sensor_grid is not None:
+            self.sensor_grid = sensor_grid
+        self.emit_surfaces = emit_surfaces or []
+
+    def addSurface(
+        self,
+        p1: tuple,
+        p2: tuple,
+        temp: float,
+        duration: float = 0.0,
+        start_time: float = 0.0,
+    ):
+        """Make the boundary edges of the mesh along p1-p2 emitting surfaces."""
+        if p1 == p2:
+            raise ValueError("A surface cannot be formed from identical points.")
+        if temp < 0.0:
+            raise ValueError("Surface temperature cannot be below 0.")
+        if start_time < 0.0 or duration < 0.0:
+            raise ValueError("Start time and/or duration cannot be below 0.")
+        self.emit_surfaces.append(
+            EmitSurface(
+                Point(p1[0], p1[1]), Point(p2[0], p2[1]), temp, duration, start_time
+            )
+        )
+
+    @classmethod
+    def from_json(cls, data):
+        return cls(
+            list(map(Point.from_json, data["boundary"])),
+            data["size"],
+            data["material"],
+            data["t_init"],
+            [list(map(Point.from_json, hole)) for hole in data.get("holes", [])],
+            data.get("specularity", 1.0),
+            data.get("sensor"),
+            data.get("sensor_grid"),
+            list(map(EmitSurface.from_json, data.get("emit_surfaces", []))),
+        )
+
+
 class SimulationSettings:
     def __init__(
         self,
@@ -195,6 +428,21 @@ class SimulationSettings:
         sim_type: int,
         step_interval: int,
         phasor_sim: bool,
+        symmetry_reduction: bool = True,
+        importance_sampling: bool = False,
+        emission_bias: bool = False,
+        target_sensors: List[int] = None,
+        annihilation: bool = False,
+        kinetic: bool = False,
+        adjoint_sensors: List[int] = None,
+        diffusive_sensors: List[int] = None,
+        diffusive_knudsen: float = 0.0,
+        gray: bool = False,
+        ensemble: bool = False,
+        target_temp_error: float = 0.0,
+        target_flux_error: float = 0.0,
+        time_budget: float = 0.0,
+        error_batches: int = 0,
     ):
         self.num_runs = num_runs
         self.num_measurements = num_measurements
@@ -204,6 +452,21 @@ class SimulationSettings:
         self.sim_type = sim_type
         self.step_interval = step_interval
         self.phasor_sim = phasor_sim
+        self.symmetry_reduction = symmetry_reduction
+        self.importance_sampling = importance_sampling
+        self.emission_bias = emission_bias
+        self.target_sensors = target_sensors if target_sensors else []
+        self.annihilation = annihilation
+        self.kinetic = kinetic
+        self.adjoint_sensors = adjoint_sensors if adjoint_sensors else []
+        self.diffusive_sensors = diffusive_sensors if diffusive_sensors else []
+        self.diffusive_knudsen = diffusive_knudsen
+        self.gray = gray
+        self.ensemble = ensemble
+        self.target_temp_error = target_temp_error
+        self.target_flux_error = target_flux_error
+        self.time_budget = time_budget
+        self.error_batches = error_batches
 
     @classmethod
     def from_json(cls, data):
@@ -218,12 +481,31 @@ class Model:
         sensors: List[Sensor],
         cells: list,
         emit_surfaces: List[EmitSurface],
+        periodic_surfaces: List[PeriodicSurface] = None,
+        templates: List[GeometryTemplate] = None,
+        instances: List[Instance] = None,
+        domains: List[Domain] = None,
     ):
+        # Serialized in this order - templates, instances and domains come
+        # before the surfaces that may be placed on their cells
         self.settings = settings
         self.materials = materials
         self.sensors = sensors
         self.cells = cells
+        self.templates = templates or []
+        self.instances = instances or []
+        self.domains = domains or []
         self.emit_surfaces = emit_surfaces
+        self.periodic_surfaces = periodic_surfaces or []
+
+    def placedCells(self) -> list:
+        """The cells of the model followed by the cells of every instance.
+        Domains are only meshed by psim and are not included."""
+        templates = {t.name: t for t in self.templates}
+        placed = list(self.cells)
+        for instance in self.instances:
+            placed.extend(map(instance.place, templates[instance.template].cells))
+        return placed
 
     def toJSON(self):
         return json.dumps(self, default=lambda o: o.__dict__, indent=4)
@@ -235,7 +517,23 @@ class Model:
         sensors = list(map(Sensor.from_json, data["sensors"]))
         cells = list(map(Cell.from_json, data["cells"]))
         surfaces = list(map(EmitSurface.from_json, data["emit_surfaces"]))
-        return cls(settings, materials, sensors, cells, surfaces)
+        periodic = list(
+            map(PeriodicSurface.from_json, data.get("periodic_surfaces", []))
+        )
+        templates = list(map(GeometryTemplate.from_json, data.get("templates", [])))
+        instances = list(map(Instance.from_json, data.get("instances", [])))
+        domains = list(map(Domain.from_json, data.get("domains", [])))
+        return cls(
+            settings,
+            materials,
+            sensors,
+            cells,
+            surfaces,
+            periodic,
+            templates,
+            instances,
+            domains,
+        )
 
 
 class ModelBuilder:
@@ -252,10 +550,29 @@ class ModelBuilder:
         self.sim_type = 0
         self.step_interval = 0
         self.phasor_sim = False
+        self.symmetry_reduction = True
+        self.importance_sampling = False
+        self.emission_bias = False
+        self.target_sensors = []
+        self.annihilation = False
+        self.kinetic = False
+        self.adjoint_sensors = []
+        self.diffusive_sensors = []
+        self.diffusive_knudsen = 0.0
+        self.gray = False
+        self.ensemble = False
+        self.target_temp_error = 0.0
+        self.target_flux_error = 0.0
+        self.time_budget = 0.0
+        self.error_batches = 0
         self.materials = []
         self.sensors = []
         self.cells = []
         self.surfaces = []
+        self.periodic_surfaces = []
+        self.templates = {}
+        self.instances = []
+        self.domains = []
 
         self.__sensor_id = 0
 
@@ -268,6 +585,44 @@ class ModelBuilder:
             raise ValueError("The number of runs cannot be less than 1.")
         self.num_runs = num_runs
 
+    def setEnsemble(self, enabled: bool):
+        """Simulate all the runs at once instead of one after the other. Each
+        run records its results separately, so the output is unchanged, but
+        small models that cannot keep every core busy on their own finish
+        sooner. Uses num_runs times the memory for the sensor results. Has no
+        effect on adjoint and hybrid diffusion simulations."""
+        self.ensemble = enabled
+
+    def setAdaptiveStopping(
+        self,
+        temp_error: float = 0.0,
+        flux_error: float = 0.0,
+        time_budget: float = 0.0,
+    ):
+        """Treat the number of phonons as an upper limit. The phonons are run
+        in 20 batches, and a run stops after the batch that brings the
+        largest standard error of the sensor temperatures (fluxes) below
+        temp_error (flux_error) times the largest sensor deviation from t_eq
+        (the largest sensor heat flux), or after time_budget seconds. A value
+        of 0 disables that target. Error targets need a steady-state
+        simulation. Cannot be combined with adjoint or hybrid diffusion
+        simulations."""
+        if temp_error < 0 or flux_error < 0 or time_budget < 0:
+            raise ValueError("Error targets and time budgets cannot be negative.")
+        self.target_temp_error = temp_error
+        self.target_flux_error = flux_error
+        self.time_budget = time_budget
+
+    def setErrorBatches(self, batches: int):
+        """Split the phonons of a time-stepped steady-state run into the given
+        number of independent batches and report the standard errors from the
+        spread of the batch results, so a single run gives reliable error
+        bars. 0 or 1 -> no batches. Cannot be combined with the kinetic
+        solver, annihilation, ensemble runs or adjoint simulations."""
+        if batches < 0:
+            raise ValueError("The number of error batches cannot be negative.")
+        self.error_batches = batches
+
     def setSimType(self, sim_type: int, step_interval: int = 0):
         """Set the simulation type. Default is SteadyState simulation.
         Periodic -> use argument 1 or "Periodic"
@@ -303,6 +658,102 @@ class ModelBuilder:
             warnings.warn("STEADY_STATE simulation with phasor engaged!")
         self.phasor_sim = True
 
+    def setSymmetryReduction(self, enabled: bool):
+        """Mirror symmetric models are simulated on one half of the model by
+        default, with the results of the other half mirrored from it. Disable
+        this to simulate the whole model."""
+        self.symmetry_reduction = enabled
+
+    def setImportanceSampling(self, enabled: bool):
+        """Balance the statistical noise across the sensors. A pilot run with
+        a tenth of the phonons measures how many samples each sensor receives.
+        Phonons entering rarely visited sensors are then split into lighter
+        copies and phonons entering heavily visited sensors are randomly
+        terminated (Russian roulette). Useful when some sensors are far from
+        the emitting surfaces or behind constrictions."""
+        if enabled and self.emission_bias:
+            raise ValueError(
+                "Importance sampling cannot be combined with emission biasing."
+            )
+        self.importance_sampling = enabled
+
+    def setAnnihilation(self, enabled: bool):
+        """Advance all phonons together one measurement step at a time and
+        cancel positive and negative phonons that share a cell, polarization,
+        frequency band and direction sector at the end of each step. Cuts the
+        number of live phonons (and the run time) of near-equilibrium models.
+        Every phonon is held in memory at once."""
+        if enabled and self.kinetic:
+            raise ValueError(
+                "Annihilation cannot be combined with the kinetic solver."
+            )
+        self.annihilation = enabled
+
+    def setKinetic(self, enabled: bool):
+        """Solve steady-state simulations without time steps. Only the
+        emitted phonons are simulated and each is followed until an emitting
+        surface absorbs it, so no work is spent on the transient. Requires a
+        deviational (t_eq > 0), non phasor simulation."""
+        if enabled and self.annihilation:
+            raise ValueError(
+                "Annihilation cannot be combined with the kinetic solver."
+            )
+        self.kinetic = enabled
+
+    def setAdjointSensors(self, sensor_ids: List[int]):
+        """Only estimate the given sensors, with adjoint (backward) Monte
+        Carlo. Particles start in the sensors and are followed back in time
+        to the emitting surfaces (and, for transient simulations, the initial
+        temperatures), so the cost does not grow with the size of the rest of
+        the model. The number of phonons is shared among the sensors. Only
+        these sensors appear in the results. Requires a single material and
+        a deviational steady-state or transient simulation."""
+        self.adjoint_sensors = list(sensor_ids) if sensor_ids else []
+
+    def setGray(self, enabled: bool):
+        """Treat every material as a gray medium - all phonons share one
+        velocity and mean free path that depend only on the temperature, so
+        no frequencies are sampled. The conductivity matches the spectral
+        model, but the size effects of long mean free path phonons are lost.
+        Meant for fast design exploration."""
+        self.gray = enabled
+
+    def setHybridDiffusion(self, sensor_ids: List[int] = None, knudsen: float = 0.0):
+        """Solve the heat equation instead of running phonons in diffusive
+        sensors - the given sensors and, with knudsen > 0, every sensor whose
+        cells are all larger than the phonon mean free path divided by
+        knudsen. Monte Carlo only runs in the remaining (ballistic) sensors,
+        which exchange heat with the diffusive sensors through their shared
+        edges. Uses the kinetic solver and cannot be combined with importance
+        sampling or emission biasing. Diffusive sensors must share the
+        material of the ballistic cells they border."""
+        if knudsen < 0:
+            raise ValueError("The Knudsen number threshold cannot be negative.")
+        if (sensor_ids or knudsen > 0) and (
+            self.importance_sampling or self.emission_bias
+        ):
+            raise ValueError(
+                "Hybrid diffusion cannot be combined with importance sampling or emission biasing."
+            )
+        self.diffusive_sensors = list(sensor_ids) if sensor_ids else []
+        self.diffusive_knudsen = knudsen
+
+    def setEmissionBias(self, enabled: bool, target_sensors: List[int] = None):
+        """Reduce the noise on the sensors that matter. A pilot run with a
+        tenth of the phonons measures how much the phonons of each cell and
+        emitting surface contribute to the target sensors (every sensor if
+        none are given). Sources that contribute more then build more phonons
+        and sources that contribute less build fewer, with the phonon weights
+        compensating so the results are unbiased. The total number of phonons
+        is unchanged.
+        """
+        if enabled and self.importance_sampling:
+            raise ValueError(
+                "Emission biasing cannot be combined with importance sampling."
+            )
+        self.emission_bias = enabled
+        self.target_sensors = list(target_sensors) if enabled and target_sensors else []
+
     def setMeasurements(self, num_measurements: int):
         """Set the number of measurements to take throughout the simulation.
 
@@ -400,6 +851,29 @@ class ModelBuilder:
             )
         )
 
+    def addConvexPolygonCell(
+        self, points: List[tuple], sensorID: int, specularity: float
+    ):
+        """Add a convex polygon cell with any number of sides to the model.
+
+        The points must be given in order around the perimeter of the
+        polygon (clockwise or counterclockwise). A single polygon cell avoids
+        the internal transition surfaces created by splitting it into
+        triangles. Units are nm.
+        """
+        if specularity > 1.0 or specularity < 0.0:
+            raise ValueError("Specularity must be in the range [0,1].")
+        if len(points) < 3 or len(set(points)) != len(points):
+            raise ValueError("A polygon needs at least 3 different points.")
+        if not isConvex(points):
+            raise ValueError("Polygon cells must be convex.")
+        if sensorID > self.__sensor_id:
+            raise ValueError(f"Invalid sensorID: {sensorID}.")
+
+        self.cells.append(
+            Cell(Polygon([Point(p[0], p[1]) for p in points]), sensorID, specularity)
+        )
+
     def addRectangularCell(
         self, p1: tuple, p2: tuple, sensorID: int, specularity: float
     ):
@@ -409,8 +883,9 @@ class ModelBuilder:
         Units are nm
         """
 
-        self.addTriangleCell(p1, (p1[0], p2[1]), (p2[0], p1[1]), sensorID, specularity)
-        self.addTriangleCell(p2, (p2[0], p1[1]), (p1[0], p2[1]), sensorID, specularity)
+        self.addConvexPolygonCell(
+            [p1, (p2[0], p1[1]), p2, (p1[0], p2[1])], sensorID, specularity
+        )
 
     def addPolygonCell(
         self,
@@ -423,12 +898,16 @@ class ModelBuilder:
     ):
         """Adds a 4 sided polygon.
 
-        Two triangles are created. one from p1, p2, p3
-        & another from p2, p3, p4.
+        p1 & p4 are opposite corners, as are p2 & p3. A single cell is created
+        if the polygon is convex. Otherwise, two triangles are created. one
+        from p1, p2, p3 & another from p2, p3, p4.
         """
 
-        self.addTriangleCell(p1, p2, p3, sensorID, specularity)
-        self.addTriangleCell(p2, p3, p4, sensorID, specularity)
+        if isConvex([p1, p2, p4, p3]):
+            self.addConvexPolygonCell([p1, p2, p4, p3], sensorID, specularity)
+        else:
+            self.addTriangleCell(p1, p2, p3, sensorID, specularity)
+            self.addTriangleCell(p2, p3, p4, sensorID, specularity)
 
     def addQuadrilateralCell(
         self,
@@ -458,8 +937,7 @@ class ModelBuilder:
         )
         p4 = (p2[0] + p3[0] - p1[0], p2[1] + p3[1] - p1[1])
 
-        self.addTriangleCell(p1, p2, p3, sensorID, specularity)
-        self.addTriangleCell(p4, p2, p3, sensorID, specularity)
+        self.addConvexPolygonCell([p1, p2, p4, p3], sensorID, specularity)
 
     def addSurface(
         self,
@@ -486,6 +964,99 @@ class ModelBuilder:
             )
         )
 
+    def addTemplate(self, name: str) -> GeometryTemplate:
+        """Create a template that can be placed any number of times with
+        addInstance. Cells are added to the returned template in its local
+        coordinates, with a local sensor index instead of a sensorID.
+        """
+        if name in self.templates:
+            raise ValueError(f"Template {name} already exists.")
+        self.templates[name] = GeometryTemplate(name)
+        return self.templates[name]
+
+    def addInstance(
+        self,
+        name: str,
+        sensors: List[int],
+        offset: tuple = (0.0, 0.0),
+        rotation: float = 0.0,
+    ):
+        """Place a copy of a template, rotated counterclockwise by rotation
+        degrees about the template origin and then moved by offset. The
+        template's local sensor i is mapped to the model sensor sensors[i].
+        Rotations by multiples of 90 degrees are exact.
+        """
+        if name not in self.templates:
+            raise ValueError(f"Template {name} does not exist.")
+        if len(sensors) < self.templates[name].numSensors():
+            raise ValueError("The instance does not map every template sensor.")
+        if any(sensorID > self.__sensor_id for sensorID in sensors):
+            raise ValueError("Invalid sensorID in instance sensors.")
+        self.instances.append(
+            Instance(name, Point(offset[0], offset[1]), rotation, list(sensors))
+        )
+
+    def addDomain(
+        self,
+        boundary: List[tuple],
+        size: float,
+        material_name: str,
+        t_init: float,
+        holes: List[List[tuple]] = None,
+        specularity: float = 1.0,
+        sensorID: int = None,
+        sensor_grid: tuple = None,
+    ) -> Domain:
+        """Add a polygonal region (with optional holes) that psim meshes into
+        triangles of roughly the given edge length. The elements use sensorID
+        if given, otherwise psim generates one sensor per bin of an (nx, ny)
+        sensor_grid over the domain's bounding box. Emitting surfaces on the
+        domain boundary are added to the returned domain with addSurface.
+        Domains may share boundaries but not overlap.
+        """
+        if len(boundary) < 3 or any(len(hole) < 3 for hole in holes or []):
+            raise ValueError("Domain boundaries and holes need at least 3 points.")
+        if size <= 0.0:
+            raise ValueError("The element size must be positive.")
+        if t_init < 0:
+            raise ValueError("The initial temperature cannot be below 0.")
+        if sensorID is not None and sensorID >= self.__sensor_id:
+            raise ValueError("Invalid sensorID for domain.")
+        to_points = lambda loop: [Point(p[0], p[1]) for p in loop]
+        grid = None
+        if sensor_grid is not None:
+            grid = {"nx": sensor_grid[0], "ny": sensor_grid[1]}
+        domain = Domain(
+            to_points(boundary),
+            size,
+            material_name,
+            t_init,
+            [to_points(hole) for hole in holes or []],
+            specularity,
+            sensorID,
+            grid,
+        )
+        self.domains.append(domain)
+        return domain
+
+    def addPeriodicSurface(self, p1: tuple, p2: tuple, q1: tuple, q2: tuple):
+        """Pair the boundary segment p1-p2 with the segment q1-q2 so that a
+        single period of a periodic structure can be simulated. Phonons leaving
+        through one segment re-enter through the other at the matching point
+        (p1 maps to q1) with the same direction.
+        """
+        if p1 == p2:
+            raise ValueError("A surface cannot be formed from identical points.")
+        if not math.isclose(
+            q2[0] - q1[0], p2[0] - p1[0], abs_tol=1e-9
+        ) or not math.isclose(q2[1] - q1[1], p2[1] - p1[1], abs_tol=1e-9):
+            raise ValueError(
+                "Periodic surfaces must be translated copies of each other."
+            )
+        self.periodic_surfaces.append(
+            PeriodicSurface(*(Point(p[0], p[1]) for p in (p1, p2, q1, q2)))
+        )
+
     def __unique(self, lst: list):
         seen = set()
         return not any(i in seen or seen.add(i) for i in lst)
@@ -514,6 +1085,10 @@ class ModelBuilder:
                 if sensor.id == cell.sensorID:
                     s_id_valid = True
                     break
+            if any(sensor.id in instance.sensors for instance in self.instances):
+                s_id_valid = True
+            if any(getattr(d, "sensor", None) == sensor.id for d in self.domains):
+                s_id_valid = True
             if not s_id_valid:
                 raise ValueError("No cells are linked to Sensor {}".format(sensor.id))
 
@@ -541,6 +1116,12 @@ class ModelBuilder:
                 raise ValueError("Emit surface duration cannot exceed sim time")
             if surface.duration == 0.0:
                 surface.duration = self.sim_time
+        for domain in self.domains:
+            for surface in domain.emit_surfaces:
+                if surface.duration + surface.start_time > self.sim_time:
+                    raise ValueError("Emit surface duration cannot exceed sim time")
+                if surface.duration == 0.0:
+                    surface.duration = self.sim_time
         # Sort surfaces here to increase performance in c++ code
         self.surfaces.sort(reverse=True, key=lambda x: x.length)
 
@@ -569,8 +1150,33 @@ class ModelBuilder:
             self.sim_type,
             self.step_interval,
             self.phasor_sim,
+            self.symmetry_reduction,
+            self.importance_sampling,
+            self.emission_bias,
+            self.target_sensors,
+            self.annihilation,
+            self.kinetic,
+            self.adjoint_sensors,
+            self.diffusive_sensors,
+            self.diffusive_knudsen,
+            self.gray,
+            self.ensemble,
+            self.target_temp_error,
+            self.target_flux_error,
+            self.time_budget,
+            self.error_batches,
+        )
+        model = Model(
+            ss,
+            self.materials,
+            self.sensors,
+            self.cells,
+            self.surfaces,
+            self.periodic_surfaces,
+            list(self.templates.values()),
+            self.instances,
+            self.domains,
         )
-        model = Model(ss, self.materials, self.sensors, self.cells, self.surfaces)
 
         with open(filepath, "w", encoding="utf-8") as f:
             f.write(model.toJSON())
@@ -60,8 +60,8 @@ class ModelData:
         self.surfaces = model.emit_surfaces
         self.cell_dict = dict(zip(model.sensors,
                                   [[] for i in range(len(model.sensors))]))
-        for cell in model.cells:
-            self.cell_dict[cell.sensorID].append(cell.triangle)
+        for cell in model.placedCells():
+            self.cell_dict[cell.sensorID].extend(cell.triangles())
             
 class UpdatablePatchCollection(PatchCollection):
     def __init__(self, patches, *args, **kwargs):